@@ -0,0 +1,73 @@
+from collections import namedtuple
+
+import pytest
+
+from tcpb import terachem_server_pb2 as pb
+from tcpb.framing import HEADER_SIZE
+
+from .replay import (
+    ANSWERS_DIR,
+    group_replies,
+    job_replies,
+    read_frames,
+    read_pbmsg,
+    synthetic_job_output,
+)
+
+DEFAULT_SIZES = "3:10,30:300,100:1000"
+
+# A JobOutput to benchmark with and the server replies of a job producing it
+Case = namedtuple("Case", ["job_output", "replies"])
+
+
+def pytest_addoption(parser):
+    group = parser.getgroup("tcpb benchmarks")
+    group.addoption(
+        "--bench-sizes",
+        default=DEFAULT_SIZES,
+        help="Comma separated natom:nAO sizes of synthetic JobOutputs "
+        "(default: {})".format(DEFAULT_SIZES),
+    )
+    group.addoption(
+        "--replay-trace",
+        action="append",
+        default=[],
+        help="client_recv.bin trace recorded with TCProtobufClient(trace=True) to "
+        "replay; may be given several times",
+    )
+
+
+def pytest_generate_tests(metafunc):
+    if "case" not in metafunc.fixturenames:
+        return
+    params, ids = [], []
+    for size in metafunc.config.getoption("bench_sizes").split(","):
+        natoms, nao = (int(n) for n in size.split(":"))
+        params.append(("synthetic", (natoms, nao)))
+        ids.append("natom={}-nAO={}".format(natoms, nao))
+    for path in sorted(ANSWERS_DIR.glob("*.pbmsg")):
+        params.append(("pbmsg", path))
+        ids.append(path.stem)
+    for path in metafunc.config.getoption("replay_trace"):
+        params.append(("trace", path))
+        ids.append("trace:{}".format(path))
+    metafunc.parametrize("case", params, ids=ids, indirect=True, scope="session")
+
+
+@pytest.fixture(scope="session")
+def case(request):
+    kind, source = request.param
+    if kind == "synthetic":
+        job_output = synthetic_job_output(*source)
+        return Case(job_output, job_replies(job_output))
+    elif kind == "pbmsg":
+        job_output = read_pbmsg(source)
+        return Case(job_output, job_replies(job_output))
+
+    frames = read_frames(source)
+    outputs = [frame for msg_type, frame in frames if msg_type == pb.JOBOUTPUT]
+    if not outputs:
+        pytest.skip("No JobOutput in {}".format(source))
+    job_output = pb.JobOutput()
+    job_output.ParseFromString(outputs[-1][HEADER_SIZE:])
+    return Case(job_output, group_replies(frames))
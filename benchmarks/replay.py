@@ -0,0 +1,193 @@
+"""In-process mock TeraChem server replaying recorded or synthetic server messages
+
+The server answers every message a client sends with the next recorded reply, so the
+client code under benchmark runs against a real socket without any TeraChem compute
+time in the measurement.
+"""
+
+import socket
+import threading
+from pathlib import Path
+
+import numpy as np
+
+from tcpb import terachem_server_pb2 as pb
+from tcpb.framing import HEADER_SIZE, serialize_msg, split_msg_type, unpack_header
+
+ANSWERS_DIR = Path(__file__).parent.parent / "tests" / "answers"
+
+# (shell type, number of primitives) of the s shells of synthetic basis sets
+_S_SHELL = (1, 2)
+# Distance in bohr between neighbouring atoms of synthetic geometries
+_LATTICE_SPACING = 2.9
+
+
+def read_frames(path):
+    """Split a trace file into its messages
+
+    Args:
+        path: client_recv.bin or client_sent.bin written by TCProtobufClient(trace=True)
+
+    Returns:
+        list: (msg_type, frame) tuples, frame being the header and body bytes
+    """
+    data = Path(path).read_bytes()
+    frames = []
+    pos = 0
+    while pos < len(data):
+        msg_type, msg_size = unpack_header(data[pos : pos + HEADER_SIZE])
+        end = pos + HEADER_SIZE + msg_size
+        if end > len(data):
+            raise ValueError("Truncated message at byte {} of {}".format(pos, path))
+        msg_type, compressed = split_msg_type(msg_type)
+        if compressed:
+            # Would need the codec of the recorded connection to be decoded
+            raise ValueError("Cannot replay compressed message in {}".format(path))
+        frames.append((msg_type, data[pos:end]))
+        pos = end
+    return frames
+
+
+def group_replies(frames):
+    """Group server messages by the client message that triggered them
+
+    The server answers every client message with one Status; a completed job's
+    JobOutput follows its Status without another request.
+
+    Args:
+        frames: (msg_type, frame) tuples as returned by read_frames()
+
+    Returns:
+        list: bytes sent in answer to each client message
+    """
+    replies = []
+    for msg_type, frame in frames:
+        if msg_type == pb.STATUS or not replies:
+            replies.append(frame)
+        else:
+            replies[-1] += frame
+    return replies
+
+
+def job_replies(job_output):
+    """Replies of a server running one job: accepted, then completed with job_output"""
+    accepted = serialize_msg(pb.STATUS, pb.Status(accepted=True, server_job_id=1))
+    completed = serialize_msg(pb.STATUS, pb.Status(completed=True))
+    output = serialize_msg(pb.JOBOUTPUT, job_output)
+    return [b"".join(accepted), b"".join(completed + output)]
+
+
+def read_pbmsg(path):
+    """Read a JobOutput saved in a .pbmsg file (as in tests/answers)"""
+    job_output = pb.JobOutput()
+    job_output.ParseFromString(Path(path).read_bytes())
+    return job_output
+
+
+def synthetic_job_output(natoms, nao, seed=0):
+    """Build a gradient JobOutput of the given size with the IMD (molden) fields
+
+    Args:
+        natoms (int): Number of atoms
+        nao (int): Number of atomic (and molecular) orbitals, spread over the atoms as
+            s shells of two primitives
+        seed (int): Seed of the random values
+
+    Returns:
+        pb.JobOutput: Restricted closed shell output with energy, gradient, charges,
+        spins, dipoles, bond order, orbital energies/occupations and MO coefficients
+    """
+    rng = np.random.RandomState(seed)
+    job_output = pb.JobOutput()
+    job_output.mol.atoms.extend(["C"] * natoms)
+    # Atoms on a cubic lattice so no two are unphysically close
+    side = int(np.ceil(natoms ** (1.0 / 3.0)))
+    i_atom = np.arange(natoms)
+    lattice = np.stack([i_atom % side, i_atom // side % side, i_atom // side ** 2], 1)
+    job_output.mol.xyz.extend((_LATTICE_SPACING * lattice).ravel())
+    job_output.mol.units = pb.Mol.UnitType.BOHR
+    job_output.mol.multiplicity = 1
+    job_output.mol.closed = True
+    job_output.mol.restricted = True
+    job_output.energy.append(-37.8 * natoms)
+    job_output.gradient.extend(rng.normal(0.0, 0.01, 3 * natoms))
+    job_output.charges.extend(rng.normal(0.0, 0.1, natoms))
+    job_output.spins.extend(np.zeros(natoms))
+    job_output.dipoles.extend([0.1, 0.2, 0.3, np.sqrt(0.14)])
+    job_output.bond_order.extend(rng.uniform(0.0, 1.0, natoms * natoms))
+    job_output.job_dir = "/tmp/benchmark"
+    job_output.job_scr_dir = "/tmp/benchmark/scr"
+    job_output.server_job_id = 1
+    job_output.orb1afile = "/tmp/benchmark/scr/c0"
+    job_output.orb_size = nao
+
+    ao_atoms = np.arange(nao) * natoms // nao
+    for ao_atom in ao_atoms.tolist():
+        job_output.compressed_ao_data.extend(_S_SHELL + (ao_atom,))
+    job_output.compressed_primitive_data.extend(
+        rng.uniform(0.1, 10.0, 2 * _S_SHELL[1] * nao)
+    )
+    job_output.compressed_mo_vector.extend(rng.normal(0.0, 0.3, nao * nao))
+    job_output.orba_energies.extend(np.sort(rng.normal(0.0, 1.0, nao)))
+    job_output.orba_occupations.extend([2.0] * (nao // 2) + [0.0] * (nao - nao // 2))
+    return job_output
+
+
+class ReplayServer(object):
+    """Threaded mock TeraChem server sending canned replies
+
+    Every message received from a client is answered with the next of replies, cycling
+    through them, on every connection. Without replies, incoming messages are read and
+    discarded (for benchmarking the sending side alone).
+    """
+
+    def __init__(self, replies=None):
+        """Initialize a ReplayServer object.
+
+        Args:
+            replies: List of bytes, each one or more framed messages (see
+                group_replies() and job_replies())
+        """
+        self.replies = list(replies or [])
+        self._sock = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+        self._sock.bind(("127.0.0.1", 0))
+        self._sock.listen(8)
+        self.address = self._sock.getsockname()
+        threading.Thread(target=self._serve, daemon=True).start()
+
+    def close(self):
+        self._sock.close()
+
+    def _serve(self):
+        while True:
+            try:
+                conn, _ = self._sock.accept()
+            except OSError:
+                return
+            conn.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+            threading.Thread(target=self._handle, args=(conn,), daemon=True).start()
+
+    def _recv_into(self, conn, view):
+        nrecv = 0
+        while nrecv < len(view):
+            n = conn.recv_into(view[nrecv:])
+            if n == 0:
+                raise EOFError
+            nrecv += n
+
+    def _handle(self, conn):
+        header = bytearray(HEADER_SIZE)
+        body = bytearray()
+        i_reply = 0
+        try:
+            while True:
+                self._recv_into(conn, memoryview(header))
+                _, msg_size = unpack_header(header)
+                if msg_size > len(body):
+                    body = bytearray(msg_size)
+                self._recv_into(conn, memoryview(body)[:msg_size])
+                if self.replies:
+                    conn.sendall(self.replies[i_reply])
+                    i_reply = (i_reply + 1) % len(self.replies)
+        except (EOFError, OSError):
+            conn.close()
@@ -0,0 +1,122 @@
+"""Client-side cost of sending, receiving and converting messages
+
+Run with ``pytest benchmarks/``; pytest-benchmark reports the latency of each
+operation and, as extra info, the message size and throughput for every natom/nAO.
+"""
+
+import pytest
+from qcelemental.models import AtomicInput
+from qcelemental.models.common_models import Model
+
+from tcpb import TCProtobufClient
+from tcpb import terachem_server_pb2 as pb
+from tcpb.framing import serialize_msg
+from tcpb.molden_constructor import tcpb_imd_fields2molden_string
+from tcpb.utils import (
+    atomic_input_to_job_input,
+    job_output_to_atomic_result,
+    mol_to_molecule,
+)
+
+from .replay import ReplayServer
+
+
+def _atomic_input(job_output, **keywords):
+    return AtomicInput(
+        molecule=mol_to_molecule(job_output.mol),
+        model=Model(method="b3lyp", basis="6-31g"),
+        driver="gradient" if len(job_output.gradient) else "energy",
+        keywords=keywords,
+    )
+
+
+def _report(benchmark, job_output, nbytes):
+    """Record the size of a case and, once measured, the throughput in MB/s"""
+    benchmark.extra_info["natom"] = len(job_output.mol.atoms)
+    benchmark.extra_info["nAO"] = len(job_output.orba_energies)
+    benchmark.extra_info["bytes"] = nbytes
+    stats = getattr(benchmark, "stats", None)
+    if stats is not None:
+        benchmark.extra_info["MB/s"] = nbytes / stats.stats.mean / 1e6
+
+
+def _connect(server):
+    client = TCProtobufClient(*server.address)
+    client.connect()
+    return client
+
+
+def test_send_msg(benchmark, case):
+    job_input = atomic_input_to_job_input(_atomic_input(case.job_output))
+    server = ReplayServer()
+    client = _connect(server)
+    try:
+        benchmark(client._send_msg, pb.JOBINPUT, job_input)
+    finally:
+        client.disconnect()
+        server.close()
+    _report(benchmark, case.job_output, job_input.ByteSize())
+
+
+def test_recv_msg(benchmark, case):
+    server = ReplayServer([b"".join(serialize_msg(pb.JOBOUTPUT, case.job_output))])
+    client = _connect(server)
+    try:
+        # Each round requests one JobOutput; only receiving and parsing it is timed
+        benchmark.pedantic(
+            client._recv_msg,
+            args=(pb.JOBOUTPUT,),
+            setup=lambda: client._send_msg(pb.STATUS, pb.Status()),
+            rounds=100,
+        )
+    finally:
+        client.disconnect()
+        server.close()
+    _report(benchmark, case.job_output, case.job_output.ByteSize())
+
+
+def test_recv_job_async(benchmark, case):
+    server = ReplayServer([b"".join(serialize_msg(pb.JOBOUTPUT, case.job_output))])
+    client = _connect(server)
+    try:
+        benchmark.pedantic(
+            client.recv_job_async,
+            setup=lambda: client._send_msg(pb.STATUS, pb.Status()),
+            rounds=100,
+        )
+    finally:
+        client.disconnect()
+        server.close()
+    _report(benchmark, case.job_output, case.job_output.ByteSize())
+
+
+@pytest.mark.parametrize("raw_arrays", [False, True], ids=["lists", "raw_arrays"])
+def test_job_output_to_atomic_result(benchmark, case, raw_arrays):
+    atomic_input = _atomic_input(case.job_output)
+    benchmark(
+        job_output_to_atomic_result,
+        atomic_input=atomic_input,
+        job_output=case.job_output,
+        raw_arrays=raw_arrays,
+    )
+    _report(benchmark, case.job_output, case.job_output.ByteSize())
+
+
+def test_molden_string(benchmark, case):
+    if not len(case.job_output.compressed_ao_data):
+        pytest.skip("JobOutput has no IMD fields")
+    molden = benchmark(tcpb_imd_fields2molden_string, case.job_output)
+    _report(benchmark, case.job_output, len(molden))
+
+
+def test_compute(benchmark, case):
+    """Whole compute() round trip against a server answering instantly"""
+    atomic_input = _atomic_input(case.job_output)
+    server = ReplayServer(case.replies)
+    client = _connect(server)
+    try:
+        benchmark(client.compute, atomic_input)
+    finally:
+        client.disconnect()
+        server.close()
+    _report(benchmark, case.job_output, case.job_output.ByteSize())
@@ -0,0 +1,38 @@
+#!/usr/bin/env python
+# Run energies on several TeraChem servers concurrently from one event loop
+import asyncio
+import sys
+
+from qcelemental.models import AtomicInput, Molecule
+
+from tcpb import AsyncTCProtobufClient
+
+if len(sys.argv) < 3 or len(sys.argv) % 2 != 1:
+    print("Usage: {} host port [host port ...]".format(sys.argv[0]))
+    exit(1)
+
+endpoints = list(zip(sys.argv[1::2], map(int, sys.argv[2::2])))
+
+# Water system
+atoms = ["O", "H", "H"]
+geom = [0.0, 0.0, 0.0, 0.0, 1.5, 0.0, 0.0, 0.0, 1.5]  # in bohr
+
+
+async def run(host, port):
+    atomic_input = AtomicInput(
+        molecule=Molecule(symbols=atoms, geometry=geom),
+        model={"method": "pbe0", "basis": "6-31g"},
+        driver="energy",
+        keywords={"closed_shell": True, "restricted": True},
+    )
+    async with AsyncTCProtobufClient(host, port) as TC:
+        return await TC.compute(atomic_input)
+
+
+async def main():
+    results = await asyncio.gather(*(run(host, port) for host, port in endpoints))
+    for (host, port), result in zip(endpoints, results):
+        print(f"{host}:{port}", result.return_result)
+
+
+asyncio.run(main())
@@ -0,0 +1,45 @@
+#!/usr/bin/env python
+# Collect energies and gradients of many geometries into a memory mapped dataset
+import sys
+
+import numpy as np
+from qcelemental.models import AtomicInput, Molecule
+
+from tcpb import TCPBPool
+from tcpb.dataset import ResultDataset, ResultSink
+
+if len(sys.argv) < 4 or len(sys.argv) % 2 != 0:
+    print("Usage: {} dataset-dir host port [host port ...]".format(sys.argv[0]))
+    exit(1)
+
+path = sys.argv[1]
+endpoints = list(zip(sys.argv[2::2], map(int, sys.argv[3::2])))
+
+# Water system with random displacements (in bohr)
+rng = np.random.default_rng(0)
+reference = np.array([0.0, 0.0, 0.0, 0.0, 1.8, 0.0, 0.0, 0.0, 1.8])
+inputs = [
+    AtomicInput(
+        molecule=Molecule(
+            symbols=["O", "H", "H"],
+            geometry=reference + rng.normal(scale=0.05, size=9),
+        ),
+        model={"method": "pbe0", "basis": "6-31g"},
+        driver="gradient",
+        keywords={"closed_shell": True, "restricted": True},
+    )
+    for _ in range(100)
+]
+
+with TCPBPool(endpoints) as pool, ResultSink(
+    path, fields=("energy", "gradient"), chunk_rows=32
+) as sink:
+    for key, atomic_input in enumerate(inputs):
+        sink.submit(pool, atomic_input, key=key)
+print("Failed jobs:", [key for key, _ in sink.errors])
+
+dataset = ResultDataset(path)
+order = np.argsort(dataset.keys())
+energies = dataset.stack("energy")[order, 0]
+gradients = dataset.stack("gradient")[order].reshape(-1, 3, 3)
+print(energies.shape, gradients.shape)
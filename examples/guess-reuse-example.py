@@ -54,3 +54,7 @@ with TCProtobufClient(host=sys.argv[1], port=int(sys.argv[2])) as TC:
     results = TC.compute_job_sync(
         "gradient", geom, "angstrom", guess=orb_paths, **tc_opts
     )
+
+# For QCSchema inputs, TCProtobufClient(host, port, guess_cache=True) does this
+# automatically: every compute() call starts from the orbitals of the nearest
+# previous geometry of the same system
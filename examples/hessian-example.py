@@ -0,0 +1,32 @@
+#!/usr/bin/env python
+# Hessian and harmonic frequencies of water from gradients run across several servers
+import sys
+
+from qcelemental.models import AtomicInput, Molecule
+
+from tcpb import TCPBPool
+
+if len(sys.argv) < 3 or len(sys.argv) % 2 != 1:
+    print("Usage: {} host port [host port ...]".format(sys.argv[0]))
+    exit(1)
+
+endpoints = list(zip(sys.argv[1::2], map(int, sys.argv[2::2])))
+
+# Water near its equilibrium geometry (in bohr)
+atomic_input = AtomicInput(
+    molecule=Molecule(
+        symbols=["O", "H", "H"],
+        geometry=[0.0, 0.0, 0.0, 0.0, 1.43, 1.11, 0.0, -1.43, 1.11],
+    ),
+    model={"method": "b3lyp", "basis": "6-31g*"},
+    driver="hessian",
+    keywords={"closed_shell": True, "restricted": True},
+)
+
+with TCPBPool(endpoints) as pool:
+    result = pool.compute(atomic_input)
+
+print("Hessian from {}".format(result.extras["hessian"]["source"]))
+print(result.return_result)
+# The lowest six frequencies are translations and rotations
+print("Frequencies (cm^-1):", result.extras["hessian"]["frequencies"][6:])
@@ -0,0 +1,34 @@
+#!/usr/bin/env python
+# CIS gradient of water whose energies are used before the rest of the job is done
+import sys
+
+from qcelemental.models import AtomicInput, Molecule
+
+from tcpb import TCProtobufClient as TCPBClient
+
+if len(sys.argv) != 3:
+    print("Usage: {} host port".format(sys.argv[0]))
+    exit(1)
+
+# Water near its equilibrium geometry (in bohr)
+atomic_input = AtomicInput(
+    molecule=Molecule(
+        symbols=["O", "H", "H"],
+        geometry=[0.0, 0.0, 0.0, 0.0, 1.43, 1.11, 0.0, -1.43, 1.11],
+    ),
+    model={"method": "b3lyp", "basis": "6-31g*"},
+    driver="gradient",
+    keywords={"cis": "yes", "cisnumstates": 8, "cistarget": 1},
+)
+
+with TCPBClient(host=sys.argv[1], port=int(sys.argv[2])) as TC:
+    results = TC.compute_partial(atomic_input)
+    for frame in results:
+        # Energies and gradients arrive before transition dipoles and CI vectors
+        if frame.holds("energy"):
+            print("Energies:", frame.value("energy"))
+        if frame.holds("gradient"):
+            print("Gradient:", frame.value("gradient").reshape(-1, 3))
+    result = results.result()
+
+print("Transition dipoles:", result.extras["qcvars"].get("cis_transition_dipoles"))
@@ -0,0 +1,33 @@
+#!/usr/bin/env python
+# Spread energy calculations over several TeraChem servers
+import sys
+
+from qcelemental.models import AtomicInput, Molecule
+
+from tcpb import TCPBPool
+
+if len(sys.argv) < 3 or len(sys.argv) % 2 != 1:
+    print("Usage: {} host port [host port ...]".format(sys.argv[0]))
+    exit(1)
+
+endpoints = list(zip(sys.argv[1::2], map(int, sys.argv[2::2])))
+
+# Water system with a range of bond lengths (in bohr)
+atoms = ["O", "H", "H"]
+inputs = [
+    AtomicInput(
+        molecule=Molecule(
+            symbols=atoms, geometry=[0.0, 0.0, 0.0, 0.0, r, 0.0, 0.0, 0.0, r]
+        ),
+        model={"method": "pbe0", "basis": "6-31g"},
+        driver="energy",
+        keywords={"closed_shell": True, "restricted": True},
+    )
+    for r in (1.6, 1.7, 1.8, 1.9, 2.0)
+]
+
+with TCPBPool(endpoints) as pool:
+    futures = [pool.submit(atomic_input) for atomic_input in inputs]
+    for future in futures:
+        print(future.result().return_result)
+    print(pool.server_states())
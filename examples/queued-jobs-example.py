@@ -0,0 +1,30 @@
+#!/usr/bin/env python
+# Keep several jobs outstanding on one TeraChem server and collect them as they finish
+import sys
+
+from qcelemental.models import AtomicInput, Molecule
+
+from tcpb import TCProtobufClient as TCPBClient
+
+if len(sys.argv) != 3:
+    print("Usage: {} host port".format(sys.argv[0]))
+    exit(1)
+
+# Water system with a range of bond lengths (in bohr)
+atoms = ["O", "H", "H"]
+inputs = [
+    AtomicInput(
+        molecule=Molecule(
+            symbols=atoms, geometry=[0.0, 0.0, 0.0, 0.0, r, 0.0, 0.0, 0.0, r]
+        ),
+        model={"method": "pbe0", "basis": "6-31g"},
+        driver="energy",
+        keywords={"closed_shell": True, "restricted": True},
+    )
+    for r in (1.6, 1.7, 1.8, 1.9, 2.0)
+]
+
+with TCPBClient(host=sys.argv[1], port=int(sys.argv[2])) as TC:
+    handles = [TC.submit_job(atomic_input) for atomic_input in inputs]
+    for handle in TC.as_completed(handles):
+        print(handle.server_job_id, handle.result().return_result)
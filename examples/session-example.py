@@ -0,0 +1,31 @@
+#!/usr/bin/env python
+# Gradients along a trajectory, sending only the new coordinates with every step
+import sys
+
+import numpy as np
+from qcelemental.models import AtomicInput, Molecule
+
+from tcpb import TCProtobufClient as TCPBClient
+
+if len(sys.argv) != 3:
+    print("Usage: {} host port".format(sys.argv[0]))
+    exit(1)
+
+# Water system
+atoms = ["O", "H", "H"]
+geom = np.array([0.0, 0.0, 0.0, 0.0, 1.5, 0.0, 0.0, 0.0, 1.5])  # in bohr
+
+atomic_input = AtomicInput(
+    molecule=Molecule(symbols=atoms, geometry=geom),
+    model={"method": "pbe0", "basis": "6-31g"},
+    driver="gradient",
+    keywords={"closed_shell": True, "restricted": True},
+)
+
+with TCPBClient(host=sys.argv[1], port=int(sys.argv[2])) as TC:
+    session = TC.session(atomic_input)
+    # Crude steepest descent; every job starts from the previous job's orbitals
+    for step in range(5):
+        gradient = session.gradient(geom)
+        print(step, session.last_output.energy[0], np.abs(gradient).max())
+        geom = geom - 0.5 * gradient.ravel()
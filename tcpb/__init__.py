@@ -1,5 +1,7 @@
 """Protobuf client for TeraChem server mode"""
 
+from .aio import AsyncTCProtobufClient  # noqa
+from .pool import TCPBPool  # noqa
 from .tcpb import TCProtobufClient  # noqa
 
 __version__ = "0.7.2"
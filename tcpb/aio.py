@@ -0,0 +1,324 @@
+"""asyncio client for communicating with TeraChem Protocol Buffer servers
+
+Speaks the same 8 byte header protocol as TCProtobufClient (see tcpb.framing), but
+all socket I/O goes through asyncio streams so a single event loop can drive many
+servers at once without a thread per connection.
+"""
+
+import asyncio
+import logging
+
+from qcelemental.models import AtomicInput, AtomicResult
+
+from . import terachem_server_pb2 as pb
+from .exceptions import ServerError, TCPBError
+from .framing import (
+    HEADER_SIZE,
+    decompress_body,
+    parse_msg,
+    serialize_msg,
+    split_msg_type,
+    supported_compression,
+    unpack_header,
+)
+from .tcpb import TCProtobufClient, poll_intervals
+from .utils import (
+    atomic_input_to_job_input,
+    job_output_to_atomic_result,
+    job_output_to_results_dict,
+)
+
+logger = logging.getLogger(__name__)
+
+
+class AsyncTCProtobufClient(object):
+    """Connect and communicate with a TeraChem instance running in Protocol Buffer server mode
+    from an asyncio event loop
+
+    >>> async with AsyncTCProtobufClient(host, port) as TC:
+    >>>     result = await TC.compute(atomic_input)
+
+    A server runs one job at a time per connection, so calls on the same client are
+    serialized; use one client per server to run jobs concurrently.
+    """
+
+    def __init__(
+        self,
+        host,
+        port,
+        timeout=60.0,
+        poll_interval=1e-4,
+        max_poll_interval=0.5,
+        poll_backoff=2.0,
+        compression=False,
+    ):
+        """Initialize an AsyncTCProtobufClient object.
+
+        Args:
+            host (str): Hostname
+            port (int): Port number (must be above 1023)
+            timeout (float): Seconds to wait on connecting or on a single message before giving up
+            poll_interval (float): Initial delay in seconds between job status checks or resubmissions
+            max_poll_interval (float): Upper bound in seconds on the delay between polls
+            poll_backoff (float): Factor the delay grows by after every unsuccessful poll
+            compression: If True or a list of codec names ("zstd", "lz4", "zlib"), offer
+                the server to compress large messages on connect (see tcpb.framing)
+        """
+        if not isinstance(host, str):
+            raise TypeError("Hostname must be a string")
+        if not isinstance(port, int):
+            raise TypeError("Port number must be an integer")
+        if port < 1023:
+            raise ValueError(
+                "Port number is not allowed to below 1023 (system reserved ports)"
+            )
+        self.tcaddr = (host, port)
+        self.timeout = timeout
+        self.poll_interval = poll_interval
+        self.max_poll_interval = max_poll_interval
+        self.poll_backoff = poll_backoff
+        self.compression = supported_compression(compression) if compression else []
+        self.wire_compression = pb.Status.NO_COMPRESSION
+
+        self.reader = None
+        self.writer = None
+        self._lock = None
+
+        self.curr_job_dir = None
+        self.curr_job_scr_dir = None
+        self.curr_job_id = None
+
+    async def __aenter__(self):
+        await self.connect()
+        return self
+
+    async def __aexit__(self, type, value, traceback):
+        await self.disconnect()
+
+    async def connect(self):
+        """Connect to the TeraChem Protobuf server"""
+        try:
+            self.reader, self.writer = await asyncio.wait_for(
+                asyncio.open_connection(*self.tcaddr), self.timeout
+            )
+        except (OSError, asyncio.TimeoutError) as msg:
+            raise ServerError("Problem connecting to server: {}".format(msg), self)
+        # Created here so the lock belongs to the running event loop
+        self._lock = asyncio.Lock()
+
+        self.wire_compression = pb.Status.NO_COMPRESSION
+        if self.compression:
+            offer = pb.Status(accept_compression=self.compression)
+            await self._send_msg(pb.STATUS, offer)
+            status = await self._recv_msg(pb.STATUS)
+            if status.compression in self.compression:
+                self.wire_compression = status.compression
+
+    async def disconnect(self):
+        """Disconnect from the TeraChem Protobuf server"""
+        if self.writer is None:
+            return
+        try:
+            self.writer.close()
+            await self.writer.wait_closed()
+        except OSError:
+            logger.error(
+                f"Problem communicating with server: {self.tcaddr}. Disconnect assumed to have happened"
+            )
+        self.reader = None
+        self.writer = None
+
+    def _connection_lock(self):
+        """Lock serializing the calls on the connection
+
+        Raises:
+            TCPBError: The client is not connected
+        """
+        if self.writer is None:
+            raise TCPBError(
+                "Not connected to TeraChem server {}; call connect() or use the client "
+                "in an async with block".format(self.tcaddr)
+            )
+        return self._lock
+
+    async def is_available(self):
+        """Asks the TeraChem Protobuf server whether it is available or busy through the Status protobuf message.
+        Note that this does not reserve the server, and the status could change after this function is called.
+
+        Returns:
+            bool: True if the TeraChem PB server is currently available (no running job)
+        """
+        async with self._connection_lock():
+            await self._send_msg(pb.STATUS, None)
+            status = await self._recv_msg(pb.STATUS)
+        return not status.busy
+
+    async def compute(
+        self, atomic_input: AtomicInput, raw_arrays: bool = False
+    ) -> AtomicResult:
+        """Top level method for performing computations with QCSchema inputs/outputs
+
+        Args:
+            atomic_input: Input of the computation
+            raw_arrays: If True, array results are returned as NumPy arrays (see
+                utils.job_output_to_atomic_result)
+        """
+        job_input_msg = atomic_input_to_job_input(atomic_input)
+        job_output = await self.compute_job_input(job_input_msg)
+        return job_output_to_atomic_result(
+            atomic_input=atomic_input, job_output=job_output, raw_arrays=raw_arrays
+        )
+
+    async def compute_job(self, jobType="energy", geom=None, unitType="bohr", **kwargs):
+        """Submit a job, wait for it to complete and return its results.
+        Asynchronous counterpart of TCProtobufClient.compute_job_sync().
+
+        Args:
+            jobType:    Job type key, as defined in the pb.JobInput.RunType enum (defaults to 'energy')
+            geom:       Cartesian geometry of the new point
+            unitType:   Unit type key, as defined in the pb.Mol.UnitType enum (defaults to 'bohr')
+            **kwargs:   Additional TeraChem keywords, check TCProtobufClient._process_kwargs for behaviour
+
+        Returns:
+            dict: Results mirroring TCProtobufClient.recv_job_async
+        """
+        geom = TCProtobufClient._validate_job_args(jobType, geom, unitType)
+        job_input_msg = TCProtobufClient._create_job_input_msg(
+            jobType, geom, unitType, **kwargs
+        )
+        job_output = await self.compute_job_input(job_input_msg)
+        return job_output_to_results_dict(job_output)
+
+    async def compute_job_input(self, job_input_msg):
+        """Submit a JobInput (retrying until accepted), wait for completion and return the JobOutput
+
+        Args:
+            job_input_msg: JobInput protobuf message
+
+        Returns:
+            pb.JobOutput: Output of the job
+        """
+        async with self._connection_lock():
+            intervals = self._poll_intervals()
+            while not await self._send_job_input(job_input_msg):
+                logger.info("JobInput not accepted. Retrying...")
+                await asyncio.sleep(next(intervals))
+
+            for interval in self._poll_intervals():
+                if await self._check_job_complete():
+                    break
+                await asyncio.sleep(interval)
+
+            job_output = await self._recv_msg(pb.JOBOUTPUT)
+            self.curr_job_dir = None
+            self.curr_job_scr_dir = None
+            self.curr_job_id = None
+            return job_output
+
+    def _poll_intervals(self):
+        """Delays between polls using this client's polling settings"""
+        return poll_intervals(
+            self.poll_interval, self.max_poll_interval, self.poll_backoff
+        )
+
+    async def _send_job_input(self, job_input_msg):
+        """Send a JobInput and return True if the server accepted it"""
+        await self._send_msg(pb.JOBINPUT, job_input_msg)
+        status_msg = await self._recv_msg(pb.STATUS)
+        if status_msg.WhichOneof("job_status") == "accepted":
+            self.curr_job_dir = status_msg.job_dir
+            self.curr_job_scr_dir = status_msg.job_scr_dir
+            self.curr_job_id = status_msg.server_job_id
+            return True
+        return False
+
+    async def _check_job_complete(self):
+        """Send a Status message and return True if the submitted job is completed"""
+        await self._send_msg(pb.STATUS, None)
+        status = await self._recv_msg(pb.STATUS)
+
+        if status.WhichOneof("job_status") == "completed":
+            return True
+        elif status.WhichOneof("job_status") in ("working", "queued"):
+            # Queued behind other jobs on servers that queue them
+            return False
+        else:
+            raise ServerError(
+                "Invalid or no job status received, either no job submitted before check_job_complete() or major server issue",
+                self,
+            )
+
+    # Private send/recv functions
+    async def _send_msg(self, msg_type, msg_pb=None):
+        """Sends a header + PB to the TeraChem Protobuf server (must be connected)
+
+        Args:
+            msg_type: Message type (defined as enum in protocol buffer)
+            msg_pb: Protocol Buffer to send to the TCPB server
+        """
+        header, msg_str = serialize_msg(msg_type, msg_pb, self.wire_compression)
+        try:
+            self.writer.write(header)
+            if msg_str:
+                self.writer.write(msg_str)
+            await asyncio.wait_for(self.writer.drain(), self.timeout)
+        except (OSError, asyncio.TimeoutError) as msg:
+            raise ServerError("Could not send message: {}".format(msg), self)
+
+    async def _recv_exactly(self, nbytes, what):
+        """Read exactly nbytes from the server, raising ServerError on failure"""
+        try:
+            return await asyncio.wait_for(
+                self.reader.readexactly(nbytes), self.timeout
+            )
+        except asyncio.IncompleteReadError as e:
+            if not e.partial:
+                raise ServerError(
+                    "Could not recv {} because socket was closed from server".format(
+                        what
+                    ),
+                    self,
+                )
+            raise ServerError(
+                "Recv'd {} of {} expected bytes for {}".format(
+                    len(e.partial), nbytes, what
+                ),
+                self,
+            )
+        except (OSError, asyncio.TimeoutError) as msg:
+            raise ServerError("Could not recv {}: {}".format(what, msg), self)
+
+    async def _recv_msg(self, msg_type):
+        """Receives a header + PB from the TeraChem Protobuf server (must be connected)
+
+        Args:
+            msg_type: Expected message type (defined as enum in protocol buffer)
+
+        Returns:
+            protobuf: Protocol Buffer of type msg_type
+        """
+        header = await self._recv_exactly(HEADER_SIZE, "header")
+        recv_type, msg_size = unpack_header(header)
+        recv_type, compressed = split_msg_type(recv_type)
+
+        if recv_type != msg_type:
+            raise ServerError(
+                "Received header for incorrect packet type (expecting {} and got {})".format(
+                    msg_type, recv_type
+                ),
+                self,
+            )
+
+        msg_str = await self._recv_exactly(msg_size, "protobuf")
+        if compressed:
+            try:
+                msg_str = decompress_body(msg_str, self.wire_compression)
+            except ValueError as e:
+                raise ServerError(str(e), self)
+
+        try:
+            return parse_msg(msg_type, msg_str)
+        except KeyError:
+            raise ServerError(
+                "Unknown message type {} for received message.".format(msg_type), self
+            )
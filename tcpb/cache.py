@@ -0,0 +1,128 @@
+"""Persistent cache of job results keyed by their JobInput
+
+Optimizers and workflow engines frequently resubmit the exact same computation
+(line search restarts, shared NEB endpoints, ...). ResultCache stores the serialized
+JobOutput of every finished job in a directory, in the same .pbmsg format as
+tests/answers, under a hash of the canonical JobInput, so repeated inputs are
+answered from disk without running TeraChem again.
+"""
+
+import hashlib
+import os
+import tempfile
+import threading
+
+from . import terachem_server_pb2 as pb
+
+PBMSG_SUFFIX = ".pbmsg"
+
+
+class ResultCache(object):
+    """Directory of JobOutputs keyed by a hash of the JobInput that produced them
+
+    Two JobInputs share an entry when they are identical up to the order of their
+    user options, and, if geometry_decimals is set, up to their geometries rounded to
+    that many decimals. Entries are written atomically, so several clients or
+    processes may share a directory.
+    """
+
+    def __init__(self, directory, geometry_decimals=None):
+        """Initialize a ResultCache object.
+
+        Args:
+            directory: Directory holding the cached JobOutputs; created if missing
+            geometry_decimals (int): If set, geometries are rounded to this many
+                decimals before hashing so nearly identical inputs share results
+        """
+        self.directory = os.fspath(directory)
+        self.geometry_decimals = geometry_decimals
+        self.hits = 0
+        self.misses = 0
+        self._lock = threading.Lock()
+        os.makedirs(self.directory, exist_ok=True)
+
+    def key(self, job_input):
+        """Hash identifying a JobInput in the cache
+
+        Args:
+            job_input: JobInput protobuf message
+
+        Returns:
+            str: Hex digest of the canonical serialized JobInput
+        """
+        canonical = pb.JobInput()
+        canonical.CopyFrom(job_input)
+
+        options = list(job_input.user_options)
+        del canonical.user_options[:]
+        for key, value in sorted(zip(options[::2], options[1::2])):
+            canonical.user_options.extend([key, value])
+
+        if self.geometry_decimals is not None:
+            for xyz in (canonical.mol.xyz, canonical.xyz2):
+                # + 0.0 folds -0.0 into 0.0 so they hash the same
+                rounded = [round(x, self.geometry_decimals) + 0.0 for x in xyz]
+                del xyz[:]
+                xyz.extend(rounded)
+
+        msg_str = canonical.SerializeToString(deterministic=True)
+        return hashlib.sha256(msg_str).hexdigest()
+
+    def _path(self, key):
+        return os.path.join(self.directory, key + PBMSG_SUFFIX)
+
+    def get(self, job_input):
+        """Look up the JobOutput of a previous job with the same input
+
+        Args:
+            job_input: JobInput protobuf message
+
+        Returns:
+            pb.JobOutput: Cached output, or None on a miss
+        """
+        try:
+            with open(self._path(self.key(job_input)), "rb") as f:
+                msg_str = f.read()
+        except FileNotFoundError:
+            with self._lock:
+                self.misses += 1
+            return None
+
+        job_output = pb.JobOutput()
+        job_output.ParseFromString(msg_str)
+        with self._lock:
+            self.hits += 1
+        return job_output
+
+    def put(self, job_input, job_output):
+        """Store the JobOutput of a finished job
+
+        Args:
+            job_input: JobInput protobuf message the job was submitted with
+            job_output: JobOutput protobuf message of the job
+        """
+        path = self._path(self.key(job_input))
+        fd, tmp_path = tempfile.mkstemp(
+            dir=self.directory, suffix=PBMSG_SUFFIX + ".tmp"
+        )
+        try:
+            with os.fdopen(fd, "wb") as f:
+                f.write(job_output.SerializeToString())
+            os.replace(tmp_path, path)
+        except BaseException:
+            os.unlink(tmp_path)
+            raise
+
+    def __len__(self):
+        return sum(
+            1 for name in os.listdir(self.directory) if name.endswith(PBMSG_SUFFIX)
+        )
+
+    def clear(self):
+        """Remove every cached JobOutput and reset the hit/miss counters"""
+        for name in os.listdir(self.directory):
+            if name.endswith(PBMSG_SUFFIX):
+                os.unlink(os.path.join(self.directory, name))
+        with self._lock:
+            self.hits = 0
+            self.misses = 0
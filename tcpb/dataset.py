@@ -0,0 +1,315 @@
+"""Columnar storage of the results of many jobs
+
+Collecting training data through AtomicResults converts every array of every
+JobOutput to Python lists and back. A ResultSink instead appends the repeated fields
+of JobOutputs straight into growable NumPy buffers, one column per field, and writes
+them out every chunk_rows jobs as a chunk of .npy files:
+
+    path/dataset.json                  Fields, dtypes and rows of each chunk
+    path/chunk-000000/keys.npy         Key of each row (job)
+    path/chunk-000000/energy.npy       Values of all rows, concatenated
+    path/chunk-000000/energy.offsets.npy  Row i is values[offsets[i]:offsets[i + 1]]
+
+Like Arrow list columns, rows may hold different numbers of values (an empty row
+for a field a job did not return). ResultDataset reads the chunks back as memory
+mapped arrays, so a dataset larger than memory can feed training directly.
+"""
+
+import json
+import os
+import threading
+
+import numpy as np
+
+from . import terachem_server_pb2 as pb
+from .utils import JobOutputArrays, atomic_input_to_job_input
+
+# JobOutput fields stored by default
+DEFAULT_FIELDS = ("energy", "gradient", "charges", "dipoles", "orba_energies")
+
+# Jobs per chunk
+DEFAULT_CHUNK_ROWS = 4096
+
+METADATA_FILE = "dataset.json"
+KEYS = "keys"
+
+
+def _chunk_dir(index):
+    return "chunk-{:06d}".format(index)
+
+
+class _Column(object):
+    """Growable buffer of the values of one field and the offsets of its rows"""
+
+    def __init__(self, dtype, chunk_rows):
+        self.dtype = np.dtype(dtype)
+        self.values = np.empty(0, self.dtype)
+        self.offsets = np.zeros(chunk_rows + 1, np.int64)
+        self.size = 0
+        self.rows = 0
+
+    def append(self, array):
+        n = len(array)
+        if self.size + n > len(self.values):
+            # Grow geometrically so a chunk costs O(log) reallocations
+            capacity = max(2 * len(self.values), self.size + n, 1024)
+            values = np.empty(capacity, self.dtype)
+            values[: self.size] = self.values[: self.size]
+            self.values = values
+        self.values[self.size : self.size + n] = array
+        self.size += n
+        self.rows += 1
+        self.offsets[self.rows] = self.size
+
+    def save(self, directory, name):
+        """Write the rows so far and empty the buffer, keeping its capacity"""
+        np.save(os.path.join(directory, name + ".npy"), self.values[: self.size])
+        np.save(
+            os.path.join(directory, name + ".offsets.npy"),
+            self.offsets[: self.rows + 1],
+        )
+        self.size = 0
+        self.rows = 0
+
+
+class ResultSink(object):
+    """Appends JobOutput fields to a chunked columnar dataset on disk
+
+    >>> with ResultSink("training-set") as sink:
+    >>>     for index, atomic_input in enumerate(inputs):
+    >>>         sink.submit(pool, atomic_input, key=index)
+    >>> dataset = ResultDataset("training-set")
+
+    Appending is thread safe, so the callbacks of TCPBPool jobs write from the worker
+    threads as outputs arrive. Jobs that fail are listed in errors instead.
+    """
+
+    def __init__(self, path, fields=DEFAULT_FIELDS, chunk_rows=DEFAULT_CHUNK_ROWS):
+        """Initialize a ResultSink object, appending to the dataset at path if any.
+
+        Args:
+            path: Directory of the dataset, created if missing
+            fields: Repeated numeric JobOutput fields to store (ignored when
+                appending to an existing dataset, whose fields are kept)
+            chunk_rows (int): Jobs buffered in memory before a chunk is written
+        """
+        self.path = str(path)
+        self.chunk_rows = chunk_rows
+        os.makedirs(self.path, exist_ok=True)
+        metadata_file = os.path.join(self.path, METADATA_FILE)
+        if os.path.exists(metadata_file):
+            with open(metadata_file) as f:
+                self.metadata = json.load(f)
+        else:
+            self.metadata = {"fields": list(fields), "dtypes": {}, "chunks": []}
+        self.fields = list(self.metadata["fields"])
+        empty = JobOutputArrays(pb.JobOutput())
+        for name in self.fields:
+            try:
+                empty[name]
+            except KeyError:
+                raise ValueError(
+                    "{} is not a repeated numeric JobOutput field".format(name)
+                )
+        self.errors = []
+        self._columns = {}
+        self._keys = []
+        self._rows = sum(self.metadata["chunks"])
+        self._lock = threading.Lock()
+        # Jobs of submit() whose outputs have not been appended yet
+        self._pending = 0
+        self._idle = threading.Condition(self._lock)
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, type, value, traceback):
+        self.close()
+
+    def __len__(self):
+        """Rows appended, written or not"""
+        return self._rows
+
+    def _column(self, name, dtype):
+        column = self._columns.get(name)
+        if column is None:
+            dtype = self.metadata["dtypes"].setdefault(name, np.dtype(dtype).str)
+            column = self._columns[name] = _Column(dtype, self.chunk_rows)
+        return column
+
+    def append(self, job_output, key=None):
+        """Add the fields of a JobOutput as a row
+
+        Args:
+            job_output: JobOutput protobuf message
+            key (int): Key of the row, e.g. the index of the input (the row number by
+                default)
+        """
+        # Large fields are read from one serialization of the message; small ones do
+        # not warrant serializing bulk fields the sink does not store
+        arrays = JobOutputArrays(job_output)
+        values = [arrays[name] for name in self.fields]
+        with self._lock:
+            self._keys.append(self._rows if key is None else key)
+            for name, array in zip(self.fields, values):
+                self._column(name, array.dtype).append(array)
+            self._rows += 1
+            if len(self._keys) >= self.chunk_rows:
+                self._flush()
+
+    def submit(self, pool, atomic_input, key=None, priority=0):
+        """Run an AtomicInput on a TCPBPool and append its JobOutput once received
+
+        The output is never converted to an AtomicResult. close() waits for the
+        outputs of all submitted jobs.
+
+        Args:
+            pool: TCPBPool to run the job on
+            atomic_input: Input of the computation
+            key (int): Key of the row (see append())
+            priority: Priority class of the job
+
+        Returns:
+            concurrent.futures.Future: Future of the job, resolving to its JobOutput
+        """
+        job_input = atomic_input_to_job_input(atomic_input)
+        with self._lock:
+            self._pending += 1
+        try:
+            future = pool.submit_job_input(job_input, priority=priority)
+        except BaseException:
+            self._job_collected()
+            raise
+        future.add_done_callback(lambda future: self._collect(future, key))
+        return future
+
+    def _collect(self, future, key):
+        try:
+            self.append(future.result(), key)
+        except Exception as e:
+            with self._lock:
+                self.errors.append((key, e))
+        finally:
+            self._job_collected()
+
+    def _job_collected(self):
+        with self._lock:
+            self._pending -= 1
+            self._idle.notify_all()
+
+    def flush(self):
+        """Write the buffered rows as a chunk"""
+        with self._lock:
+            self._flush()
+
+    def _flush(self):
+        if not self._keys:
+            return
+        index = len(self.metadata["chunks"])
+        directory = os.path.join(self.path, _chunk_dir(index))
+        os.makedirs(directory, exist_ok=True)
+        np.save(os.path.join(directory, KEYS + ".npy"), np.asarray(self._keys))
+        for name in self.fields:
+            self._columns[name].save(directory, name)
+        self.metadata["chunks"].append(len(self._keys))
+        self._keys = []
+
+        # Readers only see chunks listed in the metadata, which is replaced atomically
+        metadata_file = os.path.join(self.path, METADATA_FILE)
+        with open(metadata_file + ".tmp", "w") as f:
+            json.dump(self.metadata, f)
+        os.replace(metadata_file + ".tmp", metadata_file)
+
+    def close(self):
+        """Wait for the outputs of submitted jobs and write the remaining rows"""
+        with self._lock:
+            while self._pending:
+                self._idle.wait()
+            self._flush()
+
+
+class ResultDataset(object):
+    """Columnar dataset written by a ResultSink
+
+    >>> dataset = ResultDataset("training-set")
+    >>> energies = dataset.stack("energy")[:, 0]
+    >>> gradient = dataset.row("gradient", 12).reshape(-1, 3)
+    """
+
+    def __init__(self, path, mmap_mode="r"):
+        """Initialize a ResultDataset object.
+
+        Args:
+            path: Directory of the dataset
+            mmap_mode: Mode the .npy files are memory mapped with (see np.load), or
+                None to read them into memory
+        """
+        self.path = str(path)
+        self.mmap_mode = mmap_mode
+        with open(os.path.join(self.path, METADATA_FILE)) as f:
+            self.metadata = json.load(f)
+        self.fields = list(self.metadata["fields"])
+        self.chunk_rows = list(self.metadata["chunks"])
+        self._starts = np.cumsum([0] + self.chunk_rows)
+
+    def __len__(self):
+        return int(self._starts[-1])
+
+    def _load(self, index, name):
+        return np.load(
+            os.path.join(self.path, _chunk_dir(index), name + ".npy"),
+            mmap_mode=self.mmap_mode,
+        )
+
+    def keys(self):
+        """Keys of all rows, in the order they were appended"""
+        keys = [self._load(index, KEYS) for index in range(len(self.chunk_rows))]
+        return np.concatenate(keys) if keys else np.empty(0, np.int64)
+
+    def chunks(self, name):
+        """(values, offsets) arrays of a field in every chunk, without copying
+
+        Yields:
+            tuple: Values of all rows of the chunk and their offsets
+        """
+        for index in range(len(self.chunk_rows)):
+            yield self._load(index, name), self._load(index, name + ".offsets")
+
+    def row(self, name, index):
+        """Values of a field in one row
+
+        Args:
+            name (str): Field name
+            index (int): Row number
+
+        Returns:
+            np.ndarray: Values of the row (a view of the memory mapped chunk)
+        """
+        if not 0 <= index < len(self):
+            raise IndexError("Row {} of a dataset of {} rows".format(index, len(self)))
+        chunk = int(np.searchsorted(self._starts, index, side="right")) - 1
+        local = index - self._starts[chunk]
+        offsets = self._load(chunk, name + ".offsets")
+        return self._load(chunk, name)[offsets[local] : offsets[local + 1]]
+
+    def stack(self, name):
+        """Values of a field with the same number in every row as a 2-D array
+
+        Returns:
+            np.ndarray: (rows, values per row) array
+        """
+        values = []
+        width = None
+        for chunk_values, offsets in self.chunks(name):
+            lengths = np.diff(offsets)
+            if not len(lengths):
+                continue
+            if lengths.min() != lengths.max() or width not in (None, lengths[0]):
+                raise ValueError(
+                    "Rows of field {} hold different numbers of values".format(name)
+                )
+            width = int(lengths[0])
+            values.append(chunk_values)
+        if not values:
+            return np.empty((0, 0))
+        return np.concatenate(values).reshape(len(self), width or 0)
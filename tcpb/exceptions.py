@@ -12,25 +12,54 @@ class TCPBError(Exception):
     pass
 
 
+# Lines of the job logfile shown in a ServerError, and the bytes read to find them
+_TAIL_LINES = 10
+_TAIL_BYTES = 4096
+
+
 class ServerError(TCPBError):
     """Raised when socket connection to server dies
 
-    Pulls logfile out of scratch dir for convenience
+    Points to the logfile of the current job in the scratch dir for convenience. The
+    logfile is only read when the error is printed (or logfile_tail() is called), so
+    raising and handling ServerErrors never waits on a slow job directory.
     """
 
     def __init__(self, msg, client):
-        msg += "\n\nServer Address: {}\n".format(client.tcaddr)
-
+        self.server_address = client.tcaddr
         job_dir = client.curr_job_dir
         job_id = client.curr_job_id
-        try:
-            logfile = "{}/{}.log".format(job_dir, job_id)
-            with open(logfile, "r") as logf:
-                lines = logf.readlines()
-
-            debuglines = "".join(lines[-10:])
-            msg += "Last 10 lines from logfile ({}):\n{}".format(logfile, debuglines)
-        except IOError:
-            msg += "Could not open logfile"
+        self.logfile = "{}/{}.log".format(job_dir, job_id) if job_dir else None
+        self._logfile_tail = None
 
+        msg += "\n\nServer Address: {}\n".format(self.server_address)
         super(ServerError, self).__init__(msg)
+
+    def logfile_tail(self):
+        """Last 10 lines of the job logfile, read on first call
+
+        Returns:
+            str: Lines of the logfile, or None if there is no job or it cannot be read
+        """
+        if self._logfile_tail is None and self.logfile is not None:
+            try:
+                with open(self.logfile, "rb") as logf:
+                    # Only the end of the file is needed
+                    size = logf.seek(0, 2)
+                    start = max(size - _TAIL_BYTES, 0)
+                    logf.seek(start)
+                    lines = logf.read().decode("utf-8", "replace").splitlines(True)
+            except IOError:
+                self._logfile_tail = False
+            else:
+                if start and len(lines) > _TAIL_LINES:
+                    lines = lines[1:]  # Likely cut off by the seek
+                self._logfile_tail = "".join(lines[-_TAIL_LINES:])
+        return self._logfile_tail or None
+
+    def __str__(self):
+        msg = super(ServerError, self).__str__()
+        tail = self.logfile_tail()
+        if tail is None:
+            return msg + "Could not open logfile"
+        return msg + "Last 10 lines from logfile ({}):\n{}".format(self.logfile, tail)
@@ -0,0 +1,209 @@
+"""Framing of protobuf messages for the TeraChem Protocol Buffer server
+
+Every message on the wire is preceded by an 8 byte header:
+First 4 bytes: int32 of protocol buffer message type (check the MessageType enum
+in the protobuf file)
+Second 4 bytes: int32 of packet size (not including the header)
+
+Both integers are packed big endian (network byte order). These helpers are shared
+by the blocking and asyncio clients, which only differ in how bytes are moved.
+
+If client and server negotiated a compression codec (see the Status message), large
+bodies may be sent compressed; the highest bit of the message type is then set. With
+the shared memory transport (see tcpb.shm), bit 30 marks bodies left in shared memory.
+"""
+
+import struct
+import zlib
+
+from . import terachem_server_pb2 as pb
+
+try:
+    import zstandard
+except ImportError:
+    zstandard = None
+
+try:
+    import lz4.frame as lz4_frame
+except ImportError:
+    lz4_frame = None
+
+HEADER_FORMAT = ">II"
+HEADER_SIZE = struct.calcsize(HEADER_FORMAT)
+
+# Set in the message type of a header whose body is compressed
+COMPRESSED_FLAG = 0x80000000
+# Set in the message type of a header followed by the position of its body in the
+# shared memory segment instead of the body
+SHM_FLAG = 0x40000000
+
+# Bodies smaller than this are not worth compressing
+COMPRESSION_THRESHOLD = 64 * 1024
+
+
+def _zstd_compress(data):
+    return zstandard.ZstdCompressor().compress(data)
+
+
+def _zstd_decompress(data):
+    return zstandard.ZstdDecompressor().decompress(data)
+
+
+def _zlib_compress(data):
+    # Fastest level; the point is to save bandwidth, not to minimize size
+    return zlib.compress(data, 1)
+
+
+# (compress, decompress) functions of each codec available in this environment, in
+# order of preference
+CODECS = {}
+if zstandard is not None:
+    CODECS[pb.Status.ZSTD] = (_zstd_compress, _zstd_decompress)
+if lz4_frame is not None:
+    CODECS[pb.Status.LZ4] = (lz4_frame.compress, lz4_frame.decompress)
+CODECS[pb.Status.ZLIB] = (_zlib_compress, zlib.decompress)
+
+# Protobuf message class for each MessageType
+MESSAGE_CLASSES = {
+    pb.STATUS: pb.Status,
+    pb.MOL: pb.Mol,
+    pb.JOBINPUT: pb.JobInput,
+    pb.JOBOUTPUT: pb.JobOutput,
+}
+
+
+def pack_header(msg_type, msg_size, compressed=False):
+    """Pack a message header
+
+    Args:
+        msg_type: Message type (defined as enum in protocol buffer)
+        msg_size: Size in bytes of the serialized protobuf following the header
+        compressed: Whether the body following the header is compressed
+
+    Returns:
+        bytes: 8 byte header
+    """
+    if compressed:
+        msg_type |= COMPRESSED_FLAG
+    return struct.pack(HEADER_FORMAT, msg_type, msg_size)
+
+
+def unpack_header(header):
+    """Unpack a message header
+
+    Args:
+        header: Buffer holding at least the 8 header bytes
+
+    Returns:
+        tuple: (message type, message size); the message type still carries
+        COMPRESSED_FLAG if it was set (see split_msg_type)
+    """
+    return struct.unpack_from(HEADER_FORMAT, header)
+
+
+def split_msg_type(msg_type):
+    """Split a message type read from a header into the type and compression flag
+
+    Returns:
+        tuple: (message type, True if the body is compressed)
+    """
+    return msg_type & ~COMPRESSED_FLAG, bool(msg_type & COMPRESSED_FLAG)
+
+
+def supported_compression(codecs=True):
+    """Compression codecs to offer the server, in order of preference
+
+    Args:
+        codecs: True for every codec available here, or a list of codec names
+            (e.g. ["zstd", "zlib"])
+
+    Returns:
+        list: pb.Status.CompressionType values
+    """
+    if codecs is True:
+        return list(CODECS)
+    supported = []
+    for name in codecs:
+        codec = pb.Status.CompressionType.Value(name.upper())
+        if codec not in CODECS:
+            raise ValueError(
+                "Compression codec {} is not available; install its Python "
+                "package or choose from {}".format(
+                    name,
+                    [pb.Status.CompressionType.Name(c).lower() for c in CODECS],
+                )
+            )
+        supported.append(codec)
+    return supported
+
+
+def serialize_msg(
+    msg_type,
+    msg_pb=None,
+    compression=pb.Status.NO_COMPRESSION,
+    threshold=COMPRESSION_THRESHOLD,
+):
+    """Serialize a protobuf into a header and body
+
+    Args:
+        msg_type: Message type (defined as enum in protocol buffer)
+        msg_pb: Protocol Buffer to send, its serialized bytes, or None for a
+            header-only message
+        compression: Negotiated codec; bodies of at least threshold bytes are
+            compressed with it when that makes them smaller
+        threshold: Smallest body size in bytes worth compressing
+
+    Returns:
+        tuple: (header bytes, body bytes)
+    """
+    if msg_pb is None:
+        msg_str = b""
+    elif isinstance(msg_pb, (bytes, bytearray, memoryview)):
+        msg_str = bytes(msg_pb)
+    else:
+        msg_str = msg_pb.SerializeToString()
+    if compression != pb.Status.NO_COMPRESSION and len(msg_str) >= threshold:
+        compressed = CODECS[compression][0](msg_str)
+        if len(compressed) < len(msg_str):
+            return pack_header(msg_type, len(compressed), compressed=True), compressed
+    return pack_header(msg_type, len(msg_str)), msg_str
+
+
+def decompress_body(msg_str, compression):
+    """Decompress a body received with COMPRESSED_FLAG set
+
+    Args:
+        msg_str: Bytes-like object holding the compressed protobuf
+        compression: Negotiated codec
+
+    Returns:
+        bytes: Serialized protobuf
+
+    Raises:
+        ValueError: No codec was negotiated or it is not available here
+    """
+    try:
+        decompress = CODECS[compression][1]
+    except KeyError:
+        raise ValueError(
+            "Received a compressed message without a negotiated compression codec"
+        )
+    return decompress(msg_str)
+
+
+def parse_msg(msg_type, msg_str):
+    """Parse a received message body into a protobuf of the given type
+
+    Args:
+        msg_type: Message type (defined as enum in protocol buffer)
+        msg_str: Bytes-like object holding the serialized protobuf
+
+    Returns:
+        protobuf: Protocol Buffer of type msg_type
+
+    Raises:
+        KeyError: msg_type is not a known MessageType
+    """
+    recv_pb = MESSAGE_CLASSES[msg_type]()
+    recv_pb.ParseFromString(msg_str)
+    return recv_pb
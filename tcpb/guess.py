@@ -0,0 +1,156 @@
+"""Client-side cache of SCF orbital guesses for repeated computations
+
+Scans, optimizations and dynamics run many jobs on the same system at nearby
+geometries. Starting each SCF from the orbitals of the closest previous geometry
+(TeraChem's "guess" keyword) instead of from scratch cuts the number of SCF
+iterations substantially. GuessCache records the orbital files reported in every
+JobOutput and adds the best matching one to later JobInputs automatically.
+"""
+
+import threading
+from collections import deque
+
+import numpy as np
+
+from . import terachem_server_pb2 as pb
+from .molden_constructor import BOHR2ANGSTROM
+
+
+def _user_option_keys(job_input):
+    """Keys of the "key", "value" pairs stored in JobInput.user_options"""
+    return job_input.user_options[::2]
+
+
+class GuessCache(object):
+    """Orbital guesses of previous jobs, keyed by the system they were computed for
+
+    Jobs share guesses when they agree on atoms, charge, spin multiplicity,
+    closed/restricted flags, method and basis; among those the guess from the
+    nearest geometry is used. Jobs that already set a "guess" option are left alone.
+
+    The cache stores paths on the TeraChem server, so it should only be shared by
+    clients of servers that can read each other's scratch directories.
+
+    A single cache may be used from several threads.
+    """
+
+    def __init__(self, max_entries=64, max_distance=None):
+        """Initialize a GuessCache object.
+
+        Args:
+            max_entries (int): Geometries remembered per system; the oldest are dropped first
+            max_distance (float): If set, guesses are only used for geometries within
+                this Euclidean distance in bohr of the recorded one
+        """
+        self.max_entries = max_entries
+        self.max_distance = max_distance
+        self.hits = 0
+        self.misses = 0
+        self._entries = {}
+        self._lock = threading.Lock()
+
+    @staticmethod
+    def _key(job_input):
+        """System identifier of a JobInput"""
+        mol = job_input.mol
+        return (
+            tuple(mol.atoms),
+            mol.charge,
+            mol.multiplicity,
+            mol.closed,
+            mol.restricted,
+            job_input.method,
+            job_input.basis,
+        )
+
+    @staticmethod
+    def _geometry(job_input):
+        """Geometry of a JobInput as a flat array in bohr"""
+        xyz = np.array(job_input.mol.xyz, dtype=np.float64)
+        if job_input.mol.units == pb.Mol.UnitType.ANGSTROM:
+            xyz /= BOHR2ANGSTROM
+        return xyz
+
+    @staticmethod
+    def _guess_option(job_input, job_output):
+        """Value of the "guess" keyword for the orbitals of a JobOutput, or None"""
+        if not job_output.orb1afile:
+            return None
+        if job_input.mol.restricted:
+            return job_output.orb1afile
+        if not job_output.orb1bfile:
+            return None
+        # TeraChem expects "guess <ca0 file> <cb0 file>"
+        return "{} {}".format(job_output.orb1afile, job_output.orb1bfile)
+
+    def __len__(self):
+        with self._lock:
+            return sum(len(entries) for entries in self._entries.values())
+
+    def clear(self):
+        """Forget all recorded guesses"""
+        with self._lock:
+            self._entries.clear()
+
+    def lookup(self, job_input):
+        """Find the guess recorded for the nearest geometry of the same system
+
+        Args:
+            job_input: JobInput protobuf message
+
+        Returns:
+            str: Value for the "guess" keyword, or None if there is no suitable guess
+        """
+        xyz = self._geometry(job_input)
+        best, best_distance = None, None
+        with self._lock:
+            for geometry, guess in self._entries.get(self._key(job_input), ()):
+                if geometry.shape != xyz.shape:
+                    continue
+                distance = np.linalg.norm(geometry - xyz)
+                if best_distance is None or distance < best_distance:
+                    best, best_distance = guess, distance
+
+            if best is not None and (
+                self.max_distance is None or best_distance <= self.max_distance
+            ):
+                self.hits += 1
+                return best
+            self.misses += 1
+            return None
+
+    def apply(self, job_input):
+        """Add the best available guess to a JobInput
+
+        Args:
+            job_input: JobInput protobuf message; it is not modified
+
+        Returns:
+            pb.JobInput: job_input itself if it already has a guess or none is
+            available, otherwise a copy with the "guess" option added
+        """
+        if "guess" in _user_option_keys(job_input):
+            return job_input
+        guess = self.lookup(job_input)
+        if guess is None:
+            return job_input
+        guessed = pb.JobInput()
+        guessed.CopyFrom(job_input)
+        guessed.user_options.extend(["guess", guess])
+        return guessed
+
+    def record(self, job_input, job_output):
+        """Remember the orbitals a job produced as a guess for its system
+
+        Args:
+            job_input: JobInput protobuf message the job was submitted with
+            job_output: JobOutput protobuf message of the job
+        """
+        guess = self._guess_option(job_input, job_output)
+        if guess is None:
+            return
+        with self._lock:
+            entries = self._entries.setdefault(
+                self._key(job_input), deque(maxlen=self.max_entries)
+            )
+            entries.append((self._geometry(job_input), guess))
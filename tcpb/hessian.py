@@ -0,0 +1,293 @@
+"""Hessians and harmonic frequencies from gradients computed across a TCPBPool
+
+TeraChem servers fill JobOutput.compressed_hessian when a JobInput asks for it
+(imd_type IMD_HESSIAN), but not every server or method supports that. A HessianJob
+first runs a gradient at the reference geometry asking for the server's Hessian. If
+none comes back, it fans out the 6N gradients of the geometries displaced by +-step
+along each Cartesian coordinate across the pool, starting each from the orbitals of
+the reference, and assembles the Hessian by central differences client-side.
+"""
+
+import threading
+from concurrent.futures import Future
+
+import numpy as np
+import qcelemental as qcel
+from qcelemental.models import AtomicInput, AtomicResult
+
+from . import terachem_server_pb2 as pb
+from .utils import atomic_input_to_job_input
+
+# Displacement of each Cartesian coordinate (bohr)
+DEFAULT_STEP = 0.005
+
+# sqrt(hartree / (bohr^2 amu)) in wavenumbers (cm^-1)
+_WAVENUMBER_FACTOR = np.sqrt(
+    qcel.constants.hartree2J
+    / ((qcel.constants.bohr2angstroms * 1e-10) ** 2 * qcel.constants.amu2kg)
+) / (2 * np.pi * qcel.constants.c * 100)
+
+
+def displaced_geometries(geometry, step=DEFAULT_STEP):
+    """Geometries displaced by +-step along each Cartesian coordinate
+
+    Args:
+        geometry: (natoms, 3) array (bohr)
+        step (float): Displacement (bohr)
+
+    Returns:
+        np.ndarray: (3 * natoms, 2, natoms, 3) array; [k, 0] is displaced by +step
+        and [k, 1] by -step along coordinate k of the flattened geometry
+    """
+    geometry = np.asarray(geometry, dtype=np.float64).reshape(-1, 3)
+    ncoords = geometry.size
+    displacements = step * np.eye(ncoords).reshape(ncoords, -1, 3)
+    return np.stack([geometry + displacements, geometry - displacements], axis=1)
+
+
+def finite_difference_hessian(gradients, step=DEFAULT_STEP):
+    """Hessian by central differences of gradients of displaced geometries
+
+    Args:
+        gradients: (3 * natoms, 2, natoms, 3) array of the gradients at the
+            geometries of displaced_geometries()
+        step (float): Displacement the geometries were made with (bohr)
+
+    Returns:
+        np.ndarray: Symmetric (3 * natoms, 3 * natoms) Hessian (hartree/bohr^2)
+    """
+    gradients = np.asarray(gradients, dtype=np.float64)
+    ncoords = gradients.shape[0]
+    plus = gradients[:, 0].reshape(ncoords, ncoords)
+    minus = gradients[:, 1].reshape(ncoords, ncoords)
+    hessian = (plus - minus) / (2 * step)
+    return (hessian + hessian.T) / 2
+
+
+def server_hessian(arrays, natoms):
+    """Hessian returned by the server in JobOutput.compressed_hessian, or None
+
+    Args:
+        arrays: JobOutputArrays of the JobOutput
+        natoms (int): Number of atoms
+
+    Returns:
+        np.ndarray: (3 * natoms, 3 * natoms) Hessian, or None if the server did not
+        return a complete one
+    """
+    values = arrays["compressed_hessian"]
+    ncoords = 3 * natoms
+    if len(values) != ncoords * ncoords:
+        return None
+    return values.astype(np.float64).reshape(ncoords, ncoords)
+
+
+def harmonic_frequencies(hessian, masses):
+    """Harmonic frequencies of a Hessian
+
+    Translations and rotations are not projected out, so 5 or 6 frequencies are
+    close to (but not exactly) zero.
+
+    Args:
+        hessian: (3 * natoms, 3 * natoms) Hessian (hartree/bohr^2)
+        masses: Masses of the atoms (amu)
+
+    Returns:
+        np.ndarray: Frequencies in increasing order (cm^-1); imaginary frequencies
+        are returned as negative numbers
+    """
+    weights = 1 / np.sqrt(np.repeat(np.asarray(masses, dtype=np.float64), 3))
+    eigenvalues = np.linalg.eigvalsh(hessian * np.outer(weights, weights))
+    return np.sign(eigenvalues) * np.sqrt(np.abs(eigenvalues)) * _WAVENUMBER_FACTOR
+
+
+class HessianJob(object):
+    """Hessian of an AtomicInput computed by the jobs of a TCPBPool
+
+    >>> job = HessianJob(pool, atomic_input)
+    >>> job.start()
+    >>> job.future.result().return_result
+
+    Nothing blocks: the displaced gradients are submitted from the callback of the
+    reference job and the Hessian is assembled in the callback of the last of them.
+    Use TCPBPool.submit_hessian() rather than this class directly.
+    """
+
+    def __init__(
+        self,
+        pool,
+        atomic_input: AtomicInput,
+        step: float = DEFAULT_STEP,
+        reuse_guess: bool = True,
+        use_server_hessian: bool = True,
+        raw_arrays: bool = False,
+        priority: int = 0,
+        affinity=None,
+    ):
+        """Initialize a HessianJob object.
+
+        Args:
+            pool: TCPBPool to run the gradients on
+            atomic_input: Input of the computation; its driver is ignored
+            step (float): Displacement of the finite differences (bohr)
+            reuse_guess (bool): Start the displaced gradients from the orbitals of the
+                reference geometry (servers must be able to read each other's scratch
+                directories); skipped if the keywords already hold a "guess"
+            use_server_hessian (bool): Ask the server for its Hessian and only fall
+                back to finite differences if none is returned
+            raw_arrays (bool): Keep NumPy arrays in the qcvars of the result
+            priority: Priority class of the gradient jobs
+            affinity: Affinity key of the reference job
+        """
+        self.pool = pool
+        self.atomic_input = atomic_input
+        self.step = step
+        self.reuse_guess = reuse_guess
+        self.use_server_hessian = use_server_hessian
+        self.raw_arrays = raw_arrays
+        self.priority = priority
+        self.affinity = affinity
+        self.future = Future()
+        self.natoms = len(atomic_input.molecule.symbols)
+        self._reference = None
+        self._gradients = None
+        self._remaining = 0
+        self._lock = threading.Lock()
+
+    def _gradient_input(self, geometry=None, guess=None):
+        """Gradient AtomicInput of the system at a geometry, by default the reference"""
+        update = {"driver": "gradient"}
+        if geometry is not None:
+            update["molecule"] = self.atomic_input.molecule.copy(
+                update={"geometry": geometry}
+            )
+        if guess is not None:
+            update["keywords"] = dict(self.atomic_input.keywords, guess=guess)
+        return self.atomic_input.copy(update=update, deep=True)
+
+    def start(self):
+        """Submit the reference gradient
+
+        Returns:
+            concurrent.futures.Future: Future resolving to the AtomicResult with the
+            Hessian as return_result
+        """
+        reference = self._gradient_input()
+        job_input = atomic_input_to_job_input(reference.copy(deep=True))
+        if self.use_server_hessian:
+            job_input.imd_type = pb.JobInput.ImdType.IMD_HESSIAN
+        self.pool.submit(
+            reference,
+            raw_arrays=True,
+            priority=self.priority,
+            affinity=self.affinity,
+            job_input=job_input,
+        ).add_done_callback(self._reference_done)
+        return self.future
+
+    def _guess(self, reference):
+        """Value of the "guess" keyword for the orbitals of the reference, or None"""
+        if not self.reuse_guess or "guess" in self.atomic_input.keywords:
+            return None
+        qcvars = reference.extras["qcvars"]
+        if not qcvars.get("orb1afile"):
+            return None
+        if self.atomic_input.keywords.get("restricted", True):
+            return qcvars["orb1afile"]
+        if not qcvars.get("orb1bfile"):
+            return None
+        return "{} {}".format(qcvars["orb1afile"], qcvars["orb1bfile"])
+
+    def _reference_done(self, future):
+        try:
+            reference = future.result()
+            self._reference = reference
+            if self.use_server_hessian:
+                hessian = server_hessian(
+                    reference.extras["job_output_arrays"], self.natoms
+                )
+                if hessian is not None:
+                    self._finish(hessian, "server")
+                    return
+
+            geometries = displaced_geometries(
+                self.atomic_input.molecule.geometry, self.step
+            )
+            self._gradients = np.zeros(geometries.shape)
+            self._remaining = geometries.shape[0] * 2
+            guess = self._guess(reference)
+            for k in range(geometries.shape[0]):
+                for sign in (0, 1):
+                    self.pool.submit(
+                        self._gradient_input(geometries[k, sign], guess),
+                        raw_arrays=True,
+                        priority=self.priority,
+                    ).add_done_callback(
+                        lambda future, k=k, sign=sign: self._gradient_done(
+                            future, k, sign
+                        )
+                    )
+        except Exception as e:
+            self._fail(e)
+
+    def _gradient_done(self, future, k, sign):
+        try:
+            gradient = future.result().return_result
+        except Exception as e:
+            self._fail(e)
+            return
+        with self._lock:
+            self._gradients[k, sign] = np.asarray(gradient).reshape(-1, 3)
+            self._remaining -= 1
+            last = self._remaining == 0
+        if last:
+            try:
+                self._finish(
+                    finite_difference_hessian(self._gradients, self.step),
+                    "finite_difference",
+                )
+            except Exception as e:
+                self._fail(e)
+
+    def _fail(self, error):
+        with self._lock:
+            if self.future.done():
+                return
+            self.future.set_exception(error)
+
+    def _finish(self, hessian, source):
+        """Resolve the future with the AtomicResult of a Hessian"""
+        reference = self._reference
+        frequencies = harmonic_frequencies(hessian, self.atomic_input.molecule.masses)
+        qcvars = dict(reference.extras["qcvars"])
+        if not self.raw_arrays:
+            qcvars = {
+                key: value.tolist() if isinstance(value, np.ndarray) else value
+                for key, value in qcvars.items()
+            }
+
+        atomic_input_dict = self.atomic_input.dict()
+        atomic_input_dict.pop("provenance", None)
+        atomic_input_dict["driver"] = "hessian"
+        atomic_result = AtomicResult(
+            **atomic_input_dict,
+            provenance=reference.provenance,
+            return_result=hessian,
+            properties=reference.properties,
+            success=True,
+        )
+        atomic_result.extras.update(
+            {
+                "qcvars": qcvars,
+                "molden": reference.extras.get("molden"),
+                "hessian": {
+                    "source": source,
+                    "step": self.step if source == "finite_difference" else None,
+                    "displacements": 0 if source == "server" else 2 * len(hessian),
+                    "frequencies": frequencies.tolist(),
+                },
+            }
+        )
+        with self._lock:
+            if not self.future.done():
+                self.future.set_result(atomic_result)
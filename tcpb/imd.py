@@ -0,0 +1,189 @@
+"""Interactive MD (IMD) streaming over a persistent connection
+
+In IMD mode TeraChem continues each frame from the previous one: the JobInput of a
+frame carries the previous geometry and molecular orbitals (imd_xyz_previous,
+imd_mo_previous) so the SCF starts from extrapolated orbitals, and optionally the
+positions and data of MM atoms (imd_mmatom_position, imd_mmatom_info) acting on the
+QM region. The JobOutput returns the gradient, the gradient on the MM atoms
+(imd_mmatom_gradient) and the orbitals in the compressed_* fields.
+
+IMDStream keeps the last frames in a client-side ring buffer and builds every frame's
+JobInput by appending these fields to the serialized template (see tcpb.session), so
+steering or VR loops spend their time in TeraChem rather than in the client.
+"""
+
+from collections import deque
+
+import numpy as np
+
+from . import terachem_server_pb2 as pb
+from .session import Session
+from .utils import JobOutputArrays
+from .wire import encode_packed_array, encode_varint_field
+
+_DOUBLE = np.dtype("<f8")
+_FLOAT = np.dtype("<f4")
+
+
+class IMDFrame(object):
+    """Result of one IMD frame
+
+    Attributes:
+        xyz (np.ndarray): QM coordinates of the frame in bohr, flat
+        job_output: JobOutput protobuf message of the frame
+        arrays (JobOutputArrays): Repeated fields of job_output as NumPy arrays
+    """
+
+    def __init__(self, xyz, job_output):
+        self.xyz = xyz
+        self.job_output = job_output
+        self.arrays = JobOutputArrays(job_output)
+
+    @property
+    def energy(self):
+        """Energy of the frame in hartree"""
+        return self.job_output.energy[0]
+
+    @property
+    def gradient(self):
+        """Gradient on the QM atoms, of shape (natoms, 3)"""
+        return self.arrays["gradient"].reshape(-1, 3)
+
+    @property
+    def mm_gradient(self):
+        """Gradient on the MM atoms, of shape (nmm, 3)"""
+        return self.arrays["imd_mmatom_gradient"].reshape(-1, 3)
+
+    @property
+    def mo_vector(self):
+        """Flat float32 MO coefficients (compressed_mo_vector) of the frame"""
+        return self.arrays["compressed_mo_vector"]
+
+
+class IMDStream(Session):
+    """Gradient frames of an interactive MD run on one connection
+
+    >>> with TCProtobufClient(host, port) as client:
+    >>>     stream = client.imd_stream(atomic_input)
+    >>>     while running:
+    >>>         frame = stream.step(xyz, mm_positions, mm_info)
+    >>>         apply_forces(-frame.gradient, -frame.mm_gradient)
+
+    The first frame, and the first after reset(), starts a new IMD condition; every
+    later frame continues from the geometry and orbitals of the frame before it.
+    """
+
+    def __init__(self, client, atomic_input, history=2, orbital_type="WHOLE_C"):
+        """Initialize an IMDStream object.
+
+        Args:
+            client: Connected TCProtobufClient running the frames
+            atomic_input: Template AtomicInput of the QM region
+            history (int): Number of frames kept in the history ring buffer
+            orbital_type (str): pb.JobInput.ImdOrbitalType name of the orbitals to
+                return and continue from, unless the template sets imd_orbital_type
+        """
+        super(IMDStream, self).__init__(client, atomic_input, reuse_guess=False)
+        self.history = deque(maxlen=history)
+        fields = [
+            encode_varint_field(
+                pb.JobInput.RUN_FIELD_NUMBER, pb.JobInput.RunType.GRADIENT
+            )
+        ]
+        if self.template.imd_orbital_type == pb.JobInput.ImdOrbitalType.NO_ORBITAL:
+            fields.append(
+                encode_varint_field(
+                    pb.JobInput.IMD_ORBITAL_TYPE_FIELD_NUMBER,
+                    pb.JobInput.ImdOrbitalType.Value(orbital_type.upper()),
+                )
+            )
+        self._frame_str = b"".join(fields)
+
+    def reset(self):
+        """Forget the history so the next frame starts a new IMD condition"""
+        self.history.clear()
+
+    def frame_bytes(self, xyz, mm_positions=None, mm_info=None):
+        """Serialized JobInput of the next frame
+
+        Args:
+            xyz: QM coordinates in bohr, of shape (natoms, 3) or flat
+            mm_positions: MM atom coordinates, of shape (nmm, 3) or flat
+            mm_info: Data of each MM atom passed to imd_mmatom_info (e.g. the point
+                charges)
+
+        Returns:
+            bytes: JobInput of the frame
+        """
+        parts = [self.job_input_bytes(xyz), self._frame_str]
+        if self.history:
+            previous = self.history[-1]
+            parts += [
+                encode_varint_field(
+                    pb.JobInput.IMD_TYPE_FIELD_NUMBER,
+                    pb.JobInput.ImdType.IMD_CONTINUE,
+                ),
+                encode_packed_array(
+                    pb.JobInput.IMD_XYZ_PREVIOUS_FIELD_NUMBER, previous.xyz, _DOUBLE
+                ),
+                encode_packed_array(
+                    pb.JobInput.IMD_MO_PREVIOUS_FIELD_NUMBER,
+                    previous.mo_vector,
+                    _FLOAT,
+                ),
+            ]
+        else:
+            parts.append(
+                encode_varint_field(
+                    pb.JobInput.IMD_TYPE_FIELD_NUMBER,
+                    pb.JobInput.ImdType.IMD_NEW_CONDITION,
+                )
+            )
+        if mm_positions is not None:
+            parts.append(
+                encode_packed_array(
+                    pb.JobInput.IMD_MMATOM_POSITION_FIELD_NUMBER,
+                    np.ravel(mm_positions),
+                    _FLOAT,
+                )
+            )
+        if mm_info is not None:
+            parts.append(
+                encode_packed_array(
+                    pb.JobInput.IMD_MMATOM_INFO_FIELD_NUMBER, np.ravel(mm_info), _FLOAT
+                )
+            )
+        return b"".join(parts)
+
+    def step(self, xyz, mm_positions=None, mm_info=None):
+        """Compute one frame
+
+        Args:
+            xyz: QM coordinates in bohr, of shape (natoms, 3) or flat
+            mm_positions: MM atom coordinates, of shape (nmm, 3) or flat
+            mm_info: Data of each MM atom passed to imd_mmatom_info (e.g. the point
+                charges)
+
+        Returns:
+            IMDFrame: Result of the frame, also appended to history
+        """
+        msg_str = self.frame_bytes(xyz, mm_positions, mm_info)
+        job_output = self._run_bytes(msg_str)
+        frame = IMDFrame(np.asarray(xyz, dtype=np.float64).ravel(), job_output)
+        self.history.append(frame)
+        return frame
+
+    def stream(self, frames):
+        """Compute a sequence of frames
+
+        Args:
+            frames: Iterable of xyz arrays or (xyz, mm_positions, mm_info) tuples
+
+        Yields:
+            IMDFrame: Result of each frame
+        """
+        for frame in frames:
+            if isinstance(frame, tuple):
+                yield self.step(*frame)
+            else:
+                yield self.step(frame)
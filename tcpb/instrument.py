@@ -0,0 +1,133 @@
+"""Per-job timings and instrumentation hooks of TCProtobufClient
+
+Every job run by a TCProtobufClient records where its wall time went in a JobTimings
+object. Consecutive phases cover the job from start to finish:
+
+* input: converting the AtomicInput to a JobInput (compute() only)
+* queue: from submitting the JobInput until the server accepted it, including
+  resubmissions while the server was busy
+* compute: from acceptance until a Status poll reported the job completed
+* receive: receiving and parsing the JobOutput
+* output: converting the JobOutput to the returned result
+
+In addition the time spent serializing, sending, receiving and parsing messages is
+summed up over all messages of the job, with the bytes sent and received per message
+type (headers included) and the number of check_job_complete() polls.
+
+JobHooks subclasses passed as hooks to TCProtobufClient are notified of every message,
+finished phase and finished job, e.g. to feed Prometheus or OpenTelemetry exporters.
+"""
+
+import logging
+from collections import OrderedDict
+from time import perf_counter
+
+from . import terachem_server_pb2 as pb
+
+logger = logging.getLogger(__name__)
+
+# Directions of messages passed to JobHooks.on_message()
+SENT = "sent"
+RECEIVED = "received"
+
+
+class JobHooks(object):
+    """Callbacks receiving the instrumentation of TCProtobufClient jobs
+
+    Subclasses override the methods they need; exceptions they raise are logged and
+    do not interrupt the job.
+    """
+
+    def on_message(self, direction, msg_type, nbytes):
+        """Called for every message sent or received as part of a job
+
+        Args:
+            direction (str): SENT or RECEIVED
+            msg_type (str): Name of the message type (e.g. "JOBINPUT")
+            nbytes (int): Size of the message including its header
+        """
+
+    def on_phase(self, phase, seconds):
+        """Called when a phase of a job (see tcpb.instrument) ends
+
+        Args:
+            phase (str): Name of the phase
+            seconds (float): Wall time spent in the phase
+        """
+
+    def on_job(self, timings):
+        """Called when a job is finished
+
+        Args:
+            timings (JobTimings): Complete timings of the job
+        """
+
+
+class JobTimings(object):
+    """Timings, message sizes and poll count of one job"""
+
+    def __init__(self, hooks=()):
+        """Initialize a JobTimings object, starting its first phase
+
+        Args:
+            hooks: JobHooks to notify
+        """
+        self.hooks = hooks
+        self.phases = OrderedDict()
+        self.io = OrderedDict(
+            (category, 0.0) for category in ("serialize", "send", "recv", "parse")
+        )
+        self.bytes_sent = {}
+        self.bytes_received = {}
+        self.polls = 0
+        self.cached = False
+        self.total = None
+        self._start = self._lap_start = perf_counter()
+
+    def _notify(self, method, *args):
+        for hook in self.hooks:
+            try:
+                getattr(hook, method)(*args)
+            except Exception:
+                logger.exception("Instrumentation hook %r failed", hook)
+
+    def lap(self, phase):
+        """End the current phase, adding the time since the previous lap to phase"""
+        now = perf_counter()
+        seconds = now - self._lap_start
+        self._lap_start = now
+        self.phases[phase] = self.phases.get(phase, 0.0) + seconds
+        self._notify("on_phase", phase, seconds)
+
+    def message(self, direction, msg_type, nbytes, **seconds):
+        """Record a message of the job
+
+        Args:
+            direction (str): SENT or RECEIVED
+            msg_type: Message type (defined as enum in protocol buffer)
+            nbytes (int): Size of the message including its header
+            **seconds: Time spent on the message, keyed by io category
+        """
+        name = pb.MessageType.Name(msg_type)
+        counts = self.bytes_sent if direction == SENT else self.bytes_received
+        counts[name] = counts.get(name, 0) + nbytes
+        for category, value in seconds.items():
+            self.io[category] += value
+        self._notify("on_message", direction, name, nbytes)
+
+    def finish(self):
+        """Stop the clock and notify the hooks that the job is finished"""
+        self.total = perf_counter() - self._start
+        self._notify("on_job", self)
+
+    def to_dict(self):
+        """JSON serializable copy of the timings, as stored in AtomicResult.extras"""
+        return {
+            "phases": dict(self.phases),
+            "io": dict(self.io),
+            "bytes_sent": dict(self.bytes_sent),
+            "bytes_received": dict(self.bytes_received),
+            "polls": self.polls,
+            "cached": self.cached,
+            "total": self.total,
+        }
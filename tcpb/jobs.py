@@ -0,0 +1,80 @@
+"""Handles of jobs submitted with TCProtobufClient.submit_job()
+
+A client may have several jobs outstanding on one server. Servers that queue jobs
+accept every JobInput right away, number them with server_job_id and answer Status
+requests carrying a server_job_id for that job, so the next job can start as soon as
+the previous one finishes. With servers running one job at a time, the client keeps
+the remaining jobs pending and submits the next one as soon as it has received the
+output of the previous one.
+"""
+
+from .exceptions import TCPBError
+from .utils import job_output_to_atomic_result
+
+# Job states
+PENDING = "pending"  # Not yet accepted by the server
+QUEUED = "queued"  # Accepted, not (yet) reported running by the server
+WORKING = "working"  # Running on the server
+COMPLETED = "completed"  # JobOutput received
+
+
+class JobHandle(object):
+    """A job submitted with TCProtobufClient.submit_job()
+
+    Attributes:
+        job_input: JobInput protobuf message sent to the server
+        atomic_input: AtomicInput the job was created from (None for a JobInput)
+        state (str): PENDING, QUEUED, WORKING or COMPLETED
+        server_job_id (int): Id given to the job by the server once accepted
+        job_dir (str): Job directory on the server once accepted
+        job_scr_dir (str): Scratch directory on the server once accepted
+        job_output: JobOutput protobuf message once completed
+        partial_output: Partial JobOutputs received so far, merged, for JobInputs
+            with partial_outputs set (see tcpb.partial)
+        timings (JobTimings): Timings of the job (see tcpb.instrument)
+    """
+
+    def __init__(self, job_input, atomic_input=None, timings=None):
+        self.job_input = job_input
+        self.atomic_input = atomic_input
+        self.state = PENDING
+        self.server_job_id = None
+        self.job_dir = None
+        self.job_scr_dir = None
+        self.job_output = None
+        self.partial_output = None
+        self.timings = timings
+
+    def __repr__(self):
+        return "<JobHandle server_job_id={} state={}>".format(
+            self.server_job_id, self.state
+        )
+
+    def done(self):
+        """True once the JobOutput of the job has been received"""
+        return self.state == COMPLETED
+
+    def result(self, raw_arrays=False):
+        """AtomicResult of a completed job submitted as an AtomicInput
+
+        Args:
+            raw_arrays: If True, array results are returned as NumPy arrays (see
+                utils.job_output_to_atomic_result)
+
+        Returns:
+            AtomicResult: Result of the job, with its timings in extras["timings"]
+        """
+        if not self.done():
+            raise TCPBError("Job {!r} has not completed".format(self))
+        if self.atomic_input is None:
+            raise TCPBError(
+                "Job {!r} was submitted as a JobInput; use job_output".format(self)
+            )
+        result = job_output_to_atomic_result(
+            atomic_input=self.atomic_input,
+            job_output=self.job_output,
+            raw_arrays=raw_arrays,
+        )
+        if self.timings is not None:
+            result.extras["timings"] = self.timings.to_dict()
+        return result
@@ -0,0 +1,308 @@
+"""CI vector overlaps between many pairs of frames
+
+compute_ci_overlap() runs one job per pair of geometries and sends the CI vectors and
+orbitals of both frames with it, so overlapping every frame of a trajectory with the
+k frames before it sends each frame 2k times. A CIOverlapBatch holds the frames of a
+series, encoded once, with the keywords converted once into a JobInputTemplate, and
+builds JobInputs covering many pairs: every frame used by the pairs of a job is sent
+once in the overlap_* fields (see the JobInput message) and the server returns the
+overlap matrix of each pair. Servers without batch support compute the first pair
+only; the remaining pairs are then sent as one job each, all submitted at once so
+servers that queue jobs run them back to back. CIOverlapJob spreads the pairs of a
+batch across the servers of a TCPBPool.
+"""
+
+import threading
+from concurrent.futures import Future
+
+import numpy as np
+
+from . import terachem_server_pb2 as pb
+from .exceptions import TCPBError
+from .utils import repeated_to_array
+from .wire import encode_length_delimited, encode_varint
+
+_DOUBLE = np.dtype("<f8")
+
+
+def overlap_pairs(nframes, window=None):
+    """Pairs of frames to compute the overlaps of
+
+    Args:
+        nframes (int): Number of frames
+        window (int): Pair each frame with this many frames before it (a sliding
+            window along a trajectory); all pairs if None
+
+    Returns:
+        list: (i, j) tuples with i < j, ordered by j and then i
+    """
+    pairs = []
+    for j in range(nframes):
+        start = 0 if window is None else max(0, j - window)
+        pairs.extend((i, j) for i in range(start, j))
+    return pairs
+
+
+def _frame_bytes(values, order, what):
+    """Little endian doubles of the arrays of each frame, laid out in order"""
+    frames = [np.asarray(value, dtype=_DOUBLE).tobytes(order=order) for value in values]
+    if len({len(frame) for frame in frames}) > 1:
+        raise ValueError("The {} of the frames differ in size".format(what))
+    return frames
+
+
+def _packed(number, frames):
+    """Packed double field holding the concatenated arrays of frames"""
+    return encode_length_delimited(number, b"".join(frames))
+
+
+class CIOverlapBatch(object):
+    """Frames of a series of CI overlap computations sharing their keywords
+
+    >>> template = TCProtobufClient.job_template("ci_vec_overlap", **options)
+    >>> batch = CIOverlapBatch(template, geoms, cvecs, orbs)
+    >>> overlaps = batch.compute(client, overlap_pairs(len(geoms), window=3))
+    """
+
+    def __init__(self, template, geoms, cvecs, orbs):
+        """Initialize a CIOverlapBatch object.
+
+        Args:
+            template: JobInputTemplate of a ci_vec_overlap job with the atoms and
+                keywords (e.g. from TCProtobufClient.job_template())
+            geoms: Geometry of each frame, flat or (natoms, 3), in the units of the
+                template
+            cvecs: CI vector of each frame, (num_states, num_determinants) as for the
+                cvec1 argument of compute_ci_overlap()
+            orbs: Alpha MO coefficients of each frame as returned by
+                serial_utils.read_orbfile
+        """
+        self._template_str = template.base.SerializeToString()
+        self._xyz = _frame_bytes(geoms, "C", "geometries")
+        self._cvecs = _frame_bytes(cvecs, "C", "CI vectors")
+        self._orbs = _frame_bytes(orbs, "F", "orbitals")
+        self.nframes = len(self._xyz)
+        if not len(self._cvecs) == len(self._orbs) == self.nframes:
+            raise ValueError(
+                "Got {} geometries, {} CI vectors and {} sets of orbitals".format(
+                    self.nframes, len(self._cvecs), len(self._orbs)
+                )
+            )
+        ncoords = 3 * template.natoms
+        if self.nframes and len(self._xyz[0]) != ncoords * _DOUBLE.itemsize:
+            raise ValueError(
+                "Geometries have {} coordinates; expected {} for {} atoms".format(
+                    len(self._xyz[0]) // _DOUBLE.itemsize, ncoords, template.natoms
+                )
+            )
+
+    def job_input_bytes(self, pairs):
+        """Serialized JobInput computing the overlaps of pairs of frames
+
+        Only the frames used by pairs are sent, each once; a single pair is sent as
+        a plain ci_vec_overlap job.
+
+        Args:
+            pairs: (i, j) frame indices of each overlap
+
+        Returns:
+            bytes: JobInput the server parses as the template with the frames
+        """
+        pairs = [(int(i), int(j)) for i, j in pairs]
+        if not pairs:
+            raise ValueError("No overlap pairs given")
+        for pair in pairs:
+            if not all(0 <= index < self.nframes for index in pair):
+                raise ValueError(
+                    "Overlap pair {} refers to frames beyond the {} given".format(
+                        pair, self.nframes
+                    )
+                )
+
+        first, second = pairs[0]
+        parts = [
+            self._template_str,
+            encode_length_delimited(
+                pb.JobInput.MOL_FIELD_NUMBER,
+                _packed(pb.Mol.XYZ_FIELD_NUMBER, [self._xyz[first]]),
+            ),
+            _packed(pb.JobInput.XYZ2_FIELD_NUMBER, [self._xyz[second]]),
+            _packed(pb.JobInput.CVEC1_FIELD_NUMBER, [self._cvecs[first]]),
+            _packed(pb.JobInput.CVEC2_FIELD_NUMBER, [self._cvecs[second]]),
+            _packed(pb.JobInput.ORB1A_FIELD_NUMBER, [self._orbs[first]]),
+            _packed(pb.JobInput.ORB2A_FIELD_NUMBER, [self._orbs[second]]),
+        ]
+        if len(pairs) > 1:
+            frames = sorted({index for pair in pairs for index in pair})
+            position = {frame: k for k, frame in enumerate(frames)}
+            parts += [
+                _packed(
+                    pb.JobInput.OVERLAP_XYZ_FIELD_NUMBER,
+                    [self._xyz[frame] for frame in frames],
+                ),
+                _packed(
+                    pb.JobInput.OVERLAP_CVECS_FIELD_NUMBER,
+                    [self._cvecs[frame] for frame in frames],
+                ),
+                _packed(
+                    pb.JobInput.OVERLAP_ORBS_FIELD_NUMBER,
+                    [self._orbs[frame] for frame in frames],
+                ),
+                encode_length_delimited(
+                    pb.JobInput.OVERLAP_PAIRS_FIELD_NUMBER,
+                    b"".join(
+                        encode_varint(position[index])
+                        for pair in pairs
+                        for index in pair
+                    ),
+                ),
+            ]
+        return b"".join(parts)
+
+    def job_input(self, pairs):
+        """JobInput computing the overlaps of pairs of frames (see job_input_bytes())
+
+        Returns:
+            pb.JobInput: New message
+        """
+        return pb.JobInput.FromString(self.job_input_bytes(pairs))
+
+    @staticmethod
+    def pair_overlaps(job_output):
+        """Overlap matrices returned by a job
+
+        Args:
+            job_output: JobOutput protobuf message of a job from job_input()
+
+        Returns:
+            (npairs, num_states, num_states) ndarray: Overlaps of the pairs the server
+            computed, in the order of the job's pairs
+        """
+        size = job_output.ci_overlap_size
+        values = repeated_to_array(job_output.ci_overlaps)
+        if not size or len(values) % (size * size):
+            raise TCPBError(
+                "JobOutput holds {} overlap values of {} x {} matrices".format(
+                    len(values), size, size
+                )
+            )
+        return values.reshape(-1, size, size)
+
+    @staticmethod
+    def _check_first_pair(overlaps, npairs):
+        """Make sure a job of npairs pairs that came back short computed the first
+        pair only, as servers without batch support do"""
+        if len(overlaps) != 1:
+            raise TCPBError(
+                "Server returned {} overlap matrices for {} pairs".format(
+                    len(overlaps), npairs
+                )
+            )
+
+    def compute(self, client, pairs):
+        """Overlaps of pairs of frames on one client
+
+        Args:
+            client: Connected TCProtobufClient
+            pairs: (i, j) frame indices of each overlap
+
+        Returns:
+            (npairs, num_states, num_states) ndarray: Overlap of each pair
+        """
+        pairs = list(pairs)
+        handle = client.submit_job(self.job_input(pairs))
+        overlaps = self.pair_overlaps(client.collect(handle))
+        if len(overlaps) == len(pairs):
+            return overlaps
+        self._check_first_pair(overlaps, len(pairs))
+        handles = [client.submit_job(self.job_input([pair])) for pair in pairs[1:]]
+        singles = [self.pair_overlaps(client.collect(handle)) for handle in handles]
+        for single in singles:
+            self._check_first_pair(single, 1)
+        return np.concatenate([overlaps] + singles)
+
+
+class CIOverlapJob(object):
+    """Overlaps of a CIOverlapBatch computed by the jobs of a TCPBPool
+
+    >>> job = CIOverlapJob(pool, batch, pairs)
+    >>> job.start().result()
+
+    The pairs are split into one batch job per server (or jobs of them). Nothing
+    blocks: jobs whose server computed only their first pair resubmit the others one
+    per job from their callbacks. Use TCPBPool.submit_ci_overlaps() rather than this
+    class directly.
+    """
+
+    def __init__(self, pool, batch, pairs, jobs=None, priority=0):
+        """Initialize a CIOverlapJob object.
+
+        Args:
+            pool: TCPBPool to run the jobs on
+            batch: CIOverlapBatch holding the frames
+            pairs: (i, j) frame indices of each overlap
+            jobs (int): Number of batch jobs to split the pairs into (one per live
+                server by default)
+            priority: Priority class of the jobs
+        """
+        self.pool = pool
+        self.batch = batch
+        self.pairs = list(pairs)
+        self.jobs = jobs
+        self.priority = priority
+        self.future = Future()
+        self._overlaps = [None] * len(self.pairs)
+        self._remaining = len(self.pairs)
+        self._lock = threading.Lock()
+
+    def start(self):
+        """Submit the batch jobs
+
+        Returns:
+            concurrent.futures.Future: Future resolving to the (npairs, num_states,
+            num_states) ndarray of overlaps
+        """
+        if not self.pairs:
+            raise ValueError("No overlap pairs given")
+        jobs = self.jobs or max(len(self.pool._live_workers()), 1)
+        size = -(-len(self.pairs) // jobs)
+        for start in range(0, len(self.pairs), size):
+            self._submit(start, self.pairs[start : start + size])
+        return self.future
+
+    def _submit(self, start, pairs):
+        """Submit the pairs from index start of self.pairs as one job"""
+        try:
+            future = self.pool.submit_job_input(
+                self.batch.job_input(pairs), priority=self.priority
+            )
+        except Exception as e:
+            self._fail(e)
+            return
+        future.add_done_callback(lambda future: self._job_done(future, start, pairs))
+
+    def _job_done(self, future, start, pairs):
+        try:
+            overlaps = self.batch.pair_overlaps(future.result())
+            if len(overlaps) != len(pairs):
+                self.batch._check_first_pair(overlaps, len(pairs))
+                for k in range(1, len(pairs)):
+                    self._submit(start + k, pairs[k : k + 1])
+        except Exception as e:
+            self._fail(e)
+            return
+        with self._lock:
+            for k, overlap in enumerate(overlaps):
+                self._overlaps[start + k] = overlap
+            self._remaining -= len(overlaps)
+            last = self._remaining == 0
+        if last:
+            with self._lock:
+                if not self.future.done():
+                    self.future.set_result(np.stack(self._overlaps))
+
+    def _fail(self, error):
+        with self._lock:
+            if self.future.done():
+                return
+            self.future.set_exception(error)
@@ -0,0 +1,330 @@
+"""Results of multi-state jobs received in stages while the job runs
+
+A JobOutput of a CASCI or CIS job with many states holds its energies long before the
+transition dipoles and CI vectors are written, yet normally arrives only once all of
+it is done. A JobInput with partial_outputs set asks the server to send it in stages
+instead: a working Status with partial_output set is followed by a JobOutput holding
+the fields of one stage (STAGE_FIELDS), and the JobOutput following the completed
+Status holds the rest. No field is sent twice, so merging the JobOutputs in order
+gives the complete output. Servers that ignore partial_outputs send a single JobOutput.
+
+PartialResults exposes the stages of one job as an iterator of PartialFrames and as a
+Future per JobOutput field, and merges them into the final AtomicResult.
+"""
+
+import threading
+from collections import OrderedDict
+from concurrent.futures import Future
+from time import sleep
+
+from . import terachem_server_pb2 as pb
+from .instrument import JobTimings
+from .utils import (
+    FLOAT32_FIELDS,
+    JobOutputArrays,
+    atomic_input_to_job_input,
+    job_output_to_atomic_result,
+)
+
+FINAL = pb.JobOutput.OutputStage.FINAL
+ENERGIES = pb.JobOutput.OutputStage.ENERGIES
+GRADIENTS = pb.JobOutput.OutputStage.GRADIENTS
+
+# Fields of the JobOutputs a server sends before the final one, in that order
+STAGE_FIELDS = OrderedDict(
+    [
+        (ENERGIES, ("energy", "cas_energy_states", "cas_energy_mults", "cis_states")),
+        (GRADIENTS, ("gradient", "nacme", "imd_mmatom_gradient")),
+    ]
+)
+
+
+def set_fields(job_output):
+    """Names of the fields of a JobOutput that are set (non-empty or non-default)"""
+    return {field.name for field, _ in job_output.ListFields()}
+
+
+def split_job_output(job_output):
+    """JobOutputs a server sends for job_output when asked for partial outputs
+
+    Args:
+        job_output: Complete JobOutput protobuf message; it is not modified
+
+    Returns:
+        list: pb.JobOutput of each stage of STAGE_FIELDS with a field set, then the
+        final one with the remaining fields
+    """
+    remaining = pb.JobOutput()
+    remaining.CopyFrom(job_output)
+    present = set_fields(remaining)
+    frames = []
+    for stage, names in STAGE_FIELDS.items():
+        names = [name for name in names if name in present]
+        if not names:
+            continue
+        frame = pb.JobOutput(stage=stage)
+        for name in names:
+            values = getattr(remaining, name)
+            if isinstance(values, int):
+                setattr(frame, name, values)
+            else:
+                getattr(frame, name).extend(values)
+            remaining.ClearField(name)
+        frames.append(frame)
+    remaining.stage = FINAL
+    frames.append(remaining)
+    return frames
+
+
+def merge_job_output(merged, frame):
+    """Add the fields of a partial JobOutput to those of the earlier stages
+
+    Args:
+        merged: JobOutput of the earlier stages (modified in place), or None
+        frame: JobOutput of the next stage; it is not modified
+
+    Returns:
+        pb.JobOutput: merged, or a copy of frame if there were no earlier stages, so
+        later stages never change a frame handed out before
+    """
+    if merged is None:
+        merged = pb.JobOutput()
+        merged.CopyFrom(frame)
+        return merged
+    merged.MergeFrom(frame)
+    # MergeFrom skips the default FINAL
+    merged.stage = frame.stage
+    return merged
+
+
+class PartialFrame(object):
+    """One JobOutput of a job received in stages
+
+    Attributes:
+        stage (int): pb.JobOutput.OutputStage of the frame
+        job_output: JobOutput protobuf message holding the fields of the stage
+        arrays (JobOutputArrays): Repeated fields of job_output as NumPy arrays
+        fields (set): Names of the fields set in job_output
+    """
+
+    def __init__(self, job_output):
+        self.stage = job_output.stage
+        self.job_output = job_output
+        self.arrays = JobOutputArrays(job_output)
+        self.fields = set_fields(job_output)
+
+    def __repr__(self):
+        return "<PartialFrame {} {}>".format(
+            pb.JobOutput.OutputStage.Name(self.stage), sorted(self.fields)
+        )
+
+    @property
+    def final(self):
+        """True for the last JobOutput of the job"""
+        return self.stage == FINAL
+
+    def holds(self, name):
+        """Whether the frame holds a field (or its float32 copy)"""
+        return name in self.fields or FLOAT32_FIELDS.get(name) in self.fields
+
+    def value(self, name):
+        """Value of a field: a NumPy array for repeated numeric fields"""
+        try:
+            return self.arrays[name]
+        except KeyError:
+            return getattr(self.job_output, name)
+
+
+class PartialResults(object):
+    """Job on one client whose JobOutput arrives in stages
+
+    >>> results = client.compute_partial(atomic_input)
+    >>> for frame in results:
+    >>>     if frame.holds("gradient"):
+    >>>         start_propagation(frame.value("energy"), frame.value("gradient"))
+    >>> result = results.result()
+
+    Iterating polls the server and yields a PartialFrame whenever a JobOutput
+    arrives, the final one last. Other threads may wait on field() futures while one
+    thread iterates or calls result(); the client must not be used for anything else
+    until the job is done.
+    """
+
+    def __init__(self, client, atomic_input, raw_arrays=False):
+        """Initialize a PartialResults object.
+
+        Args:
+            client: Connected TCProtobufClient running the job
+            atomic_input: Input of the computation
+            raw_arrays (bool): Keep NumPy arrays in the AtomicResult (see
+                utils.job_output_to_atomic_result)
+        """
+        self.client = client
+        self.atomic_input = atomic_input
+        self.raw_arrays = raw_arrays
+        self.frames = []
+        self.job_output = None
+        self.timings = None
+        self._job_input = None
+        self._futures = {}
+        self._result = None
+        self._intervals = None
+        self._done = False
+        self._error = None
+        # Futures of fields not received yet; each is taken out under the lock by the
+        # one thread that resolves it, outside the lock
+        self._pending = {}
+        # Guards frames, the futures and _done against field() calls from other
+        # threads
+        self._lock = threading.Lock()
+
+    def start(self):
+        """Submit the job, retrying until the server accepts it
+
+        Returns:
+            PartialResults: self
+        """
+        if self.timings is not None:
+            return self
+        client = self.client
+        self.timings = client.job_timings = JobTimings(client.hooks)
+        try:
+            self._job_input = atomic_input_to_job_input(self.atomic_input)
+            cached = client._cached_output(self._job_input)
+            if cached is not None:
+                self.timings.cached = True
+                self.timings.lap("input")
+                self._receive(cached)
+                self._finish(cached)
+                return self
+
+            job_input = pb.JobInput()
+            job_input.CopyFrom(client._apply_guess(self._job_input))
+            job_input.partial_outputs = True
+            self.timings.lap("input")
+            intervals = client._poll_intervals()
+            while not client.send_job_input_async(job_input):
+                sleep(next(intervals))
+            client._partial_listener = self._receive
+            self._intervals = client._poll_intervals()
+        except BaseException as e:
+            self._fail(e)
+            raise
+        return self
+
+    def __iter__(self):
+        self.start()
+        index = 0
+        while True:
+            while index < len(self.frames):
+                yield self.frames[index]
+                index += 1
+            if self._done:
+                return
+            self._poll()
+
+    def _poll(self):
+        """Poll the server once, receiving any JobOutput that follows"""
+        client = self.client
+        received = len(self.frames)
+        try:
+            if client.check_job_complete():
+                self._finish(client._recv_job_output())
+            elif len(self.frames) > received:
+                # Stages keep coming; poll again right away
+                self._intervals = client._poll_intervals()
+            else:
+                sleep(next(self._intervals))
+        except BaseException as e:
+            self._fail(e)
+            raise
+
+    def field(self, name):
+        """Future resolving to a JobOutput field as soon as the JobOutput holding it
+        arrives
+
+        Args:
+            name (str): JobOutput field name, e.g. "energy" or "ci_vec_re"
+
+        Returns:
+            concurrent.futures.Future: Resolves to the value (a NumPy array for
+            repeated numeric fields); fields the job does not return resolve to their
+            empty or default value once the job is done
+        """
+        if name not in pb.JobOutput.DESCRIPTOR.fields_by_name:
+            raise ValueError("JobOutput has no field {}".format(name))
+        with self._lock:
+            future = self._futures.get(name)
+            if future is not None:
+                return future
+            future = self._futures[name] = Future()
+            frame = next((f for f in self.frames if f.holds(name)), None)
+            error = self._error
+            if frame is None and self._done and error is None:
+                frame = PartialFrame(self.job_output)
+            elif frame is None and not self._done:
+                # Resolved by _receive() or _finish()
+                self._pending[name] = future
+        if frame is not None:
+            future.set_result(frame.value(name))
+        elif error is not None:
+            future.set_exception(error)
+        return future
+
+    def result(self):
+        """AtomicResult of the job, waiting for the rest of its JobOutputs
+
+        Returns:
+            AtomicResult: Result of the merged JobOutput, with its timings in
+            extras["timings"]
+        """
+        for _ in self:
+            pass
+        return self._result
+
+    def _receive(self, job_output):
+        """Keep a JobOutput received by the client and resolve its fields' futures"""
+        frame = PartialFrame(job_output)
+        with self._lock:
+            self.frames.append(frame)
+            ready = [name for name in self._pending if frame.holds(name)]
+            futures = [(name, self._pending.pop(name)) for name in ready]
+        for name, future in futures:
+            future.set_result(frame.value(name))
+
+    def _finish(self, job_output):
+        """Build the AtomicResult from the merged JobOutput"""
+        client = self.client
+        client._partial_listener = None
+        client.job_timings = None
+        self.job_output = job_output
+        if not self.timings.cached:
+            client._record_output(self._job_input, job_output)
+        result = job_output_to_atomic_result(
+            atomic_input=self.atomic_input,
+            job_output=job_output,
+            raw_arrays=self.raw_arrays,
+        )
+        self.timings.lap("output")
+        client._finish_timings(self.timings)
+        result.extras["timings"] = self.timings.to_dict()
+        self._result = result
+        with self._lock:
+            self._done = True
+            futures = list(self._pending.items())
+            self._pending.clear()
+        merged = PartialFrame(job_output)
+        for name, future in futures:
+            future.set_result(merged.value(name))
+
+    def _fail(self, error):
+        """Stop listening to the client and fail the futures still waiting"""
+        self.client._partial_listener = None
+        self.client.job_timings = None
+        with self._lock:
+            self._done = True
+            self._error = error
+            futures = list(self._pending.values())
+            self._pending.clear()
+        for future in futures:
+            future.set_exception(error)
@@ -0,0 +1,519 @@
+"""Dispatch computations across several TeraChem Protocol Buffer servers
+
+Each server in the pool is driven by its own worker thread holding a persistent
+TCProtobufClient connection. Workers pull jobs from a shared queue whenever their
+server is idle, so jobs always go to the next free server.
+"""
+
+import logging
+import queue
+import threading
+from concurrent.futures import Future
+from time import sleep
+from typing import Iterable, Iterator, List, Tuple
+
+from qcelemental.models import AtomicInput, AtomicResult
+
+from .cache import ResultCache
+from .exceptions import ServerError, TCPBError
+from .hessian import DEFAULT_STEP, HessianJob
+from .overlap import CIOverlapBatch, CIOverlapJob, overlap_pairs
+from .scheduler import JobScheduler
+from .tcpb import TCProtobufClient
+from .utils import atomic_input_to_job_input, job_output_to_atomic_result
+
+logger = logging.getLogger(__name__)
+
+# Markers for as_completed() bookkeeping
+_FEED_DONE = object()
+_FEED_ERROR = object()
+# Placeholder for "no job queued" while a worker still has output to convert
+_NO_JOB = object()
+
+# Server states reported by TCPBPool.server_states()
+IDLE = "idle"
+BUSY = "busy"
+DOWN = "down"
+
+
+class _PoolJob(object):
+    """A queued computation and the Future its result is delivered to"""
+
+    def __init__(
+        self, atomic_input, job_input_msg, raw_arrays, priority=0, affinity=None
+    ):
+        self.atomic_input = atomic_input
+        self.job_input_msg = job_input_msg
+        self.raw_arrays = raw_arrays
+        self.priority = priority
+        self.affinity = affinity
+        self.future = Future()
+        self.started = False
+        self.failures = 0
+        # Set by the JobScheduler when first queued
+        self.cost = None
+        self.sort_key = None
+        self.queued_at = None
+
+
+class _ServerWorker(threading.Thread):
+    """Runs queued jobs on one TeraChem server until told to stop or the server fails"""
+
+    def __init__(self, pool, host, port, client_options):
+        super(_ServerWorker, self).__init__(
+            name="tcpb-pool-{}:{}".format(host, port), daemon=True
+        )
+        self.pool = pool
+        self.client = TCProtobufClient(host, port, **client_options)
+        self.state = IDLE
+
+    def run(self):
+        try:
+            self.client.connect()
+        except Exception as e:
+            self.pool._server_failed(self, None, e)
+            return
+
+        self._busy_intervals = self.client._poll_intervals()
+        # Job whose output has been received but not yet converted to an AtomicResult
+        finished = None
+        while True:
+            if finished is None:
+                job = self.pool._queue.get(self)
+            else:
+                try:
+                    job = self.pool._queue.get_nowait(self)
+                except queue.Empty:
+                    job = _NO_JOB
+            if job is None:
+                break
+
+            # Any error (ServerError, a malformed message, a failed reconnect) takes
+            # the server out of rotation so the job is retried elsewhere or failed
+            # rather than left unresolved
+            try:
+                accepted = job is not _NO_JOB and self._start(job)
+            except Exception as e:
+                self._deliver(finished)
+                self.pool._server_failed(self, job, e)
+                return
+
+            # Convert the previous output while the server works on the next job
+            self._deliver(finished)
+            finished = None
+
+            if not accepted:
+                if job is not _NO_JOB and job.started:
+                    # Server is running a job for another client; let another
+                    # server take this job and back off
+                    sleep(next(self._busy_intervals))
+                continue
+
+            try:
+                self.client.wait_for_job_complete()
+                finished = (job, self.client.recv_job_output())
+                self.client._record_output(job.job_input_msg, finished[1])
+            except Exception as e:
+                self.pool._server_failed(self, job, e)
+                return
+            self.state = IDLE
+
+        self._deliver(finished)
+        self.client.disconnect()
+
+    def _start(self, job):
+        """Submit a job to the server
+
+        Returns:
+            bool: True if the server accepted the job, False if it was cancelled or
+            requeued because the server is busy
+        """
+        if not job.started:
+            if not job.future.set_running_or_notify_cancel():
+                return False
+            job.started = True
+
+        if not self.client.send_job_input_async(
+            self.client._apply_guess(job.job_input_msg)
+        ):
+            self.state = BUSY
+            # The job may run on another server; its timings start over there
+            self.client.job_timings = None
+            self.pool._queue.put(job)
+            return False
+
+        self._busy_intervals = self.client._poll_intervals()
+        self.state = BUSY
+        return True
+
+    @staticmethod
+    def _deliver(finished):
+        """Convert a received JobOutput and resolve its job's Future"""
+        if finished is None:
+            return
+        job, job_output = finished
+        if job.atomic_input is None:
+            # Submitted as a JobInput
+            job.future.set_result(job_output)
+            return
+        try:
+            result = job_output_to_atomic_result(
+                atomic_input=job.atomic_input,
+                job_output=job_output,
+                raw_arrays=job.raw_arrays,
+            )
+        except Exception as e:
+            job.future.set_exception(e)
+        else:
+            job.future.set_result(result)
+
+
+class TCPBPool(object):
+    """Pool of persistent connections to TeraChem Protocol Buffer servers
+
+    >>> with TCPBPool([("node1", 11111), ("node2", 11111)]) as pool:
+    >>>     futures = [pool.submit(atomic_input) for atomic_input in inputs]
+    >>>     results = [future.result() for future in futures]
+
+    Servers that raise a ServerError (or fail otherwise, e.g. with a malformed
+    message) are taken out of rotation and the job they were running is handed to
+    another server. Queued jobs go to idle servers in the order
+    chosen by the pool's JobScheduler (see tcpb.scheduler), FIFO by default.
+    """
+
+    def __init__(self, endpoints, max_failures=2, scheduler=None, **client_options):
+        """Initialize a TCPBPool object.
+
+        Args:
+            endpoints: List of (host, port) tuples of TeraChem servers
+            max_failures (int): Number of server failures a single job may cause
+                before its ServerError is returned to the caller
+            scheduler: JobScheduler, or the name of a scheduling policy ("fifo",
+                "shortest" or "longest"), ordering the queued jobs
+            **client_options: Keyword arguments passed to each TCProtobufClient. With
+                guess_cache=True every server keeps its own guesses; pass one GuessCache
+                to share guesses between servers that can read each other's scratch
+                directories. A result_cache is shared by all servers, and cached
+                results are returned by submit() without going to a server
+        """
+        if not endpoints:
+            raise ValueError("TCPBPool needs at least one (host, port) endpoint")
+
+        result_cache = client_options.get("result_cache")
+        if result_cache is not None and not isinstance(result_cache, ResultCache):
+            client_options["result_cache"] = ResultCache(result_cache)
+        self._result_cache = client_options.get("result_cache")
+
+        self.max_failures = max_failures
+        if not isinstance(scheduler, JobScheduler):
+            scheduler = JobScheduler(scheduler or "fifo")
+        self._queue = scheduler
+        self._lock = threading.Lock()
+        self._workers = [
+            _ServerWorker(self, host, port, client_options) for host, port in endpoints
+        ]
+        self._started = False
+
+    def __enter__(self):
+        self.start()
+        return self
+
+    def __exit__(self, type, value, traceback):
+        self.shutdown()
+
+    def start(self):
+        """Connect to all servers and start dispatching jobs"""
+        with self._lock:
+            if self._started:
+                return
+            self._started = True
+        for worker in self._workers:
+            worker.start()
+
+    def shutdown(self, wait=True):
+        """Stop dispatching and disconnect from all servers.
+
+        Args:
+            wait (bool): If True, block until every job already submitted has finished
+        """
+        error = TCPBError("TCPBPool was shut down")
+        if not wait:
+            self._fail_queued(error)
+        for worker in self._live_workers():
+            self._queue.put(None)
+        if wait:
+            for worker in self._workers:
+                if worker.is_alive():
+                    worker.join()
+            # Jobs requeued by busy servers after the stop signals went out
+            self._fail_queued(error)
+
+    def submit(
+        self,
+        atomic_input: AtomicInput,
+        raw_arrays: bool = False,
+        priority: int = 0,
+        affinity=None,
+        job_input=None,
+    ) -> Future:
+        """Queue a computation to run on the next idle server
+
+        Inputs with the "hessian" driver are computed by submit_hessian().
+
+        Args:
+            atomic_input: Input of the computation
+            raw_arrays: If True, array results are returned as NumPy arrays (see
+                utils.job_output_to_atomic_result)
+            priority: Priority class; jobs of higher classes are dispatched first
+            affinity: Hashable key (e.g. a trajectory id); jobs sharing it run on the
+                server that ran the previous one, which holds its orbital guess
+            job_input: JobInput to send instead of the conversion of atomic_input
+                (e.g. from a JobInputTemplate); atomic_input still describes the result
+
+        Returns:
+            concurrent.futures.Future: Future resolving to the AtomicResult
+        """
+        if atomic_input.driver == "hessian" and job_input is None:
+            return self.submit_hessian(
+                atomic_input,
+                raw_arrays=raw_arrays,
+                priority=priority,
+                affinity=affinity,
+            )
+        if job_input is None:
+            job_input = atomic_input_to_job_input(atomic_input)
+        return self._submit_job(
+            _PoolJob(atomic_input, job_input, raw_arrays, priority, affinity)
+        )
+
+    def submit_job_input(self, job_input, priority: int = 0, affinity=None) -> Future:
+        """Queue a JobInput to run on the next idle server
+
+        Args:
+            job_input: JobInput protobuf message
+            priority: Priority class; jobs of higher classes are dispatched first
+            affinity: Hashable key of jobs to keep on the same server (see submit())
+
+        Returns:
+            concurrent.futures.Future: Future resolving to the JobOutput
+        """
+        return self._submit_job(_PoolJob(None, job_input, False, priority, affinity))
+
+    def _submit_job(self, job):
+        """Queue a _PoolJob, resolving it from the result cache if possible"""
+        self.start()
+        if self._result_cache is not None:
+            cached = self._result_cache.get(job.job_input_msg)
+            if cached is not None:
+                _ServerWorker._deliver((job, cached))
+                return job.future
+        with self._lock:
+            if not self._live_workers():
+                job.future.set_exception(
+                    TCPBError("All TeraChem servers in the pool are down")
+                )
+                return job.future
+            self._queue.put(job)
+        return job.future
+
+    def submit_hessian(
+        self,
+        atomic_input: AtomicInput,
+        step: float = DEFAULT_STEP,
+        reuse_guess: bool = True,
+        use_server_hessian: bool = True,
+        raw_arrays: bool = False,
+        priority: int = 0,
+        affinity=None,
+    ) -> Future:
+        """Compute the Hessian of an input with gradients spread across the pool
+
+        The server's own Hessian is used if it returns one; otherwise the 6N gradients
+        of displaced geometries run on all servers and the Hessian is assembled by
+        central differences (see tcpb.hessian). The result has the "hessian" driver,
+        the Hessian as return_result and the harmonic frequencies in
+        extras["hessian"]["frequencies"].
+
+        Args:
+            atomic_input: Input of the computation; its driver is ignored
+            step: Displacement of the finite differences (bohr)
+            reuse_guess: Start the displaced gradients from the orbitals of the
+                reference geometry (servers must be able to read each other's scratch
+                directories)
+            use_server_hessian: Ask the server for its Hessian first
+            raw_arrays: If True, array qcvars are returned as NumPy arrays
+            priority: Priority class of the gradient jobs
+            affinity: Affinity key of the reference gradient
+
+        Returns:
+            concurrent.futures.Future: Future resolving to the AtomicResult
+        """
+        return HessianJob(
+            self,
+            atomic_input,
+            step=step,
+            reuse_guess=reuse_guess,
+            use_server_hessian=use_server_hessian,
+            raw_arrays=raw_arrays,
+            priority=priority,
+            affinity=affinity,
+        ).start()
+
+    def submit_ci_overlaps(
+        self,
+        geoms,
+        cvecs,
+        orbs,
+        pairs=None,
+        window=None,
+        unitType="bohr",
+        jobs=None,
+        priority: int = 0,
+        **kwargs,
+    ) -> Future:
+        """Queue the CI vector overlaps of many pairs of frames (see tcpb.overlap)
+
+        The pairs are split into batch jobs sent to different servers; each job holds
+        the frames its pairs use once.
+
+        Args:
+            geoms: Geometry of each frame, flat or (natoms, 3)
+            cvecs: CI vector of each frame (see TCProtobufClient.compute_ci_overlap())
+            orbs: Alpha MO coefficients of each frame as returned by
+                serial_utils.read_orbfile
+            pairs: (i, j) frame indices of the overlaps to compute
+            window: Without pairs, overlap each frame with this many frames before it
+                (all pairs if None)
+            unitType: Unit type key, as defined in the pb.Mol.UnitType enum
+            jobs (int): Number of batch jobs (one per live server by default)
+            priority: Priority class of the jobs
+            **kwargs: TeraChem keywords, as for TCProtobufClient.compute_ci_overlaps()
+
+        Returns:
+            concurrent.futures.Future: Future resolving to the (num_pairs, num_states,
+            num_states) ndarray of overlaps
+        """
+        template = TCProtobufClient.job_template("ci_vec_overlap", unitType, **kwargs)
+        batch = CIOverlapBatch(template, geoms, cvecs, orbs)
+        if pairs is None:
+            pairs = overlap_pairs(batch.nframes, window)
+        return CIOverlapJob(self, batch, pairs, jobs=jobs, priority=priority).start()
+
+    def compute(
+        self, atomic_input: AtomicInput, raw_arrays: bool = False
+    ) -> AtomicResult:
+        """Run a computation on the next idle server and wait for its result"""
+        return self.submit(atomic_input, raw_arrays).result()
+
+    def as_completed(
+        self, atomic_inputs: Iterable[AtomicInput], raw_arrays: bool = False
+    ) -> Iterator[Tuple[int, AtomicResult]]:
+        """Run many computations across the pool, yielding results as they complete
+
+        Inputs are converted to JobInputs and queued from a background thread, so
+        conversion overlaps with jobs already running on the servers.
+
+        Args:
+            atomic_inputs: Iterable of inputs
+            raw_arrays: If True, array results are returned as NumPy arrays
+
+        Yields:
+            tuple: (index of the input in atomic_inputs, AtomicResult) in completion order
+
+        Raises:
+            Any exception raised converting an input or running its job; jobs already
+            queued keep running
+        """
+        completed = queue.Queue()
+
+        def feed():
+            count = 0
+            try:
+                for index, atomic_input in enumerate(atomic_inputs):
+                    future = self.submit(atomic_input, raw_arrays)
+                    future.add_done_callback(
+                        lambda future, index=index: completed.put((index, future))
+                    )
+                    count += 1
+            except Exception as e:
+                completed.put((_FEED_ERROR, e))
+            completed.put((_FEED_DONE, count))
+
+        threading.Thread(target=feed, name="tcpb-pool-feeder", daemon=True).start()
+
+        total = None
+        nyielded = 0
+        while total is None or nyielded < total:
+            index, item = completed.get()
+            if index is _FEED_ERROR:
+                raise item
+            elif index is _FEED_DONE:
+                total = item
+            else:
+                nyielded += 1
+                yield index, item.result()
+
+    def compute_many(
+        self, atomic_inputs: Iterable[AtomicInput], raw_arrays: bool = False
+    ) -> List[AtomicResult]:
+        """Run many computations across the pool and wait for all of them
+
+        Args:
+            atomic_inputs: Iterable of inputs
+            raw_arrays: If True, array results are returned as NumPy arrays
+
+        Returns:
+            list: AtomicResults in the same order as atomic_inputs
+        """
+        results = {}
+        for index, result in self.as_completed(atomic_inputs, raw_arrays):
+            results[index] = result
+        return [results[index] for index in range(len(results))]
+
+    def server_states(self):
+        """Current state of every server in the pool
+
+        Returns:
+            dict: Mapping of (host, port) to "idle", "busy" or "down"
+        """
+        return {worker.client.tcaddr: worker.state for worker in self._workers}
+
+    def _live_workers(self):
+        return [worker for worker in self._workers if worker.state != DOWN]
+
+    def _server_failed(self, worker, job, error):
+        """Take a failed server out of rotation and reschedule or fail its job"""
+        # Not str(error): that reads the job logfile of a ServerError, which is left
+        # to whoever reports the error
+        message = error.args[0] if error.args else type(error).__name__
+        logger.error(
+            "Removing TeraChem server {} from pool: {}".format(
+                worker.client.tcaddr, message
+            )
+        )
+        self._queue.forget(worker)
+        with self._lock:
+            worker.state = DOWN
+            no_servers_left = not self._live_workers()
+            if job is not None:
+                job.failures += 1
+                if job.failures >= self.max_failures or no_servers_left:
+                    job.future.set_exception(error)
+                else:
+                    self._queue.put(job)
+        try:
+            worker.client.disconnect()
+        except Exception:
+            pass
+        if no_servers_left:
+            self._fail_queued(TCPBError("All TeraChem servers in the pool are down"))
+
+    def _fail_queued(self, error):
+        """Fail every job still waiting in the queue"""
+        while True:
+            try:
+                job = self._queue.get_nowait()
+            except queue.Empty:
+                return
+            if job is not None and not job.future.done():
+                job.future.set_exception(error)
@@ -0,0 +1,299 @@
+"""Order in which TCPBPool hands queued jobs to its servers
+
+With a plain FIFO queue a mixed workload of small energies and large TDDFT/CASCI
+jobs may leave big jobs stuck behind each other on one server while others idle.
+A JobScheduler picks, for every server asking for work, the next job by priority
+class and then by policy, using a cost estimated from the JobInput; jobs sharing an
+affinity key (e.g. the frames of one trajectory) stay on the server that ran the
+previous one, where its orbital guess is warm.
+"""
+
+import heapq
+import queue
+import threading
+from collections import OrderedDict
+from itertools import count
+from math import factorial
+from time import monotonic
+
+from . import terachem_server_pb2 as pb
+
+# Scheduling policies
+FIFO = "fifo"  # Submission order
+SHORTEST_FIRST = "shortest"  # Cheapest jobs first, minimizing the mean wait
+LONGEST_FIRST = "longest"  # Most expensive first, packing big jobs across servers
+POLICIES = (FIFO, SHORTEST_FIRST, LONGEST_FIRST)
+
+# Affinity keys whose server a JobScheduler remembers
+DEFAULT_MAX_AFFINITY_KEYS = 4096
+
+# Basis functions of (H/He, Li-Ne) atoms for common basis sets; heavier atoms count
+# _HEAVY_ATOM_FACTOR times the Li-Ne value
+_BASIS_FUNCTIONS = {
+    "sto-3g": (1, 5),
+    "3-21g": (2, 9),
+    "6-31g": (2, 9),
+    "6-31g*": (2, 15),
+    "6-31gs": (2, 15),
+    "6-31g**": (5, 15),
+    "6-31gss": (5, 15),
+    "6-31+g*": (2, 19),
+    "6-311g": (3, 13),
+    "6-311g**": (6, 18),
+    "cc-pvdz": (5, 14),
+    "aug-cc-pvdz": (9, 23),
+    "cc-pvtz": (14, 30),
+    "aug-cc-pvtz": (23, 46),
+    "def2-svp": (5, 14),
+    "def2-tzvp": (6, 31),
+}
+_DEFAULT_BASIS_FUNCTIONS = (5, 15)
+_SECOND_ROW = {"Li", "Be", "B", "C", "N", "O", "F", "Ne"}
+_HEAVY_ATOM_FACTOR = 1.5
+
+# Relative cost of run types and methods
+_RUN_FACTORS = {
+    pb.JobInput.RunType.ENERGY: 1.0,
+    pb.JobInput.RunType.GRADIENT: 2.0,
+    pb.JobInput.RunType.COUPLING: 3.0,
+    pb.JobInput.RunType.TDCI: 10.0,
+    pb.JobInput.RunType.CI_VEC_OVERLAP: 0.5,
+}
+_METHOD_FACTORS = {
+    pb.JobInput.MethodType.HF: 1.0,
+    pb.JobInput.MethodType.GFNXTB: 0.01,
+    pb.JobInput.MethodType.GFN2XTB: 0.01,
+}
+_DFT_FACTOR = 1.5
+
+
+def _is_yes(value):
+    return value.lower() in ("yes", "true", "1")
+
+
+def _int_option(options, key, default=0):
+    try:
+        return int(options.get(key, default))
+    except ValueError:
+        return default
+
+
+def basis_size(job_input):
+    """Estimated number of basis functions of a JobInput
+
+    Args:
+        job_input: JobInput protobuf message
+
+    Returns:
+        float: Basis functions, from per-atom counts of the basis set
+    """
+    light, heavy = _BASIS_FUNCTIONS.get(
+        job_input.basis.lower().replace(" ", ""), _DEFAULT_BASIS_FUNCTIONS
+    )
+    nbf = 0.0
+    for atom in job_input.mol.atoms:
+        symbol = atom.capitalize()
+        if symbol in ("H", "He"):
+            nbf += light
+        elif symbol in _SECOND_ROW:
+            nbf += heavy
+        else:
+            nbf += heavy * _HEAVY_ATOM_FACTOR
+    return nbf
+
+
+def estimate_cost(job_input):
+    """Relative cost of a JobInput for scheduling
+
+    The cost grows with the cube of the basis size, scaled by the run type, by DFT
+    over HF (semiempirical methods are nearly free), and by the number of CIS or
+    CAS states and the size of the CAS active space. Only the ordering of costs is
+    meaningful, not their unit.
+
+    Args:
+        job_input: JobInput protobuf message
+
+    Returns:
+        float: Estimated cost
+    """
+    cost = basis_size(job_input) ** 3
+    cost *= _RUN_FACTORS.get(job_input.run, 1.0)
+    cost *= _METHOD_FACTORS.get(job_input.method, _DFT_FACTOR)
+
+    options = dict(zip(job_input.user_options[::2], job_input.user_options[1::2]))
+    if _is_yes(options.get("cis", "no")):
+        cost *= 1 + _int_option(options, "cisnumstates", 1)
+    if _is_yes(options.get("casci", "no")) or _is_yes(options.get("casscf", "no")):
+        nstates = sum(
+            _int_option(options, key)
+            for key in ("cassinglets", "casdoublets", "castriplets", "casquartets")
+        )
+        active = _int_option(options, "active", 2)
+        alpha = active // 2
+        determinants = (
+            factorial(active) // (factorial(alpha) * factorial(active - alpha))
+        ) ** 2
+        cost *= (1 + max(nstates, 1)) * (1 + determinants / 1e4)
+    return cost
+
+
+class JobScheduler(object):
+    """Queue of TCPBPool jobs handing each idle server the job it should run next
+
+    >>> pool = TCPBPool(endpoints, scheduler=JobScheduler(LONGEST_FIRST))
+    >>> pool.submit(big_input, priority=1)
+    >>> pool.submit(frame_input, affinity="trajectory-3")
+
+    Jobs of a higher priority class always go first; within a class the policy
+    orders them: FIFO by submission, SHORTEST_FIRST by increasing and LONGEST_FIRST
+    by decreasing estimated cost. A job with an affinity key waits for the server
+    that ran the last job of that key, as long as the server is up; with steal_after
+    any other server may take the next job of the key once it has waited that many
+    seconds. Only the max_affinity_keys keys run most recently are remembered (least
+    recently used first out), so a long-running pool fed a new key per trajectory or
+    frame does not grow without bound; a job of a forgotten key goes to any server.
+    The mapping is not dropped when a key's queue empties, as the next frame of a
+    trajectory is often submitted only after the previous one finished.
+
+    Jobs are kept in one heap per affinity key (and one for jobs without), ordered
+    by priority class, policy and submission, so handing out a job costs a look at
+    the head of each heap and one pop rather than a scan of the whole queue.
+
+    The queue interface (put(), get(), get_nowait()) is the one TCPBPool workers use;
+    None put into the queue tells the next worker without work left to stop.
+    """
+
+    # _select() result when no job may run (None is the key of jobs without affinity)
+    _NONE = object()
+
+    def __init__(
+        self,
+        policy=FIFO,
+        steal_after=None,
+        cost=estimate_cost,
+        max_affinity_keys=DEFAULT_MAX_AFFINITY_KEYS,
+    ):
+        """Initialize a JobScheduler object.
+
+        Args:
+            policy (str): FIFO, SHORTEST_FIRST or LONGEST_FIRST
+            steal_after (float): Seconds after which a job may run on another server
+                than the one holding its affinity key (None waits for that server)
+            cost: Function estimating the cost of a JobInput
+            max_affinity_keys (int): Number of affinity keys whose server is
+                remembered
+        """
+        if policy not in POLICIES:
+            raise ValueError(
+                "Unknown scheduling policy {!r}; choose from {}".format(
+                    policy, POLICIES
+                )
+            )
+        self.policy = policy
+        self.steal_after = steal_after
+        self.cost = cost
+        self.max_affinity_keys = max_affinity_keys
+        # Affinity key (None for jobs without) -> heap of (sort key, job)
+        self._heaps = {}
+        self._size = 0
+        self._stops = 0
+        # Server (worker) that last ran a job of each affinity key, least recently
+        # used first
+        self._affinity = OrderedDict()
+        self._counter = count()
+        self._cond = threading.Condition()
+
+    def __len__(self):
+        with self._cond:
+            return self._size
+
+    def _sort_key(self, job):
+        if self.policy == FIFO:
+            order = 0.0
+        else:
+            if job.cost is None:
+                job.cost = self.cost(job.job_input_msg)
+            order = job.cost if self.policy == SHORTEST_FIRST else -job.cost
+        return (-job.priority, order, next(self._counter))
+
+    def put(self, job):
+        """Queue a job, or a stop signal (None) for one worker"""
+        with self._cond:
+            if job is None:
+                self._stops += 1
+            else:
+                # Jobs requeued by busy servers keep their place
+                if job.sort_key is None:
+                    job.sort_key = self._sort_key(job)
+                    job.queued_at = monotonic()
+                heap = self._heaps.setdefault(job.affinity, [])
+                heapq.heappush(heap, (job.sort_key, job))
+                self._size += 1
+            self._cond.notify_all()
+
+    def get(self, worker=None, block=True):
+        """Next job for a worker
+
+        Args:
+            worker: Worker asking for a job; None takes any job regardless of affinity
+            block (bool): Wait until a job is available
+
+        Returns:
+            Job to run, or None if the worker should stop
+
+        Raises:
+            queue.Empty: block is False and there is nothing for the worker
+        """
+        with self._cond:
+            while True:
+                key, wait = self._select(worker)
+                if key is not self._NONE:
+                    heap = self._heaps[key]
+                    _, job = heapq.heappop(heap)
+                    if not heap:
+                        del self._heaps[key]
+                    self._size -= 1
+                    if job.affinity is not None and worker is not None:
+                        self._affinity[job.affinity] = worker
+                        self._affinity.move_to_end(job.affinity)
+                        while len(self._affinity) > self.max_affinity_keys:
+                            self._affinity.popitem(last=False)
+                    return job
+                if self._stops:
+                    self._stops -= 1
+                    return None
+                if not block:
+                    raise queue.Empty
+                self._cond.wait(wait)
+
+    def get_nowait(self, worker=None):
+        """Next job for a worker without waiting (see get())"""
+        return self.get(worker, block=False)
+
+    def forget(self, worker):
+        """Release the affinity keys of a worker whose server went down"""
+        with self._cond:
+            for key in [k for k, w in self._affinity.items() if w is worker]:
+                del self._affinity[key]
+            self._cond.notify_all()
+
+    def _select(self, worker):
+        """Affinity key of the heap holding the best job the worker may run (_NONE if
+        there is none) and, if some job may be taken later, the seconds until then"""
+        now = monotonic()
+        best = self._NONE
+        best_sort_key = None
+        wait = None
+        for key, heap in self._heaps.items():
+            sort_key, job = heap[0]
+            owner = self._affinity.get(key)
+            if worker is not None and owner is not None and owner is not worker:
+                if self.steal_after is None:
+                    continue
+                remaining = job.queued_at + self.steal_after - now
+                if remaining > 0:
+                    wait = remaining if wait is None else min(wait, remaining)
+                    continue
+            if best_sort_key is None or sort_key < best_sort_key:
+                best, best_sort_key = key, sort_key
+        return best, wait
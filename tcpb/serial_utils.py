@@ -5,25 +5,64 @@ from __future__ import absolute_import, division, print_function
 
 import numpy as np
 
+# Bytes converted per chunk when an array has to be copied on its way to disk
+_WRITE_CHUNK_BYTES = 64 * 1024 * 1024
 
-def read_orbfile(orbfile, num_rows, num_cols):
+
+def _is_column_major_orbfile(orbfile):
+    """HF/DFT orbital files (c0, ca0, cb0) are stored column-major by TeraChem"""
+    return orbfile.endswith("c0") or orbfile.endswith("ca0") or orbfile.endswith("cb0")
+
+
+def _read_doubles(filename, num_rows, num_cols, mmap_mode):
+    """Read a (num_rows, num_cols) row-major array of doubles, memory-mapped if requested"""
+    if mmap_mode is None:
+        return np.fromfile(filename, dtype=np.float64).reshape((num_rows, num_cols))
+    return np.memmap(
+        filename, dtype=np.float64, mode=mmap_mode, shape=(num_rows, num_cols)
+    )
+
+
+def _write_doubles(array, filename):
+    """Write an array of doubles to filename in row-major order
+
+    Arrays that are already contiguous doubles are written straight from their
+    buffer. Anything else (other dtypes, transposed views) is converted a chunk of rows
+    at a time, so peak memory stays bounded instead of copying the whole array.
+    """
+    if array.dtype == np.float64 and array.flags.c_contiguous:
+        array.tofile(filename)
+        return
+
+    rows = array.reshape(-1, 1) if array.ndim < 2 else array
+    # From the shape rather than rows[0], which empty arrays do not have
+    row_bytes = max(int(np.prod(rows.shape[1:])) * 8, 1)
+    chunk = max(_WRITE_CHUNK_BYTES // row_bytes, 1)
+    with open(filename, "wb") as f:
+        for start in range(0, len(rows), chunk):
+            block = rows[start : start + chunk]
+            np.ascontiguousarray(block, dtype=np.float64).tofile(f)
+
+
+def read_orbfile(orbfile, num_rows, num_cols, mmap_mode=None):
     """Deserialize a TeraChem binary orbital file of doubles.
 
     HF/DFT orbitals (which are stored column-major for TeraChem) are transposed on deserialization.
+    The transpose is a view, no data is copied.
 
     Args:
         orbfile: Filename of orbital file to read
         num_rows: Rows in MO coefficient matrix
         num_cols: Columns in MO coefficient matrix
+        mmap_mode: If None, the file is read into memory; otherwise a mode for np.memmap
+            ("r", "r+" or "c") and a view of the memory-mapped file is returned
 
     Returns:
         (num_rows, num_cols): NumPy array of MO coefficients
     """
-    orbs = np.fromfile(orbfile, dtype=np.float64)
+    orbs = _read_doubles(orbfile, num_rows, num_cols, mmap_mode)
 
-    orbs = orbs.reshape((num_rows, num_cols))
-
-    if orbfile.endswith("c0") or orbfile.endswith("ca0") or orbfile.endswith("cb0"):
+    if _is_column_major_orbfile(orbfile):
         orbs = orbs.transpose()
 
     return orbs
@@ -43,38 +82,32 @@ def write_orbfile(orbs, orbfile):
             "Need a shaped NumPy array for write_orbfile to do proper serialization for TeraChem."
         )
 
-    if orbfile.endswith("c0") or orbfile.endswith("ca0") or orbfile.endswith("cb0"):
+    if _is_column_major_orbfile(orbfile):
         orbs = orbs.transpose()
 
-    orbs.astype(np.float64).tofile(orbfile)
+    _write_doubles(orbs, orbfile)
 
 
-def read_ci_vector(cvecfile, num_rows, num_cols):
+def read_ci_vector(cvecfile, num_rows, num_cols, mmap_mode=None):
     """Deserialize a TeraChem binary CI vector file of doubles.
 
     Args:
         cvecfile: Filename of CI vector file to read
         num_rows: Rows in CI vector
         num_cols: Columns in CI vector matrix
+        mmap_mode: If None, the file is read into memory; otherwise a mode for np.memmap
+            ("r", "r+" or "c") and the memory-mapped file is returned
     Returns a (num_rows, num_cols) NumPy array of MO coefficients
     """
-    ci_vector = np.fromfile(cvecfile, dtype=np.float64)
-
-    return ci_vector.reshape((num_rows, num_cols))
+    return _read_doubles(cvecfile, num_rows, num_cols, mmap_mode)
 
 
-# NOTE: Commented out because it appears unfunctional. Looks for variable "orbs"
-# but it is never declared. Preserving function for now...
-# def write_ci_vector(ci_vector, orbfile):
-#     """Serialize a TeraChem binary CI vector file of doubles.
+def write_ci_vector(ci_vector, cvecfile):
+    """Serialize a TeraChem binary CI vector file of doubles.
 
-#     Args:
-#         ci_vector: Non-flat NumPy array of CI vector
-#         cvecfile: Filename of CI vector file to write
-#     """
-#     if not isinstance(orbs, np.ndarray) or len(orbs.shape) != 2:
-#         raise SyntaxError(
-#             "Need a shaped NumPy array for write_cvecfile to do proper serialization for TeraChem."
-#         )
-
-#     ci_vector.astype(np.float64).tofile(orbfile)
+    Args:
+        ci_vector: CI vector as a NumPy array or any object supporting the buffer protocol
+            (e.g. a memory-mapped file); contiguous doubles are written without a copy
+        cvecfile: Filename of CI vector file to write
+    """
+    _write_doubles(np.asarray(ci_vector), cvecfile)
@@ -0,0 +1,141 @@
+"""Repeated computations on one system at changing geometries
+
+Dynamics and optimizations run thousands of jobs that differ from each other only in
+their coordinates. A Session converts and serializes the JobInput of its template
+once; each step appends the new coordinates (and run type and orbital guess) as
+encoded fields to those bytes, which the server merges into the template (see
+tcpb.wire), so no protobuf message is built or serialized per step.
+"""
+
+from time import sleep
+
+import numpy as np
+
+from . import terachem_server_pb2 as pb
+from .guess import GuessCache
+from .utils import atomic_input_to_job_input, repeated_to_array
+from .wire import encode_length_delimited, encode_packed_array, encode_varint_field
+
+_DOUBLE = np.dtype("<f8")
+
+
+class Session(object):
+    """Series of jobs on the system of a template AtomicInput
+
+    >>> with TCProtobufClient(host, port) as client:
+    >>>     session = client.session(atomic_input)
+    >>>     for step in range(nsteps):
+    >>>         gradient = session.gradient(xyz)
+    >>>         ...
+
+    Every job uses the molecule, charge, multiplicity, model and keywords of the
+    template; only the geometry and run type change. With reuse_guess, each job
+    starts from the orbitals of the previous one unless the template sets a "guess"
+    keyword itself.
+    """
+
+    def __init__(self, client, atomic_input, reuse_guess=True):
+        """Initialize a Session object.
+
+        Args:
+            client: Connected TCProtobufClient running the jobs
+            atomic_input: Template AtomicInput (the driver sets the default run type)
+            reuse_guess (bool): Start every job from the orbitals of the previous one
+        """
+        self.client = client
+        self.template = atomic_input_to_job_input(atomic_input.copy(deep=True))
+        self.natoms = len(self.template.mol.atoms)
+        has_guess = "guess" in self.template.user_options[::2]
+        self.reuse_guess = reuse_guess and not has_guess
+        self.last_output = None
+
+        template = pb.JobInput()
+        template.CopyFrom(self.template)
+        del template.mol.xyz[:]
+        self._template_str = template.SerializeToString()
+        self._guess_str = b""
+
+    def job_input_bytes(self, xyz, run=None):
+        """Serialized JobInput of a step
+
+        Args:
+            xyz: Coordinates in bohr, of shape (natoms, 3) or flat
+            run: pb.JobInput.RunType of the job (the template's by default)
+
+        Returns:
+            bytes: JobInput the server parses as the template with these coordinates
+        """
+        xyz = np.asarray(xyz, dtype=_DOUBLE).ravel()
+        if xyz.size != 3 * self.natoms:
+            raise ValueError(
+                "Geometry has {} coordinates; expected {} for {} atoms".format(
+                    xyz.size, 3 * self.natoms, self.natoms
+                )
+            )
+        mol_str = encode_packed_array(pb.Mol.XYZ_FIELD_NUMBER, xyz, _DOUBLE)
+        parts = [
+            self._template_str,
+            encode_length_delimited(pb.JobInput.MOL_FIELD_NUMBER, mol_str),
+            self._guess_str,
+        ]
+        if run is not None:
+            parts.append(encode_varint_field(pb.JobInput.RUN_FIELD_NUMBER, run))
+        return b"".join(parts)
+
+    def run(self, xyz, run=None):
+        """Run one job at a new geometry
+
+        Args:
+            xyz: Coordinates in bohr, of shape (natoms, 3) or flat
+            run: pb.JobInput.RunType of the job (the template's by default)
+
+        Returns:
+            pb.JobOutput: Output of the job, also kept in last_output
+        """
+        return self._run_bytes(self.job_input_bytes(xyz, run))
+
+    def _run_bytes(self, msg_str):
+        """Run the job of a serialized JobInput and remember its orbitals"""
+        client = self.client
+        intervals = client._poll_intervals()
+        while not client.send_job_input_async(msg_str):
+            sleep(next(intervals))
+        client.wait_for_job_complete()
+        job_output = client.recv_job_output()
+
+        if self.reuse_guess:
+            guess = GuessCache._guess_option(self.template, job_output)
+            if guess is not None:
+                self._guess_str = b"".join(
+                    encode_length_delimited(
+                        pb.JobInput.USER_OPTIONS_FIELD_NUMBER, value.encode("utf-8")
+                    )
+                    for value in ("guess", guess)
+                )
+        self.last_output = job_output
+        return job_output
+
+    def energy(self, xyz):
+        """Ground state energy at a new geometry
+
+        Args:
+            xyz: Coordinates in bohr, of shape (natoms, 3) or flat
+
+        Returns:
+            float: Energy in hartree
+        """
+        return self.run(xyz, pb.JobInput.RunType.ENERGY).energy[0]
+
+    def gradient(self, xyz):
+        """Gradient at a new geometry
+
+        The energy of the same job is available as last_output.energy[0].
+
+        Args:
+            xyz: Coordinates in bohr, of shape (natoms, 3) or flat
+
+        Returns:
+            np.ndarray: Gradient of shape (natoms, 3) in hartree/bohr
+        """
+        job_output = self.run(xyz, pb.JobInput.RunType.GRADIENT)
+        return repeated_to_array(job_output.gradient).reshape(-1, 3)
@@ -0,0 +1,213 @@
+"""Shared memory transport for clients on the same host as their TeraChem server
+
+Over loopback TCP every message body is copied through the kernel twice. When both
+ends share a host, the client creates a POSIX shared memory segment at connect() and
+offers its name to the server in a Status (see the Status message). If the server
+maps it, headers and small bodies still go over the socket, but bodies of at least
+SHM_THRESHOLD bytes (JobOutputs, JobInputs with inline orbitals or CI vectors) are
+written to the segment: the header on the socket sets SHM_FLAG in its message type
+and is followed by a 16 byte descriptor (<QQ: position, size) instead of the body.
+
+Segment layout: a 64 byte control block, then one ring of (size - 64) / 2 bytes for
+each direction, client to server first. Positions are running byte counts, so a body
+at position p starts at byte p % ring size of its ring; bodies never wrap around the
+end of a ring (the writer skips to the start instead). Each reader stores, as a little
+endian uint64 in the control block (offset 0 for the client to server ring, 8 for the
+other), the position up to which it is done with its ring; a writer only writes into
+space the reader is done with and sends the body over the socket otherwise.
+"""
+
+import os
+import struct
+
+from .framing import HEADER_FORMAT, SHM_FLAG
+
+try:
+    from multiprocessing import shared_memory
+except ImportError:  # Python < 3.8
+    shared_memory = None
+
+# Bodies smaller than this go over the socket
+SHM_THRESHOLD = 64 * 1024
+
+# Default size of the shared memory segment
+DEFAULT_SHM_SIZE = 256 * 1024 * 1024
+
+CONTROL_SIZE = 64
+DESCRIPTOR_FORMAT = "<QQ"
+DESCRIPTOR_SIZE = struct.calcsize(DESCRIPTOR_FORMAT)
+
+# Offsets in the control block of the read positions of each ring
+_CLIENT_TO_SERVER_READ = 0
+_SERVER_TO_CLIENT_READ = 8
+_POSITION_FORMAT = "<Q"
+
+
+class SharedMemoryChannel(object):
+    """One end of a shared memory segment carrying large message bodies
+
+    >>> channel = SharedMemoryChannel()
+    >>> header, body = channel.place(*serialize_msg(pb.JOBINPUT, job_input))
+    >>> payload = channel.receive(descriptor)
+    >>> channel.release()
+
+    The client creates the segment; a server (or a stand-in for one) attaches to it by
+    name and uses the rings the other way around.
+    """
+
+    def __init__(self, size=DEFAULT_SHM_SIZE, threshold=SHM_THRESHOLD, name=None):
+        """Initialize a SharedMemoryChannel object, creating its segment.
+
+        Args:
+            size (int): Size of the segment in bytes
+            threshold (int): Smallest body size in bytes sent through the segment
+            name (str): Name of an existing segment to attach to as the server end
+                instead of creating one
+
+        Raises:
+            ValueError: Shared memory is not available in this Python or the size is
+                too small
+        """
+        if shared_memory is None:
+            raise ValueError("Shared memory transport requires Python 3.8 or newer")
+        self.ring_size = (size - CONTROL_SIZE) // 2
+        if self.ring_size < threshold:
+            raise ValueError(
+                "Shared memory segment of {} bytes is too small for bodies of {} "
+                "bytes".format(size, threshold)
+            )
+        self.threshold = threshold
+        self.owner = name is None
+        if self.owner:
+            self._shm = shared_memory.SharedMemory(create=True, size=size)
+        else:
+            self._shm = shared_memory.SharedMemory(name=name)
+        self.name = self._shm.name
+        self.size = size
+        self._buf = self._shm.buf
+        middle = CONTROL_SIZE + self.ring_size
+        rings = [
+            self._buf[CONTROL_SIZE:middle],
+            self._buf[middle : middle + self.ring_size],
+        ]
+        if self.owner:
+            self._buf[:CONTROL_SIZE] = bytes(CONTROL_SIZE)
+            self._send_ring, self._recv_ring = rings
+            self._peer_read = _CLIENT_TO_SERVER_READ
+            self._own_read = _SERVER_TO_CLIENT_READ
+        else:
+            self._recv_ring, self._send_ring = rings
+            self._peer_read = _SERVER_TO_CLIENT_READ
+            self._own_read = _CLIENT_TO_SERVER_READ
+        self._write_position = 0
+        # Position up to which the last received body extends
+        self._pending_release = None
+        self.bodies_sent = 0
+        self.bodies_received = 0
+
+    def _position(self, offset):
+        return struct.unpack_from(_POSITION_FORMAT, self._buf, offset)[0]
+
+    def place(self, header, msg_str):
+        """Move a body into the segment if it is large enough and there is room
+
+        Args:
+            header: 8 byte header of the message, as from framing.serialize_msg()
+            msg_str: Body of the message
+
+        Returns:
+            tuple: (header, body) to send over the socket: the header with SHM_FLAG
+            and a descriptor, or the arguments unchanged
+        """
+        size = len(msg_str)
+        if size < self.threshold or size > self.ring_size:
+            return header, msg_str
+        position = self._write_position
+        if position % self.ring_size + size > self.ring_size:
+            # Skip the tail of the ring rather than splitting the body
+            position += self.ring_size - position % self.ring_size
+        read = self._position(self._peer_read)
+        if position + size - read > self.ring_size:
+            # The other end has not finished reading earlier bodies
+            return header, msg_str
+
+        start = position % self.ring_size
+        self._send_ring[start : start + size] = msg_str
+        self._write_position = position + size
+        self.bodies_sent += 1
+        msg_type, _ = struct.unpack(HEADER_FORMAT, header)
+        return (
+            struct.pack(HEADER_FORMAT, msg_type | SHM_FLAG, DESCRIPTOR_SIZE),
+            struct.pack(DESCRIPTOR_FORMAT, position, size),
+        )
+
+    def receive(self, descriptor):
+        """Body sent by the other end through the segment
+
+        The body is a view into the segment; call release() once it has been parsed
+        so the other end may reuse its space.
+
+        Args:
+            descriptor: 16 byte descriptor received in place of the body
+
+        Returns:
+            memoryview: The body
+        """
+        if len(descriptor) != DESCRIPTOR_SIZE:
+            raise ValueError(
+                "Shared memory descriptor of {} bytes instead of {}".format(
+                    len(descriptor), DESCRIPTOR_SIZE
+                )
+            )
+        position, size = struct.unpack(DESCRIPTOR_FORMAT, descriptor)
+        start = position % self.ring_size
+        if size > self.ring_size or start + size > self.ring_size:
+            raise ValueError(
+                "Shared memory body of {} bytes at {} is outside the ring".format(
+                    size, position
+                )
+            )
+        self._pending_release = position + size
+        self.bodies_received += 1
+        return self._recv_ring[start : start + size]
+
+    def release(self):
+        """Tell the other end the last received body has been read"""
+        if self._pending_release is not None:
+            struct.pack_into(
+                _POSITION_FORMAT, self._buf, self._own_read, self._pending_release
+            )
+            self._pending_release = None
+
+    def close(self):
+        """Unmap the segment, and remove it if this end created it"""
+        if self._shm is None:
+            return
+        # Views must be released before the segment can be closed
+        self._send_ring.release()
+        self._recv_ring.release()
+        self._buf = None
+        try:
+            self._shm.close()
+        except BufferError:
+            # A received body is still referenced; the mapping goes with it
+            pass
+        if self.owner:
+            try:
+                self._shm.unlink()
+            except FileNotFoundError:
+                pass
+        self._shm = None
+
+
+def same_host(host):
+    """Whether a server host name refers to this machine
+
+    Only such servers are offered a shared memory segment; others could not map it.
+    """
+    if host in ("localhost", "127.0.0.1", "::1"):
+        return True
+    try:
+        return host in (os.uname().nodename, os.uname().nodename.split(".")[0])
+    except AttributeError:  # Windows
+        return False
@@ -11,49 +11,213 @@ Second 4 bytes: int32 of packet size (not including the header)
 from __future__ import absolute_import, division, print_function
 
 import logging
+import random
+import select
 import socket
-import struct
-from time import sleep
+from contextlib import contextmanager
+from time import perf_counter, sleep
 
 import numpy as np
 from qcelemental.models import AtomicInput, AtomicResult
 
-from tcpb.utils import atomic_input_to_job_input, job_output_to_atomic_result
+from tcpb.utils import (
+    atomic_input_to_job_input,
+    job_output_to_atomic_result,
+    job_output_to_results_dict,
+)
 
 # Import the Protobuf messages generated from the .proto file
 from . import terachem_server_pb2 as pb
 from .exceptions import ServerError
-from .molden_constructor import tcpb_imd_fields2molden_string
+from .cache import ResultCache
+from .framing import (
+    HEADER_SIZE,
+    SHM_FLAG,
+    decompress_body,
+    pack_header,
+    parse_msg,
+    serialize_msg,
+    split_msg_type,
+    supported_compression,
+    unpack_header,
+)
+from .guess import GuessCache
+from .imd import IMDStream
+from .instrument import RECEIVED, SENT, JobTimings
+from .jobs import COMPLETED, PENDING, QUEUED, WORKING, JobHandle
+from .overlap import CIOverlapBatch, overlap_pairs
+from .partial import PartialResults, merge_job_output
+from .session import Session
+from .shm import DEFAULT_SHM_SIZE, SharedMemoryChannel, same_host
+from .template import PER_JOB_KEYWORDS, JobInputTemplate, TemplateCache, template_key
+from .trace import ReplayTransport, TraceStore
+from .wire import encode_packed_array
 
 
 logger = logging.getLogger(__name__)
 
+# JobInputTemplates of the keyword API, shared by all clients
+_JOB_TEMPLATES = TemplateCache()
+
+
+def poll_intervals(initial, maximum, backoff):
+    """Yield delays between successive polls of the server, growing geometrically
+
+    Short jobs are picked up almost immediately while long jobs are not flooded
+    with Status requests.
+
+    Args:
+        initial (float): First delay in seconds
+        maximum (float): Upper bound on the delay in seconds
+        backoff (float): Factor the delay is multiplied by after every poll
+    """
+    interval = initial
+    while True:
+        yield interval
+        interval = min(interval * backoff, maximum)
+
+
+def enable_keepalive(sock, idle):
+    """Turn on TCP keepalive probes on a socket
+
+    A peer that stops answering (e.g. a crashed node) is detected after about twice
+    idle seconds, where the operating system supports tuning the probes.
+
+    Args:
+        sock: Connected socket
+        idle (float): Seconds without traffic before the first probe
+    """
+    sock.setsockopt(socket.SOL_SOCKET, socket.SO_KEEPALIVE, 1)
+    idle = max(int(idle), 1)
+    for name, value in (
+        ("TCP_KEEPIDLE", idle),
+        ("TCP_KEEPINTVL", max(idle // 3, 1)),
+        ("TCP_KEEPCNT", 3),
+    ):
+        option = getattr(socket, name, None)
+        if option is not None:
+            sock.setsockopt(socket.IPPROTO_TCP, option, value)
+
 
 class TCProtobufClient(object):
     """Connect and communicate with a TeraChem instance running in Protocol Buffer server mode
     (i.e. TeraChem was started with the -s|--server flag)
     """
 
-    def __init__(self, host, port, debug=False, trace=False):
+    def __init__(
+        self,
+        host,
+        port,
+        debug=False,
+        trace=False,
+        poll_interval=1e-4,
+        max_poll_interval=0.5,
+        poll_backoff=2.0,
+        guess_cache=None,
+        result_cache=None,
+        compression=False,
+        hooks=(),
+        replay=None,
+        connect_timeout=60.0,
+        read_timeout=60.0,
+        keepalive=None,
+        reconnect_attempts=0,
+        reconnect_interval=0.1,
+        max_reconnect_interval=5.0,
+        shared_memory=False,
+    ):
         """Initialize a TCProtobufClient object.
 
         Args:
             host (str): Hostname
             port (int): Port number (must be above 1023)
-            debug (bool): If True, assumes connections work (used for testing with no server)
-            trace (bool): If True, packets are saved to .bin files (which can then be used for testing)
+            debug (bool): If True, assumes connections work (used for testing with no server);
+                see replay to run the client code itself without a server
+            trace: If True, packets are saved to client_recv.bin and client_sent.bin; if a
+                TraceStore or directory, to its rotating, indexed segments (see tcpb.trace)
+            poll_interval (float): Initial delay in seconds between job status checks or resubmissions
+            max_poll_interval (float): Upper bound in seconds on the delay between polls
+            poll_backoff (float): Factor the delay grows by after every unsuccessful poll
+            guess_cache: If True or a GuessCache, compute() starts each job from the orbitals
+                of the nearest previous geometry of the same system (see tcpb.guess)
+            result_cache: ResultCache or directory; compute() returns results of identical
+                earlier inputs from it instead of running the job again (see tcpb.cache)
+            compression: If True or a list of codec names ("zstd", "lz4", "zlib"), offer
+                the server to compress large messages on connect (see tcpb.framing)
+            hooks: JobHooks notified of the messages, phases and timings of every job
+                (see tcpb.instrument)
+            replay: ReplayTransport, TraceReader or trace path; jobs are answered with the
+                recorded JobOutputs instead of connecting to a server (see tcpb.trace)
+            connect_timeout (float): Seconds to wait for a connection to the server
+            read_timeout (float): Seconds to wait on a single send or receive (None blocks)
+            keepalive (float): If set, seconds of idle connection before TCP keepalive
+                probes detect a dead server (see enable_keepalive)
+            reconnect_attempts (int): Number of times a failed connect is retried, also
+                used to reconnect before submitting a job over a dropped connection
+            reconnect_interval (float): Upper bound in seconds of the random delay before
+                the first retry, doubled after every failed one
+            max_reconnect_interval (float): Upper bound in seconds on that bound
+            shared_memory: If True or a segment size in bytes, offer a server on this
+                host to move large message bodies through shared memory instead of the
+                socket on connect (see tcpb.shm)
         """
         self.debug = debug
         self.trace = trace
-        if self.trace:
+        self.poll_interval = poll_interval
+        self.max_poll_interval = max_poll_interval
+        self.poll_backoff = poll_backoff
+        if guess_cache is True:
+            guess_cache = GuessCache()
+        elif guess_cache is False:
+            guess_cache = None
+        self.guess_cache = guess_cache
+        if result_cache is not None and not isinstance(result_cache, ResultCache):
+            result_cache = ResultCache(result_cache)
+        self.result_cache = result_cache
+        # Codecs offered to the server and the one it agreed to use on this connection
+        self.compression = supported_compression(compression) if compression else []
+        self.wire_compression = pb.Status.NO_COMPRESSION
+        self.hooks = list(hooks)
+        self.connect_timeout = connect_timeout
+        self.read_timeout = read_timeout
+        self.keepalive = keepalive
+        self.reconnect_attempts = reconnect_attempts
+        self.reconnect_interval = reconnect_interval
+        self.max_reconnect_interval = max_reconnect_interval
+        # Size of the shared memory segment to offer and the channel the server accepted
+        if shared_memory is True:
+            shared_memory = DEFAULT_SHM_SIZE
+        self.shared_memory = shared_memory or None
+        self.shm = None
+        # JobTimings of the job in flight and of the last finished job
+        self.job_timings = None
+        self.last_job_timings = None
+        # Partial JobOutputs of the job in flight, merged, and the PartialResults
+        # they are handed to as they arrive (see tcpb.partial)
+        self._partial_output = None
+        self._partial_listener = None
+        self.trace_store = None
+        if self.trace is True:
             self.intracefile = open("client_recv.bin", "wb")
             self.outtracefile = open("client_sent.bin", "wb")
+        elif self.trace:
+            if not isinstance(self.trace, TraceStore):
+                self.trace_store = TraceStore(self.trace)
+            else:
+                self.trace_store = self.trace
+        if replay is not None and not isinstance(replay, ReplayTransport):
+            replay = ReplayTransport(replay)
+        self.replay = replay
 
         # Socket options
         self.update_address(host, port)
         self.tcsock = None
-        # Would like to not hard code this, but the truth is I am expecting exactly 8 bytes, not whatever Python thinks 2 ints is
-        self.header_size = 8
+        self.header_size = HEADER_SIZE
+        # Receive buffers reused across messages; the body buffer grows on demand
+        self._header_buffer = bytearray(self.header_size)
+        self._header_view = memoryview(self._header_buffer)
+        self._recv_buffer = bytearray()
+        self._recv_view = memoryview(self._recv_buffer)
 
         self.prev_results = None
 
@@ -61,6 +225,9 @@ class TCProtobufClient(object):
         self.curr_job_scr_dir = None
         self.curr_job_id = None
 
+        # Handles of jobs from submit_job() that are pending or running
+        self._handles = []
+
     def __enter__(self):
         """
         Allow automatic context management using 'with' statement
@@ -100,17 +267,140 @@ class TCProtobufClient(object):
         self.tcaddr = (host, port)
 
     def connect(self):
-        """Connect to the TeraChem Protobuf server"""
+        """Connect to the TeraChem Protobuf server
+
+        Failed attempts are retried up to reconnect_attempts times after a random delay
+        below a bound growing from reconnect_interval to max_reconnect_interval, so
+        clients that lost the same server do not all retry at once.
+        """
         if self.debug:
             logging.info("in debug mode - assume connection established")
             return
 
+        if self.replay is not None:
+            # Recorded outputs stand in for the server
+            self.tcsock = self.replay
+        else:
+            intervals = poll_intervals(
+                self.reconnect_interval, self.max_reconnect_interval, 2.0
+            )
+            for attempt in range(self.reconnect_attempts + 1):
+                try:
+                    self.tcsock = self._open_socket()
+                    break
+                except socket.error as msg:
+                    if attempt == self.reconnect_attempts:
+                        raise ServerError(
+                            "Problem connecting to server: {}".format(msg), self
+                        )
+                    delay = random.uniform(0.0, next(intervals))
+                    logger.info(
+                        "Connecting to {} failed ({}); retrying in {:.3f} s".format(
+                            self.tcaddr, msg, delay
+                        )
+                    )
+                    sleep(delay)
+
+        self.wire_compression = pb.Status.NO_COMPRESSION
+        if self.compression:
+            self._negotiate_compression()
+        self._close_shared_memory()
+        self._partial_output = None
+        if (
+            self.shared_memory
+            and self.tcsock is not self.replay
+            and same_host(self.tcaddr[0])
+        ):
+            self._negotiate_shared_memory()
+
+    def _open_socket(self):
+        """Connected socket to the server with the configured timeouts and keepalive"""
+        sock = socket.create_connection(self.tcaddr, timeout=self.connect_timeout)
+        sock.settimeout(self.read_timeout)
+        if self.keepalive:
+            enable_keepalive(sock, self.keepalive)
+        return sock
+
+    def reconnect(self):
+        """Drop the connection, if any, and connect again (see connect())"""
+        if self.tcsock is not None and self.tcsock is not self.replay:
+            try:
+                self.tcsock.close()
+            except socket.error:
+                pass
+        self.tcsock = None
+        self.connect()
+
+    def is_alive(self):
+        """Cheap check that the connection to the server is still open
+
+        Unlike is_available(), no message is exchanged with the server: the socket is
+        only checked for a close or error reported by the peer (or by keepalive
+        probes), so this is safe to call before every job.
+
+        Returns:
+            bool: False if the client is not connected or the connection was lost
+        """
+        if self.debug or (self.replay is not None and self.tcsock is self.replay):
+            return True
+        if self.tcsock is None:
+            return False
         try:
-            self.tcsock = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
-            self.tcsock.settimeout(60.0)  # Timeout of 1 minute
-            self.tcsock.connect(self.tcaddr)
-        except socket.error as msg:
-            raise ServerError("Problem connecting to server: {}".format(msg), self)
+            readable, _, failed = select.select([self.tcsock], [], [self.tcsock], 0)
+            if failed:
+                return False
+            if readable:
+                # Readable while idle means closed, unless a message is waiting
+                return bool(self.tcsock.recv(1, socket.MSG_PEEK))
+        except (socket.error, ValueError):
+            return False
+        return True
+
+    def _negotiate_compression(self):
+        """Offer the configured codecs to the server and use the one it picks"""
+        self._send_msg(pb.STATUS, pb.Status(accept_compression=self.compression))
+        status = self._recv_msg(pb.STATUS)
+        if status.compression in self.compression:
+            self.wire_compression = status.compression
+        logger.debug(
+            "Server {} chose compression {}".format(
+                self.tcaddr, pb.Status.CompressionType.Name(self.wire_compression)
+            )
+        )
+
+    def _negotiate_shared_memory(self):
+        """Offer the server a shared memory segment and use it if the server maps it"""
+        try:
+            channel = SharedMemoryChannel(self.shared_memory)
+        except ValueError as e:
+            logger.warning("Not using shared memory: {}".format(e))
+            return
+        try:
+            self._send_msg(
+                pb.STATUS,
+                pb.Status(shared_memory=channel.name, shared_memory_size=channel.size),
+            )
+            status = self._recv_msg(pb.STATUS)
+        except Exception:
+            channel.close()
+            raise
+        if status.shared_memory_accepted:
+            self.shm = channel
+        else:
+            channel.close()
+        logger.debug(
+            "Server {} {} shared memory segment {}".format(
+                self.tcaddr,
+                "mapped" if self.shm is not None else "declined",
+                channel.name,
+            )
+        )
+
+    def _close_shared_memory(self):
+        """Remove the shared memory segment of the connection, if any"""
+        if self.shm is not None:
+            self.shm.close()
+            self.shm = None
 
     def disconnect(self):
         """Disconnect from the TeraChem Protobuf server"""
@@ -118,6 +408,10 @@ class TCProtobufClient(object):
             logging.info("in debug mode - assume disconnection worked")
             return
 
+        if self.trace_store is not None:
+            self.trace_store.flush()
+        self._close_shared_memory()
+
         try:
             self.tcsock.shutdown(2)  # Shutdown read and write
             self.tcsock.close()
@@ -146,28 +440,92 @@ class TCProtobufClient(object):
 
         return not status.busy
 
-    def compute(self, atomic_input: AtomicInput) -> AtomicResult:
-        """Top level method for performing computations with QCSchema inputs/outputs"""
-        # Create protobuf message
-        job_input_msg = atomic_input_to_job_input(atomic_input)
-        # Send message to server; retry until accepted
-        self._send_msg(pb.JOBINPUT, job_input_msg)
-        status = self._recv_msg(pb.STATUS)
-        while not status.accepted:
-            print("JobInput not accepted. Retrying...")
-            sleep(0.5)
-            self._send_msg(pb.JOBINPUT, job_input_msg)
-            status = self._recv_msg(pb.STATUS)
-        print(status)
-        while not self.check_job_complete():
-            sleep(0.5)
+    def compute(
+        self, atomic_input: AtomicInput, raw_arrays: bool = False
+    ) -> AtomicResult:
+        """Top level method for performing computations with QCSchema inputs/outputs
 
-        # job_output = self.recv_job_async()
-        job_output = self._recv_msg(pb.JOBOUTPUT)
-        # return job_output
-        return job_output_to_atomic_result(
-            atomic_input=atomic_input, job_output=job_output
-        )
+        Args:
+            atomic_input: Input of the computation
+            raw_arrays: If True, array results are returned as NumPy arrays (see
+                utils.job_output_to_atomic_result)
+        """
+        timings = self.job_timings = JobTimings(self.hooks)
+        try:
+            # Create protobuf message
+            job_input_msg = atomic_input_to_job_input(atomic_input)
+            job_output = self._cached_output(job_input_msg)
+            if job_output is None:
+                guessed_msg = self._apply_guess(job_input_msg)
+                timings.lap("input")
+                # Send message to server; retry until accepted
+                intervals = self._poll_intervals()
+                while not self.send_job_input_async(guessed_msg):
+                    logger.info("JobInput not accepted. Retrying...")
+                    sleep(next(intervals))
+                self.wait_for_job_complete()
+
+                job_output = self._recv_job_output()
+                self._record_output(job_input_msg, job_output)
+            else:
+                timings.cached = True
+                timings.lap("input")
+            result = job_output_to_atomic_result(
+                atomic_input=atomic_input, job_output=job_output, raw_arrays=raw_arrays
+            )
+        finally:
+            self.job_timings = None
+        timings.lap("output")
+        self._finish_timings(timings)
+        result.extras["timings"] = timings.to_dict()
+        return result
+
+    def session(self, atomic_input: AtomicInput, reuse_guess: bool = True) -> Session:
+        """Start a series of jobs on the system of atomic_input (see tcpb.session)
+
+        Args:
+            atomic_input: Template of the jobs; only the geometry changes between them
+            reuse_guess: Start every job from the orbitals of the previous one
+
+        Returns:
+            Session: Session running its jobs on this client
+        """
+        return Session(self, atomic_input, reuse_guess=reuse_guess)
+
+    def compute_partial(
+        self, atomic_input: AtomicInput, raw_arrays: bool = False
+    ) -> PartialResults:
+        """Submit a job asking for its results in stages as they become available
+
+        Energies arrive first, then gradients and couplings, then everything else
+        (see tcpb.partial); servers that cannot split their output send it at once.
+
+        Args:
+            atomic_input: Input of the computation
+            raw_arrays: If True, array results are returned as NumPy arrays (see
+                utils.job_output_to_atomic_result)
+
+        Returns:
+            PartialResults: Iterate over it for each part of the output, or wait on
+            its field() futures and result()
+        """
+        return PartialResults(self, atomic_input, raw_arrays=raw_arrays).start()
+
+    def imd_stream(
+        self, atomic_input: AtomicInput, history: int = 2, orbital_type="WHOLE_C"
+    ) -> IMDStream:
+        """Start an interactive MD run on the system of atomic_input (see tcpb.imd)
+
+        Args:
+            atomic_input: Template of the QM region; only the geometry changes
+            history: Number of frames kept in the history ring buffer
+            orbital_type: pb.JobInput.ImdOrbitalType name of the orbitals to continue
+                from, unless the template sets imd_orbital_type
+
+        Returns:
+            IMDStream: Stream running its frames on this client
+        """
+        return IMDStream(self, atomic_input, history=history, orbital_type=orbital_type)
 
     def send_job_async(self, jobType="energy", geom=None, unitType="bohr", **kwargs):
         """Pack and send the current JobInput to the TeraChem Protobuf server asynchronously.
@@ -182,6 +540,20 @@ class TCProtobufClient(object):
         Returns:
             bool: True on job acceptance, False on server busy, and errors out if communication fails
         """
+        geom = self._validate_job_args(jobType, geom, unitType)
+
+        if self.debug:
+            logging.info("in debug mode - assume job completed")
+            return True
+
+        # Job setup
+        job_input_msg = self._create_job_input_msg(jobType, geom, unitType, **kwargs)
+
+        return self.send_job_input_async(job_input_msg)
+
+    @staticmethod
+    def _validate_job_args(jobType, geom, unitType):
+        """Check job and unit types and return geometry flattened for a JobInput"""
         if jobType.upper() not in list(pb.JobInput.RunType.keys()):
             raise ValueError(
                 "Job type specified is not available in this version of the TCPB client\n"
@@ -196,43 +568,122 @@ class TCProtobufClient(object):
                 "Unit type specified is not available in this version of the TCPB client\n"
                 "Allowed unit types: {}".format(list(pb.Mol.UnitType.keys()))
             )
+        return geom
 
-        if self.debug:
-            logging.info("in debug mode - assume job completed")
-            return True
+    def send_job_input_async(self, job_input_msg):
+        """Send an already constructed JobInput to the TeraChem Protobuf server asynchronously.
 
-        # Job setup
-        job_input_msg = self._create_job_input_msg(jobType, geom, unitType, **kwargs)
+        Args:
+            job_input_msg: JobInput protobuf message or its serialized bytes
 
+        Returns:
+            bool: True on job acceptance, False on server busy, and errors out if communication fails
+        """
+        if self.job_timings is None:
+            # Resubmissions of a rejected JobInput count as part of the same job
+            self.job_timings = JobTimings(self.hooks)
+        if (
+            self.reconnect_attempts
+            and not self._jobs_in_flight()
+            and not self.is_alive()
+        ):
+            logger.info("Connection to {} lost; reconnecting".format(self.tcaddr))
+            self.reconnect()
         self._send_msg(pb.JOBINPUT, job_input_msg)
 
         status_msg = self._recv_msg(pb.STATUS)
+        logger.debug("JobInput status:\n%s", status_msg)
 
         if status_msg.WhichOneof("job_status") == "accepted":
             self._set_status(status_msg)
+            self.job_timings.lap("queue")
 
             return True
         else:
             return False
 
+    def _jobs_in_flight(self):
+        """True if jobs from submit_job() are running on the current connection"""
+        return any(handle.state in (QUEUED, WORKING) for handle in self._handles)
+
     def _set_status(self, status_msg: pb.Status):
         """Sets status on self if job is accepted"""
         self.curr_job_dir = status_msg.job_dir
         self.curr_job_scr_dir = status_msg.job_scr_dir
         self.curr_job_id = status_msg.server_job_id
 
-    def _create_job_input_msg(self, jobType, geom, unitType="bohr", **kwargs):
+    def _clear_status(self):
+        """Wipes job status on self once the job output is received"""
+        self.curr_job_dir = None
+        self.curr_job_scr_dir = None
+        self.curr_job_id = None
+
+    def _apply_guess(self, job_input_msg):
+        """JobInput to send, with a cached orbital guess added if there is one"""
+        if self.guess_cache is None:
+            return job_input_msg
+        return self.guess_cache.apply(job_input_msg)
+
+    def _cached_output(self, job_input_msg):
+        """JobOutput of an identical earlier job from the result cache, or None"""
+        if self.result_cache is None:
+            return None
+        return self.result_cache.get(job_input_msg)
+
+    def _record_output(self, job_input_msg, job_output):
+        """Remember the output of a finished job in the guess and result caches"""
+        if self.guess_cache is not None:
+            self.guess_cache.record(job_input_msg, job_output)
+        if self.result_cache is not None:
+            self.result_cache.put(job_input_msg, job_output)
+
+    def _finish_timings(self, timings):
+        """Complete the timings of a finished job and keep them as last_job_timings"""
+        timings.finish()
+        self.last_job_timings = timings
+
+    def _poll_intervals(self):
+        """Delays between polls using this client's polling settings"""
+        return poll_intervals(
+            self.poll_interval, self.max_poll_interval, self.poll_backoff
+        )
+
+    @staticmethod
+    def _create_job_input_msg(jobType, geom, unitType="bohr", **kwargs):
         """Method for setting up jobs according to old mechanism
 
-        Refactored this method out to allow for better testing
+        Refactored this method out to allow for better testing and for reuse by
+        AsyncTCProtobufClient
         """
-        job_input_msg = pb.JobInput()
-        job_input_msg.run = pb.JobInput.RunType.Value(jobType.upper())
-        job_input_msg.mol.xyz.extend(geom)
-        job_input_msg.mol.units = pb.Mol.UnitType.Value(unitType.upper())
+        template = TCProtobufClient.job_template(jobType, unitType, **kwargs)
+        return template.job_input(geom, geom2=kwargs.get("geom2"))
 
-        self._process_kwargs(job_input_msg, **kwargs)
-        return job_input_msg
+    @staticmethod
+    def job_template(jobType="energy", unitType="bohr", **kwargs):
+        """JobInputTemplate of a job of the old mechanism without its geometries
+
+        Templates are cached by their arguments, so a series of jobs differing only
+        in geom/geom2 converts and validates the keywords once (see tcpb.template).
+
+        Args:
+            jobType:    Job type key, as defined in the pb.JobInput.RunType enum
+            unitType:   Unit type key, as defined in the pb.Mol.UnitType enum
+            **kwargs:   TeraChem keywords, check _process_kwargs for behaviour;
+                        geom and geom2 are ignored
+
+        Returns:
+            JobInputTemplate: Template to build the JobInput of each geometry from
+        """
+        options = {k: v for k, v in kwargs.items() if k not in PER_JOB_KEYWORDS}
+
+        def build():
+            job_input_msg = pb.JobInput()
+            job_input_msg.run = pb.JobInput.RunType.Value(jobType.upper())
+            job_input_msg.mol.units = pb.Mol.UnitType.Value(unitType.upper())
+            TCProtobufClient._process_kwargs(job_input_msg, **options)
+            return JobInputTemplate(job_input_msg)
+
+        return _JOB_TEMPLATES.get(template_key(jobType, unitType, **options), build)
 
     def check_job_complete(self):
         """Pack and send a Status message to the TeraChem Protobuf server asynchronously.
@@ -243,7 +694,7 @@ class TCProtobufClient(object):
         Returns:
             bool: True if job is completed, False otherwise
         """
-        print("Checking jobs status...")
+        logger.debug("Checking job status...")
         if self.debug:
             logging.info("in debug mode - assume check_job_complete is True")
             return True
@@ -253,10 +704,16 @@ class TCProtobufClient(object):
 
         # Receive Status
         status = self._recv_msg(pb.STATUS)
+        if self.job_timings is not None:
+            self.job_timings.polls += 1
+        if status.partial_output:
+            self._recv_partial_output()
 
         if status.WhichOneof("job_status") == "completed":
+            if self.job_timings is not None:
+                self.job_timings.lap("compute")
             return True
-        elif status.WhichOneof("job_status") == "working":
+        elif status.WhichOneof("job_status") in ("working", "queued"):
             return False
         else:
             raise ServerError(
@@ -264,6 +721,53 @@ class TCProtobufClient(object):
                 self,
             )
 
+    def wait_for_job_complete(self):
+        """Block until the submitted job is completed, polling with check_job_complete().
+
+        The delay between polls starts at poll_interval and grows by poll_backoff up to
+        max_poll_interval, so short jobs do not pay a fixed latency floor.
+        """
+        for interval in self._poll_intervals():
+            if self.check_job_complete():
+                return
+            sleep(interval)
+
+    def recv_job_output(self):
+        """Recv the JobOutput message of a completed job (i.e. check_job_complete() returned true)
+        without any conversion.
+
+        Returns:
+            pb.JobOutput: Output of the job
+        """
+        job_output = self._recv_job_output()
+        timings, self.job_timings = self.job_timings, None
+        if timings is not None:
+            self._finish_timings(timings)
+        return job_output
+
+    def _recv_partial_output(self):
+        """Recv the partial JobOutput following a Status with partial_output set"""
+        job_output = self._recv_msg(pb.JOBOUTPUT)
+        if self._partial_listener is not None:
+            self._partial_listener(job_output)
+        self._partial_output = merge_job_output(self._partial_output, job_output)
+
+    def _recv_job_output(self):
+        """Recv the JobOutput of a completed job, leaving the job timings running
+
+        Partial JobOutputs received while the job ran are merged into it.
+        """
+        job_output = self._recv_msg(pb.JOBOUTPUT)
+        if self._partial_listener is not None:
+            self._partial_listener(job_output)
+        if self._partial_output is not None:
+            job_output = merge_job_output(self._partial_output, job_output)
+            self._partial_output = None
+        self._clear_status()
+        if self.job_timings is not None:
+            self.job_timings.lap("receive")
+        return job_output
+
     def recv_job_async(self):
         """Recv and unpack a JobOutput message from the TeraChem Protobuf server asynchronously.
         This function expects the job to be ready (i.e. check_job_complete() returned true),
@@ -295,7 +799,8 @@ class TCProtobufClient(object):
 
         Additional (optional) members of results:
 
-        * bond_order:         # of atoms by # of atoms NumPy array of doubles
+        * bond_order:         # of atoms by # of atoms NumPy array of doubles (of
+                              float32 if the job was run with float32=True)
 
         Available per job type:
 
@@ -316,124 +821,204 @@ class TCProtobufClient(object):
         * cis_transition_dipoles:   # of excited state combinations (N(N-1)/2) list of flat 3-element NumPy arrays (default includeded with 'cis yes', or explicitly with 'cistransdipole yes', units a.u.)
                                     Order given lexically (e.g. 0->1, 0->2, 1->2 for 2 states)
 
+        * timings:            Timings of the job (see tcpb.instrument and last_job_timings)
+
         Returns:
             dict: Results as described above
         """
-        output = self._recv_msg(pb.JOBOUTPUT)
-
-        # Parse output into normal python dictionary
-        results = {
-            "atoms": np.array(output.mol.atoms, dtype="S2"),
-            "geom": np.array(output.mol.xyz, dtype=np.float64).reshape(-1, 3),
-            "charges": np.array(output.charges, dtype=np.float64),
-            "spins": np.array(output.spins, dtype=np.float64),
-            "dipole_moment": output.dipoles[3],
-            "dipole_vector": np.array(output.dipoles[:3], dtype=np.float64),
-            "job_dir": output.job_dir,
-            "job_scr_dir": output.job_scr_dir,
-            "server_job_id": output.server_job_id,
-        }
-
-        if len(output.energy):
-            results["energy"] = output.energy[0]
-
-        if output.mol.closed is True:
-            results["orbfile"] = output.orb1afile
-
-            results["orb_energies"] = np.array(output.orba_energies)
-            results["orb_occupations"] = np.array(output.orba_occupations)
+        output = self._recv_job_output()
+        timings, self.job_timings = self.job_timings, None
+        results = job_output_to_results_dict(output)
+        if timings is not None:
+            timings.lap("output")
+            self._finish_timings(timings)
+            results["timings"] = timings.to_dict()
+
+        # Save results for user access later
+        self.prev_results = results
+
+        return results
+
+    # Multiple outstanding jobs
+    def submit_job(self, job_input):
+        """Submit a job without waiting for the jobs submitted before it
+
+        Unlike send_job_input_async(), several jobs may be outstanding on one server:
+        servers that queue jobs accept them all at once, otherwise the next pending job
+        is submitted as soon as the output of the previous one is received (see
+        tcpb.jobs). Do not mix with the single-job methods on the same connection while
+        jobs are outstanding.
+
+        Args:
+            job_input: AtomicInput or JobInput protobuf message
+
+        Returns:
+            JobHandle: Handle to follow the job and collect its output with
+        """
+        timings = JobTimings(self.hooks)
+        if isinstance(job_input, AtomicInput):
+            handle = JobHandle(atomic_input_to_job_input(job_input), job_input, timings)
         else:
-            results["orbfile_a"] = output.orb1afile
-            results["orbfile_b"] = output.orb1bfile
+            handle = JobHandle(job_input, timings=timings)
 
-            results["orb_energies_a"] = np.array(output.orba_energies)
-            results["orb_occupations_a"] = np.array(output.orba_occupations)
-            results["orb_energies_b"] = np.array(output.orbb_energies)
-            results["orb_occupations_b"] = np.array(output.orbb_occupations)
+        cached = self._cached_output(handle.job_input)
+        timings.lap("input")
+        if cached is not None:
+            timings.cached = True
+            self._complete_handle(handle, cached)
+            return handle
 
-        if len(output.gradient):
-            results["gradient"] = np.array(output.gradient, dtype=np.float64).reshape(
-                -1, 3
-            )
+        self._handles.append(handle)
+        self._submit_pending()
+        return handle
 
-        if len(output.nacme):
-            results["nacme"] = np.array(output.nacme, dtype=np.float64).reshape(-1, 3)
+    def poll_job(self, handle):
+        """Ask the server for the status of an accepted job, receiving its output once
+        completed
 
-        if len(output.cas_transition_dipole):
-            results["cas_transition_dipole"] = np.array(
-                output.cas_transition_dipole, dtype=np.float64
-            )
+        Args:
+            handle: JobHandle returned by submit_job()
 
-        if len(output.cas_energy_states):
-            results["energy"] = np.array(
-                output.energy[: len(output.cas_energy_states)], dtype=np.float64
-            )
-            results["cas_energy_labels"] = list(
-                zip(output.cas_energy_states, output.cas_energy_mults)
-            )
+        Returns:
+            str: State of the job (see tcpb.jobs)
+        """
+        if handle.state in (PENDING, COMPLETED):
+            return handle.state
 
-        if len(output.bond_order):
-            nAtoms = len(output.mol.atoms)
-            results["bond_order"] = np.array(
-                output.bond_order, dtype=np.float64
-            ).reshape(nAtoms, nAtoms)
+        with self._job_context(handle):
+            self._send_msg(pb.STATUS, pb.Status(server_job_id=handle.server_job_id))
+            status = self._recv_msg(pb.STATUS)
+            handle.timings.polls += 1
+            if status.server_job_id and status.server_job_id != handle.server_job_id:
+                raise ServerError(
+                    "Requested status of job {} and got status of job {}".format(
+                        handle.server_job_id, status.server_job_id
+                    ),
+                    self,
+                )
 
-        if len(output.ci_overlaps):
-            results["ci_overlap"] = np.array(
-                output.ci_overlaps, dtype=np.float64
-            ).reshape(output.ci_overlap_size, output.ci_overlap_size)
+            if status.partial_output:
+                handle.partial_output = merge_job_output(
+                    handle.partial_output, self._recv_msg(pb.JOBOUTPUT)
+                )
 
-        if output.cis_states > 0:
-            results["energy"] = np.array(
-                output.energy[: output.cis_states + 1], dtype=np.float64
-            )
-            results["cis_states"] = output.cis_states
-
-            if len(output.cis_unrelaxed_dipoles):
-                uDips = []
-                for i in range(output.cis_states):
-                    uDips.append(
-                        np.array(
-                            output.cis_unrelaxed_dipoles[4 * i : 4 * i + 3],
-                            dtype=np.float64,
-                        )
-                    )
-                results["cis_unrelaxed_dipoles"] = uDips
-
-            if len(output.cis_relaxed_dipoles):
-                rDips = []
-                for i in range(output.cis_states):
-                    rDips.append(
-                        np.array(
-                            output.cis_relaxed_dipoles[4 * i : 4 * i + 3],
-                            dtype=np.float64,
-                        )
-                    )
-                results["cis_relaxed_dipoles"] = rDips
-
-            if len(output.cis_transition_dipoles):
-                tDips = []
-                for i in range((output.cis_states + 1) * output.cis_states / 2):
-                    tDips.append(
-                        np.array(
-                            output.cis_transition_dipoles[4 * i : 4 * i + 3],
-                            dtype=np.float64,
-                        )
-                    )
-                results["cis_transition_dipoles"] = tDips
+            job_status = status.WhichOneof("job_status")
+            if job_status == "queued":
+                handle.state = QUEUED
+                return handle.state
+            elif job_status == "working":
+                handle.state = WORKING
+                return handle.state
+            elif job_status != "completed":
+                raise ServerError(
+                    "Invalid or no job status received for job {}".format(
+                        handle.server_job_id
+                    ),
+                    self,
+                )
 
-        if len(output.compressed_mo_vector):
-            results["molden"] = tcpb_imd_fields2molden_string(output)
+            handle.timings.lap("compute")
+            job_output = self._recv_msg(pb.JOBOUTPUT)
+            if handle.partial_output is not None:
+                job_output = merge_job_output(handle.partial_output, job_output)
+                handle.partial_output = None
+            handle.timings.lap("receive")
 
-        # Save results for user access later
-        self.prev_results = results
+        self._handles.remove(handle)
+        self._record_output(handle.job_input, job_output)
+        self._complete_handle(handle, job_output)
+        self._submit_pending()
+        return handle.state
 
-        # Wipe state
-        self.curr_job_dir = None
-        self.curr_job_scr_dir = None
-        self.curr_job_id = None
+    def as_completed(self, handles=None):
+        """Iterate over jobs in the order they complete, polling the server for them
 
-        return results
+        Args:
+            handles: JobHandles from submit_job() (all outstanding jobs by default)
+
+        Yields:
+            JobHandle: Next completed job, with its job_output set
+        """
+        if handles is None:
+            handles = list(self._handles)
+        remaining = []
+        for handle in handles:
+            if handle.done():
+                yield handle
+            else:
+                remaining.append(handle)
+
+        intervals = self._poll_intervals()
+        while remaining:
+            if not any(handle.state != PENDING for handle in self._handles):
+                # The server was busy with another client's job; try again
+                self._submit_pending()
+
+            # Every outstanding job is polled, as later jobs only start once earlier
+            # ones finish; jobs start in submission order, so the ones behind a job
+            # still queued on the server are not asked about
+            progressed = False
+            for handle in [h for h in self._handles if h.state != PENDING]:
+                state = self.poll_job(handle)
+                if state == COMPLETED:
+                    progressed = True
+                elif state == QUEUED:
+                    break
+
+            for handle in [h for h in remaining if h.done()]:
+                remaining.remove(handle)
+                yield handle
+
+            if progressed:
+                intervals = self._poll_intervals()
+            elif remaining:
+                sleep(next(intervals))
+
+    def collect(self, handle):
+        """Wait for a job to complete and return its JobOutput
+
+        Args:
+            handle: JobHandle returned by submit_job()
+
+        Returns:
+            pb.JobOutput: Output of the job
+        """
+        for _ in self.as_completed([handle]):
+            pass
+        return handle.job_output
+
+    def _submit_pending(self):
+        """Submit pending jobs in order until the server stops accepting them"""
+        for handle in self._handles:
+            if handle.state != PENDING:
+                continue
+            with self._job_context(handle):
+                self._send_msg(pb.JOBINPUT, self._apply_guess(handle.job_input))
+                status = self._recv_msg(pb.STATUS)
+            if status.WhichOneof("job_status") != "accepted":
+                return
+            # Until a poll reports it running
+            handle.state = QUEUED
+            handle.server_job_id = status.server_job_id
+            handle.job_dir = status.job_dir
+            handle.job_scr_dir = status.job_scr_dir
+            handle.timings.lap("queue")
+
+    def _complete_handle(self, handle, job_output):
+        handle.job_output = job_output
+        handle.state = COMPLETED
+        self._finish_timings(handle.timings)
+
+    @contextmanager
+    def _job_context(self, handle):
+        """Attribute messages and server errors to the job of handle"""
+        saved = (self.job_timings, self.curr_job_dir, self.curr_job_id)
+        self.job_timings = handle.timings
+        self.curr_job_dir, self.curr_job_id = handle.job_dir, handle.server_job_id
+        try:
+            yield
+        finally:
+            self.job_timings, self.curr_job_dir, self.curr_job_id = saved
 
     def compute_job_sync(self, jobType="energy", geom=None, unitType="bohr", **kwargs):
         """Wrapper for send_job_async() and recv_job_async(), using check_job_complete() to poll the server.
@@ -453,15 +1038,13 @@ class TCProtobufClient(object):
             )
             return True
 
+        intervals = self._poll_intervals()
         accepted = self.send_job_async(jobType, geom, unitType, **kwargs)
         while accepted is False:
-            sleep(0.5)
+            sleep(next(intervals))
             accepted = self.send_job_async(jobType, geom, unitType, **kwargs)
 
-        completed = self.check_job_complete()
-        while completed is False:
-            sleep(0.5)
-            completed = self.check_job_complete()
+        self.wait_for_job_complete()
 
         return self.recv_job_async()
 
@@ -538,6 +1121,12 @@ class TCProtobufClient(object):
         orb2afile=None,
         orb2bfile=None,
         unitType="bohr",
+        cvec1=None,
+        cvec2=None,
+        orb1a=None,
+        orb1b=None,
+        orb2a=None,
+        orb2b=None,
         **kwargs,
     ):
         """Compute wavefunction overlap given two different geometries, CI vectors, and orbitals,
@@ -546,6 +1135,9 @@ class TCProtobufClient(object):
         To run a closed shell calculation, only populate orb1afile/orb2afile, leaving orb1bfile/orb2bfile blank.
         Currently, open-shell overlap calculations are not supported by TeraChem.
 
+        Each CI vector and set of orbitals can be given either as a file the server can read,
+        or as a NumPy array sent inline with the job (avoiding a round trip through shared storage).
+
         Args:
             geom:       Cartesian geometry of the first point
             geom2:      Cartesian geometry of the second point
@@ -556,32 +1148,41 @@ class TCProtobufClient(object):
             orb2afile:  Binary file of alpha MO coefficients for second geometry (row-major, double64)
             orb2bfile:  Binary file of beta MO coefficients for second geometry (row-major, double64)
             unitType:   Unit type key, as defined in the pb.Mol.UnitType enum (defaults to 'bohr')
+            cvec1:      CI vector for first geometry, instead of cvec1file
+            cvec2:      CI vector for second geometry, instead of cvec2file
+            orb1a:      Alpha MO coefficients for first geometry as returned by serial_utils.read_orbfile, instead of orb1afile
+            orb1b:      Beta MO coefficients for first geometry, instead of orb1bfile
+            orb2a:      Alpha MO coefficients for second geometry, instead of orb2afile
+            orb2b:      Beta MO coefficients for second geometry, instead of orb2bfile
             **kwargs:   Additional TeraChem keywords, check _process_kwargs for behaviour
 
         Returns:
             (num_states, num_states) ndarray: CI vector overlaps
         """
+        have_cvec1 = cvec1file is not None or cvec1 is not None
+        have_cvec2 = cvec2file is not None or cvec2 is not None
+        have_orb1a = orb1afile is not None or orb1a is not None
+        have_orb2a = orb2afile is not None or orb2a is not None
+        have_orb1b = orb1bfile is not None or orb1b is not None
+        have_orb2b = orb2bfile is not None or orb2b is not None
+
         if geom is None or geom2 is None:
             raise SyntaxError("Did not provide two geometries to compute_ci_overlap()")
-        if cvec1file is None or cvec2file is None:
+        if not have_cvec1 or not have_cvec2:
             raise SyntaxError("Did not provide two CI vectors to compute_ci_overlap()")
-        if orb1afile is None or orb1bfile is None:
+        if not have_orb1a or not have_orb2a:
             raise SyntaxError(
                 "Did not provide two sets of orbitals to compute_ci_overlap()"
             )
         if (
-            (orb1bfile is not None and orb2bfile is None)
-            or (orb1bfile is None and orb2bfile is not None)
+            (have_orb1b and not have_orb2b)
+            or (not have_orb1b and have_orb2b)
             and kwargs["closed_shell"] is False
         ):
             raise SyntaxError(
                 "Did not provide two sets of open-shell orbitals to compute_ci_overlap()"
             )
-        elif (
-            orb1bfile is not None
-            and orb2bfile is not None
-            and kwargs["closed_shell"] is True
-        ):
+        elif have_orb1b and have_orb2b and kwargs["closed_shell"] is True:
             print(
                 "WARNING: System specified as closed, but open-shell orbitals were passed to compute_ci_overlap(). Ignoring beta orbitals."
             )
@@ -596,6 +1197,10 @@ class TCProtobufClient(object):
                 cvec2file=cvec2file,
                 orb1afile=orb1afile,
                 orb2afile=orb2afile,
+                cvec1=cvec1,
+                cvec2=cvec2,
+                orb1a=orb1a,
+                orb2a=orb2a,
                 **kwargs,
             )
         else:
@@ -609,8 +1214,47 @@ class TCProtobufClient(object):
 
         return results["ci_overlap"]
 
+    def compute_ci_overlaps(
+        self,
+        geoms,
+        cvecs,
+        orbs,
+        pairs=None,
+        window=None,
+        unitType="bohr",
+        **kwargs,
+    ):
+        """Compute the CI vector overlaps of many pairs of frames, in one job if the
+        server supports batches (see tcpb.overlap)
+
+        Each frame's geometry, CI vector and orbitals are sent once per job rather
+        than once per pair. Servers that do not support batches get one job per pair.
+
+        Args:
+            geoms:      Geometry of each frame, flat or (natoms, 3)
+            cvecs:      CI vector of each frame, shaped as for compute_ci_overlap()
+            orbs:       Alpha MO coefficients of each frame as returned by serial_utils.read_orbfile
+            pairs:      (i, j) frame indices of the overlaps to compute
+            window:     Without pairs, overlap each frame with this many frames before it (all pairs if None)
+            unitType:   Unit type key, as defined in the pb.Mol.UnitType enum (defaults to 'bohr')
+            **kwargs:   Additional TeraChem keywords, check _process_kwargs for behaviour
+
+        Returns:
+            (num_pairs, num_states, num_states) ndarray: CI vector overlaps of each pair
+        """
+        if not kwargs.get("closed_shell", True):
+            raise RuntimeError(
+                "WARNING: Open-shell systems are currently not supported for overlaps"
+            )
+        template = self.job_template("ci_vec_overlap", unitType, **kwargs)
+        batch = CIOverlapBatch(template, geoms, cvecs, orbs)
+        if pairs is None:
+            pairs = overlap_pairs(batch.nframes, window)
+        return batch.compute(self, pairs)
+
     # Private kwarg helper function
-    def _process_kwargs(self, job_options, **kwargs):  # noqa NOTE: C901 too complex!
+    @staticmethod
+    def _process_kwargs(job_options, **kwargs):  # noqa NOTE: C901 too complex!
         """Process user-provided keyword arguments into a JobInput object
 
         Several keywords are processed by the client to set more complex fields
@@ -619,6 +1263,12 @@ class TCProtobufClient(object):
         * geom:               Sets job_options.mol.xyz from a list or NumPy array
         * geom2:              Sets job_options.xyz2 from a list or NumPy array
         * bond_order:         Sets job_options.return_bond_order to True or False
+        * float32:            Sets job_options.return_float32 to True or False
+        * cvec1, cvec2:       Sets job_options.cvec1/cvec2 from CI vector arrays (row-major)
+        * orb1a, orb1b,
+          orb2a, orb2b:       Sets job_options.orb1a/orb1b/orb2a/orb2b from MO coefficient
+                              arrays as returned by serial_utils.read_orbfile, sent
+                              column-major like TeraChem c0 files
 
         All others are passed through as key-value pairs to the server, which will
         place them in the start file.
@@ -706,6 +1356,26 @@ class TCProtobufClient(object):
                     raise ValueError("Bond order request must be True or False")
 
                 job_options.return_bond_order = value
+            elif key == "float32":
+                # Request the bulk arrays in their float32 fields
+                if value is not True and value is not False:
+                    raise ValueError("Float32 request must be True or False")
+
+                job_options.return_float32 = value
+            elif key in ("cvec1", "cvec2", "orb1a", "orb1b", "orb2a", "orb2b"):
+                # Inline CI vectors and orbitals for ci_vec_overlap job, laid out
+                # like the contents of the corresponding binary files. Parsed from
+                # packed bytes, so large arrays never become lists of Python floats
+                del getattr(job_options, key)[:]
+                if value is not None:
+                    order = "C" if key.startswith("cvec") else "F"
+                    job_options.MergeFromString(
+                        encode_packed_array(
+                            job_options.DESCRIPTOR.fields_by_name[key].number,
+                            np.asarray(value, dtype=np.float64).ravel(order=order),
+                            "<f8",
+                        )
+                    )
             elif key == "mo_output":
                 # Request AO and MO information
                 if value is True:
@@ -729,36 +1399,76 @@ class TCProtobufClient(object):
 
         Args:
             msg_type: Message type (defined as enum in protocol buffer)
-            msg_pb: Protocol Buffer to send to the TCPB server
+            msg_pb: Protocol Buffer (or its serialized bytes) to send to the TCPB server
         """
-        # This will always pack integers as 4 bytes since I am requesting a standard packing (big endian)
-        # Big endian is convention for network byte order (because IBM or someone)
-        if msg_pb is None:
-            msg_size = 0
-        else:
-            msg_size = msg_pb.ByteSize()
-
-        header = struct.pack(">II", msg_type, msg_size)
+        start = perf_counter()
+        header, msg_str = serialize_msg(msg_type, msg_pb, self.wire_compression)
+        wire_header, wire_body = header, msg_str
+        if self.shm is not None:
+            wire_header, wire_body = self.shm.place(header, msg_str)
+        serialized = perf_counter()
         try:
-            self.tcsock.sendall(header)
+            self.tcsock.sendall(wire_header)
         except socket.error as msg:
             raise ServerError("Could not send header: {}".format(msg), self)
 
-        msg_str = b""
-        if msg_pb is not None:
+        if wire_body:
             try:
-                msg_str = msg_pb.SerializeToString()
-                self.tcsock.sendall(msg_str)
+                self.tcsock.sendall(wire_body)
             except socket.error as msg:
                 raise ServerError("Could not send protobuf: {}".format(msg), self)
 
-        if self.trace:
+        if self.job_timings is not None:
+            self.job_timings.message(
+                SENT,
+                msg_type,
+                len(header) + len(msg_str),
+                serialize=serialized - start,
+                send=perf_counter() - serialized,
+            )
+
+        if self.trace_store is not None:
+            self.trace_store.write(SENT, header, msg_str, self.wire_compression)
+        elif self.trace:
             packet = header + msg_str
             self.outtracefile.write(packet)
 
-    def _recv_msg(self, msg_type):  # noqa NOTE: C901 too complex!
+    def _recv_into(self, view, what):
+        """Fill a writable memoryview from the socket, raising on short or failed reads
+
+        Args:
+            view: Writable memoryview to fill completely
+            what: Description of the data being received (for error messages)
+        """
+        nbytes = len(view)
+        nrecv = 0
+        try:
+            while nrecv < nbytes:
+                n = self.tcsock.recv_into(view[nrecv:], nbytes - nrecv)
+                if n == 0:
+                    break
+                nrecv += n
+        except socket.error as msg:
+            raise ServerError("Could not recv {}: {}".format(what, msg), self)
+
+        # Check we got full message
+        if nrecv == 0 and nbytes:
+            raise ServerError(
+                "Could not recv {} because socket was closed from server".format(what),
+                self,
+            )
+        elif nrecv < nbytes:
+            raise ServerError(
+                "Recv'd {} of {} expected bytes for {}".format(nrecv, nbytes, what),
+                self,
+            )
+
+    def _recv_msg(self, msg_type):
         """Receives a header + PB from the TeraChem Protobuf server (must be connected)
 
+        Data is read directly into buffers owned by the client, which are only grown
+        when a larger message arrives; steady-state receives do not allocate.
+
         Args:
             msg_type: Expected message type (defined as enum in protocol buffer)
 
@@ -766,86 +1476,76 @@ class TCProtobufClient(object):
             protobuf: Protocol Buffer of type msg_type (or None if no PB was sent)
         """
         # Receive header
-        try:
-            header = b""
-            nleft = self.header_size
-            while nleft:
-                data = self.tcsock.recv(nleft)
-                if data == b"":
-                    break
-                header += data
-                nleft -= len(data)
-
-            # Check we got full message
-            if nleft == self.header_size and data == b"":
-                raise ServerError(
-                    "Could not recv header because socket was closed from server", self
-                )
-            elif nleft:
-                raise ServerError(
-                    "Recv'd {} of {} expected bytes for header".format(
-                        nleft, self.header_size
-                    ),
-                    self,
-                )
-        except socket.error as msg:
-            raise ServerError("Could not recv header: {}".format(msg), self)
+        start = perf_counter()
+        self._recv_into(self._header_view, "header")
+        recv_type, msg_size = unpack_header(self._header_buffer)
+        in_shm = bool(recv_type & SHM_FLAG)
+        recv_type, compressed = split_msg_type(recv_type & ~SHM_FLAG)
 
-        msg_info = struct.unpack_from(">II", header)
-
-        if msg_info[0] != msg_type:
+        if recv_type != msg_type:
             raise ServerError(
                 "Received header for incorrect packet type (expecting {} and got {})".format(
-                    msg_type, msg_info[0]
+                    msg_type, recv_type
                 ),
                 self,
             )
 
         # Receive Protocol Buffer (if one was sent)
-        if msg_info[1] >= 0:
+        if msg_size > len(self._recv_buffer):
+            self._recv_buffer = bytearray(msg_size)
+            self._recv_view = memoryview(self._recv_buffer)
+        msg_view = self._recv_view[:msg_size]
+        self._recv_into(msg_view, "protobuf")
+        header_view = self._header_view
+        if in_shm:
+            if self.shm is None:
+                raise ServerError(
+                    "Received a shared memory message without a shared memory segment",
+                    self,
+                )
             try:
-                msg_str = b""
-                nleft = msg_info[1]
-                while nleft:
-                    data = self.tcsock.recv(nleft)
-                    if data == b"":
-                        break
-                    msg_str += data
-                    nleft -= len(data)
-
-                # Check we got full message
-                if nleft == self.header_size and data == b"":
-                    raise ServerError(
-                        "Could not recv message because socket was closed from server",
-                        self,
-                    )
-                elif nleft:
-                    raise ServerError(
-                        "Recv'd {} of {} expected bytes for protobuf".format(
-                            nleft, msg_info[1]
-                        ),
-                        self,
-                    )
-            except socket.error as msg:
-                raise ServerError("Could not recv protobuf: {}".format(msg), self)
-
-        if msg_type == pb.STATUS:
-            recv_pb = pb.Status()
-        elif msg_type == pb.MOL:
-            recv_pb = pb.Mol()
-        elif msg_type == pb.JOBINPUT:
-            recv_pb = pb.JobInput()
-        elif msg_type == pb.JOBOUTPUT:
-            recv_pb = pb.JobOutput()
-        else:
-            raise ServerError(
-                "Unknown message type {} for received message.".format(msg_type), self
-            )
-
-        recv_pb.ParseFromString(msg_str)
+                msg_view = self.shm.receive(msg_view)
+            except ValueError as e:
+                raise ServerError(str(e), self)
+            # Traces hold the message as it would have been sent over the socket
+            header_view = pack_header(recv_type, len(msg_view), compressed)
+        body_size = len(msg_view)
+        received = perf_counter()
+
+        # A body in shared memory must be released however reading it ends, or the
+        # server can never reuse its space
+        try:
+            if self.trace_store is not None:
+                self.trace_store.write(
+                    RECEIVED, header_view, msg_view, self.wire_compression
+                )
+            elif self.trace:
+                self.intracefile.write(header_view)
+                self.intracefile.write(msg_view)
 
-        if self.trace:
-            packet = header + msg_str
-            self.intracefile.write(packet)
+            if compressed:
+                try:
+                    msg_view = decompress_body(msg_view, self.wire_compression)
+                except ValueError as e:
+                    raise ServerError(str(e), self)
 
+            try:
+                recv_pb = parse_msg(msg_type, msg_view)
+            except KeyError:
+                raise ServerError(
+                    "Unknown message type {} for received message.".format(msg_type),
+                    self,
+                )
+        finally:
+            if in_shm:
+                self.shm.release()
+
+        if self.job_timings is not None:
+            self.job_timings.message(
+                RECEIVED,
+                msg_type,
+                self.header_size + body_size,
+                recv=received - start,
+                parse=perf_counter() - received,
+            )
         return recv_pb
@@ -0,0 +1,167 @@
+"""JobInputs stamped out of a prebuilt base message
+
+Converting keywords into a JobInput (TCProtobufClient._process_kwargs() for the
+keyword API, utils.atomic_input_to_job_input() for QCSchema inputs) validates every
+option and rebuilds user_options on each call, although a series of jobs usually
+shares all of them. A JobInputTemplate holds the converted message without its
+per-job fields; each job copies it with CopyFrom and only fills in the geometry,
+second geometry, orbital guess and run type.
+"""
+
+import threading
+from collections import OrderedDict
+
+import numpy as np
+
+from . import terachem_server_pb2 as pb
+from .utils import atomic_input_to_job_input
+
+# Keywords of the keyword API that vary from job to job rather than define the job
+PER_JOB_KEYWORDS = ("geom", "geom2")
+
+
+def _flat_list(values):
+    """Flat list of floats from a list or NumPy array of coordinates"""
+    if isinstance(values, np.ndarray):
+        return values.ravel().tolist()
+    return list(values)
+
+
+class JobInputTemplate(object):
+    """JobInput of a system and its options, without per-job fields
+
+    >>> template = JobInputTemplate.from_atomic_input(atomic_input)
+    >>> for geom in trajectory:
+    >>>     client.send_job_input_async(template.job_input(geom))
+    """
+
+    def __init__(self, job_input):
+        """Initialize a JobInputTemplate object.
+
+        Args:
+            job_input: JobInput protobuf message to copy; its geometries are dropped
+        """
+        base = pb.JobInput()
+        base.CopyFrom(job_input)
+        del base.mol.xyz[:]
+        del base.xyz2[:]
+        self._base = base
+        self.natoms = len(base.mol.atoms)
+
+    @classmethod
+    def from_atomic_input(cls, atomic_input):
+        """Template of the system, model and keywords of an AtomicInput
+
+        Args:
+            atomic_input: AtomicInput; it is not modified
+
+        Returns:
+            JobInputTemplate: Template whose jobs run the driver of atomic_input
+        """
+        return cls(atomic_input_to_job_input(atomic_input.copy(deep=True)))
+
+    @property
+    def base(self):
+        """Copy of the base JobInput"""
+        job_input = pb.JobInput()
+        job_input.CopyFrom(self._base)
+        return job_input
+
+    def job_input(self, geom=None, geom2=None, guess=None, run=None):
+        """JobInput of one job
+
+        Args:
+            geom: Geometry of the job as a flat list or NumPy array, in the units of
+                the template
+            geom2: Second geometry (for ci_vec_overlap jobs)
+            guess: Value of the "guess" keyword of the job (orbital files to start
+                the SCF from), replacing the template's
+            run: pb.JobInput.RunType value or name (the template's by default)
+
+        Returns:
+            pb.JobInput: New message; the template is left unchanged
+        """
+        job_input = pb.JobInput()
+        job_input.CopyFrom(self._base)
+        if geom is not None:
+            job_input.mol.xyz.extend(_flat_list(geom))
+        if geom2 is not None:
+            geom2 = _flat_list(geom2)
+            if len(geom2) != 3 * self.natoms:
+                raise ValueError("Geometry provided to geom2 does not match atom list")
+            job_input.xyz2.extend(geom2)
+        if guess is not None:
+            options = job_input.user_options
+            keys = options[::2]
+            if "guess" in keys:
+                options[2 * keys.index("guess") + 1] = guess
+            else:
+                options.extend(["guess", guess])
+        if run is not None:
+            if isinstance(run, str):
+                run = pb.JobInput.RunType.Value(run.upper())
+            job_input.run = run
+        return job_input
+
+
+def _freeze(value):
+    """Hashable stand-in for a keyword value, or None for values not worth caching"""
+    if value is None or isinstance(value, (str, bool, int, float)):
+        return type(value).__name__, value
+    if isinstance(value, (list, tuple)):
+        items = tuple(_freeze(item) for item in value)
+        if all(item is not None for item in items):
+            return type(value).__name__, items
+    # Arrays (inline CI vectors, orbitals) differ from job to job
+    return None
+
+
+def template_key(*args, **kwargs):
+    """Key identifying equal job arguments in a TemplateCache
+
+    Returns:
+        tuple: Hashable key, or None if a value cannot be compared cheaply
+    """
+    values = list(args) + [kwargs[name] for name in sorted(kwargs)]
+    frozen = tuple(_freeze(value) for value in values)
+    if any(item is None for item in frozen):
+        return None
+    return tuple(sorted(kwargs)), frozen
+
+
+class TemplateCache(object):
+    """Least recently used JobInputTemplates by template_key()"""
+
+    def __init__(self, maxsize=64):
+        """Initialize a TemplateCache object.
+
+        Args:
+            maxsize (int): Number of templates kept
+        """
+        self.maxsize = maxsize
+        self._templates = OrderedDict()
+        self._lock = threading.Lock()
+
+    def get(self, key, build):
+        """Template stored under key, built with build() and stored if missing
+
+        Args:
+            key: Key from template_key(); None always builds a new template
+            build: Function returning the JobInputTemplate
+
+        Returns:
+            JobInputTemplate: Cached or new template
+        """
+        if key is None:
+            return build()
+        with self._lock:
+            template = self._templates.get(key)
+            if template is not None:
+                self._templates.move_to_end(key)
+                return template
+        template = build()
+        with self._lock:
+            self._templates[key] = template
+            while len(self._templates) > self.maxsize:
+                self._templates.popitem(last=False)
+        return template
@@ -19,7 +19,7 @@ DESCRIPTOR = _descriptor.FileDescriptor(
     syntax="proto3",
     serialized_options=b"\252\002\030Google.Protobuf.TeraChem",
     create_key=_descriptor._internal_create_key,
-    serialized_pb=b'\n\x15terachem_server.proto\x12\x0fterachem_server"\x9d\x01\n\x06Status\x12\x0c\n\x04\x62usy\x18\x01 \x01(\x08\x12\x12\n\x08\x61\x63\x63\x65pted\x18\x02 \x01(\x08H\x00\x12\x11\n\x07working\x18\x03 \x01(\x08H\x00\x12\x13\n\tcompleted\x18\x04 \x01(\x08H\x00\x12\x0f\n\x07job_dir\x18\x05 \x01(\t\x12\x13\n\x0bjob_scr_dir\x18\x06 \x01(\t\x12\x15\n\rserver_job_id\x18\x07 \x01(\x05\x42\x0c\n\njob_status"\xbd\x01\n\x03Mol\x12\r\n\x05\x61toms\x18\x01 \x03(\t\x12\x0b\n\x03xyz\x18\x02 \x03(\x01\x12,\n\x05units\x18\x03 \x01(\x0e\x32\x1d.terachem_server.Mol.UnitType\x12\x0e\n\x06\x63harge\x18\x04 \x01(\x05\x12\x14\n\x0cmultiplicity\x18\x05 \x01(\x05\x12\x0e\n\x06\x63losed\x18\x06 \x01(\x08\x12\x12\n\nrestricted\x18\x07 \x01(\x08""\n\x08UnitType\x12\x0c\n\x08\x41NGSTROM\x10\x00\x12\x08\n\x04\x42OHR\x10\x01"\xf4\t\n\x08JobInput\x12!\n\x03mol\x18\x01 \x01(\x0b\x32\x14.terachem_server.Mol\x12.\n\x03run\x18\x02 \x01(\x0e\x32!.terachem_server.JobInput.RunType\x12\x34\n\x06method\x18\x03 \x01(\x0e\x32$.terachem_server.JobInput.MethodType\x12\r\n\x05\x62\x61sis\x18\x04 \x01(\t\x12\x14\n\x0cuser_options\x18\x07 \x03(\t\x12\x11\n\torb1afile\x18\x08 \x01(\t\x12\x11\n\torb1bfile\x18\t \x01(\t\x12\x19\n\x11return_bond_order\x18\x10 \x01(\x08\x12\x0c\n\x04xyz2\x18\x11 \x03(\x01\x12\x33\n\x08imd_type\x18\x14 \x01(\x0e\x32!.terachem_server.JobInput.ImdType\x12\x1b\n\x13imd_initial_orbital\x18\x15 \x01(\x05\x12\x42\n\x10imd_orbital_type\x18\x1b \x01(\x0e\x32(.terachem_server.JobInput.ImdOrbitalType\x12\x18\n\x10imd_xyz_previous\x18\x16 \x03(\x01\x12\x17\n\x0fimd_mo_previous\x18\x17 \x03(\x02\x12\x1b\n\x13imd_mmatom_position\x18\x18 \x03(\x02\x12\x17\n\x0fimd_mmatom_info\x18\x19 \x03(\x02\x12L\n\x15imd_additional_option\x18\x1a \x01(\x0e\x32-.terachem_server.JobInput.ImdAdditionalOption"O\n\x07RunType\x12\n\n\x06\x45NERGY\x10\x00\x12\x0c\n\x08GRADIENT\x10\x01\x12\x0c\n\x08\x43OUPLING\x10\x0e\x12\x08\n\x04TDCI\x10\x10\x12\x12\n\x0e\x43I_VEC_OVERLAP\x10\x13"\xbc\x02\n\nMethodType\x12\x06\n\x02HF\x10\x00\x12\x08\n\x04\x43\x41SE\x10\x02\x12\t\n\x05SVWN1\x10\x03\x12\t\n\x05SVWN3\x10\x04\x12\t\n\x05SVWN5\x10\x05\x12\x08\n\x04SVWN\x10\x05\x12\n\n\x06\x42\x33LYP1\x10\x06\x12\t\n\x05\x42\x33LYP\x10\x06\x12\n\n\x06\x42\x33LYP3\x10\x07\x12\n\n\x06\x42\x33LYP5\x10\x08\x12\x08\n\x04\x42LYP\x10\t\x12\r\n\tBHANDHLYP\x10\n\x12\x07\n\x03PBE\x10\x0b\x12\n\n\x06REVPBE\x10\x0c\x12\x08\n\x04PBE0\x10\r\x12\x0b\n\x07REVPBE0\x10\x0e\x12\x08\n\x04WPBE\x10\x0f\x12\t\n\x05WPBEH\x10\x10\x12\x07\n\x03\x42OP\x10\x11\x12\t\n\x05MUBOP\x10\x12\x12\x0c\n\x08\x43\x41MB3LYP\x10\x13\x12\x07\n\x03\x42\x39\x37\x10\x14\x12\x08\n\x04WB97\x10\x15\x12\t\n\x05WB97X\x10\x16\x12\x0b\n\x07WB97XD3\x10\x17\x12\n\n\x06GFNXTB\x10\x18\x12\x0b\n\x07GFN2XTB\x10\x19\x1a\x02\x10\x01"P\n\x07ImdType\x12\x0b\n\x07NOT_IMD\x10\x00\x12\x15\n\x11IMD_NEW_CONDITION\x10\x01\x12\x10\n\x0cIMD_CONTINUE\x10\x02\x12\x0f\n\x0bIMD_HESSIAN\x10\x03"w\n\x0eImdOrbitalType\x12\x0e\n\nNO_ORBITAL\x10\x00\x12\x11\n\rALPHA_ORBITAL\x10\x01\x12\x10\n\x0c\x42\x45TA_ORBITAL\x10\x02\x12\x11\n\rALPHA_DENSITY\x10\x03\x12\x10\n\x0c\x42\x45TA_DENSITY\x10\x04\x12\x0b\n\x07WHOLE_C\x10\x05"C\n\x13ImdAdditionalOption\x12\x11\n\rIMD_NORMAL_MD\x10\x00\x12\x19\n\x15IMD_MECI_OPT_GRADIENT\x10\x01"\xc8\x06\n\tJobOutput\x12!\n\x03mol\x18\x01 \x01(\x0b\x32\x14.terachem_server.Mol\x12\x0e\n\x06\x65nergy\x18\x02 \x03(\x01\x12\x10\n\x08gradient\x18\x03 \x03(\x01\x12\x0f\n\x07\x63harges\x18\x04 \x03(\x01\x12\r\n\x05spins\x18\x05 \x03(\x01\x12\x0f\n\x07\x64ipoles\x18\x06 \x03(\x01\x12\x0f\n\x07job_dir\x18\t \x01(\t\x12\x13\n\x0bjob_scr_dir\x18\n \x01(\t\x12\x15\n\rserver_job_id\x18\x0b \x01(\x05\x12\x11\n\torb1afile\x18\x0c \x01(\t\x12\x11\n\torb1bfile\x18\r \x01(\t\x12\x10\n\x08orb_size\x18\x0e \x01(\x05\x12\x12\n\nbond_order\x18\x10 \x03(\x01\x12\x13\n\x0b\x63i_overlaps\x18\x11 \x03(\x01\x12\x17\n\x0f\x63i_overlap_size\x18\x12 \x01(\x05\x12\x19\n\x11\x63\x61s_energy_states\x18\x13 \x03(\x05\x12\x18\n\x10\x63\x61s_energy_mults\x18\x14 \x03(\x05\x12\x1d\n\x15\x63\x61s_transition_dipole\x18\x16 \x03(\x01\x12\r\n\x05nacme\x18\x15 \x03(\x01\x12\x15\n\rorba_energies\x18\x19 \x03(\x01\x12\x15\n\rorbb_energies\x18\x1a \x03(\x01\x12\x18\n\x10orba_occupations\x18\x1b \x03(\x01\x12\x18\n\x10orbb_occupations\x18\x1c \x03(\x01\x12\x12\n\ncis_states\x18\x1d \x01(\x05\x12\x1d\n\x15\x63is_unrelaxed_dipoles\x18\x1e \x03(\x01\x12\x1b\n\x13\x63is_relaxed_dipoles\x18\x1f \x03(\x01\x12\x1e\n\x16\x63is_transition_dipoles\x18  \x03(\x01\x12\x11\n\tci_vec_re\x18! \x03(\x01\x12\x11\n\tci_vec_im\x18" \x03(\x01\x12\x1d\n\x15\x63ompressed_bond_order\x18# \x03(\r\x12\x1a\n\x12\x63ompressed_hessian\x18$ \x03(\x02\x12\x1a\n\x12\x63ompressed_ao_data\x18% \x03(\x02\x12!\n\x19\x63ompressed_primitive_data\x18& \x03(\x02\x12\x1c\n\x14\x63ompressed_mo_vector\x18\' \x03(\x02\x12\x1b\n\x13imd_mmatom_gradient\x18( \x03(\x02*?\n\x0bMessageType\x12\n\n\x06STATUS\x10\x00\x12\x07\n\x03MOL\x10\x01\x12\x0c\n\x08JOBINPUT\x10\x02\x12\r\n\tJOBOUTPUT\x10\x03\x42\x1b\xaa\x02\x18Google.Protobuf.TeraChemb\x06proto3',
+    serialized_pb=b'\n\x15terachem_server.proto\x12\x0fterachem_server"\xe1\x03\n\x06Status\x12\x0c\n\x04\x62usy\x18\x01 \x01(\x08\x12\x12\n\x08\x61\x63\x63\x65pted\x18\x02 \x01(\x08H\x00\x12\x11\n\x07working\x18\x03 \x01(\x08H\x00\x12\x13\n\tcompleted\x18\x04 \x01(\x08H\x00\x12\x10\n\x06queued\x18\n \x01(\x08H\x00\x12\x0f\n\x07job_dir\x18\x05 \x01(\t\x12\x13\n\x0bjob_scr_dir\x18\x06 \x01(\t\x12\x15\n\rserver_job_id\x18\x07 \x01(\x05\x12\x43\n\x12\x61\x63\x63\x65pt_compression\x18\x08 \x03(\x0e\x32\'.terachem_server.Status.CompressionType\x12<\n\x0b\x63ompression\x18\t \x01(\x0e\x32\'.terachem_server.Status.CompressionType\x12\x15\n\rshared_memory\x18\x0b \x01(\t\x12\x1a\n\x12shared_memory_size\x18\x0c \x01(\x04\x12\x1e\n\x16shared_memory_accepted\x18\r \x01(\x08\x12\x16\n\x0epartial_output\x18\x0e \x01(\x08"B\n\x0f\x43ompressionType\x12\x12\n\x0eNO_COMPRESSION\x10\x00\x12\x08\n\x04ZLIB\x10\x01\x12\x08\n\x04ZSTD\x10\x02\x12\x07\n\x03LZ4\x10\x03\x42\x0c\n\njob_status"\xbd\x01\n\x03Mol\x12\r\n\x05\x61toms\x18\x01 \x03(\t\x12\x0b\n\x03xyz\x18\x02 \x03(\x01\x12,\n\x05units\x18\x03 \x01(\x0e\x32\x1d.terachem_server.Mol.UnitType\x12\x0e\n\x06\x63harge\x18\x04 \x01(\x05\x12\x14\n\x0cmultiplicity\x18\x05 \x01(\x05\x12\x0e\n\x06\x63losed\x18\x06 \x01(\x08\x12\x12\n\nrestricted\x18\x07 \x01(\x08""\n\x08UnitType\x12\x0c\n\x08\x41NGSTROM\x10\x00\x12\x08\n\x04\x42OHR\x10\x01"\xd8\x0b\n\x08JobInput\x12!\n\x03mol\x18\x01 \x01(\x0b\x32\x14.terachem_server.Mol\x12.\n\x03run\x18\x02 \x01(\x0e\x32!.terachem_server.JobInput.RunType\x12\x34\n\x06method\x18\x03 \x01(\x0e\x32$.terachem_server.JobInput.MethodType\x12\r\n\x05\x62\x61sis\x18\x04 \x01(\t\x12\x14\n\x0cuser_options\x18\x07 \x03(\t\x12\x11\n\torb1afile\x18\x08 \x01(\t\x12\x11\n\torb1bfile\x18\t \x01(\t\x12\x19\n\x11return_bond_order\x18\x10 \x01(\x08\x12\x0c\n\x04xyz2\x18\x11 \x03(\x01\x12\x33\n\x08imd_type\x18\x14 \x01(\x0e\x32!.terachem_server.JobInput.ImdType\x12\x1b\n\x13imd_initial_orbital\x18\x15 \x01(\x05\x12\x42\n\x10imd_orbital_type\x18\x1b \x01(\x0e\x32(.terachem_server.JobInput.ImdOrbitalType\x12\x18\n\x10imd_xyz_previous\x18\x16 \x03(\x01\x12\x17\n\x0fimd_mo_previous\x18\x17 \x03(\x02\x12\x1b\n\x13imd_mmatom_position\x18\x18 \x03(\x02\x12\x17\n\x0fimd_mmatom_info\x18\x19 \x03(\x02\x12L\n\x15imd_additional_option\x18\x1a \x01(\x0e\x32-.terachem_server.JobInput.ImdAdditionalOption\x12\r\n\x05\x63vec1\x18\x1c \x03(\x01\x12\r\n\x05\x63vec2\x18\x1d \x03(\x01\x12\r\n\x05orb1a\x18\x1e \x03(\x01\x12\r\n\x05orb1b\x18\x1f \x03(\x01\x12\r\n\x05orb2a\x18  \x03(\x01\x12\r\n\x05orb2b\x18! \x03(\x01\x12\x16\n\x0ereturn_float32\x18" \x01(\x08\x12\x17\n\x0fpartial_outputs\x18# \x01(\x08\x12\x13\n\x0boverlap_xyz\x18$ \x03(\x01\x12\x15\n\roverlap_cvecs\x18% \x03(\x01\x12\x14\n\x0coverlap_orbs\x18& \x03(\x01\x12\x15\n\roverlap_pairs\x18\' \x03(\x05"O\n\x07RunType\x12\n\n\x06\x45NERGY\x10\x00\x12\x0c\n\x08GRADIENT\x10\x01\x12\x0c\n\x08\x43OUPLING\x10\x0e\x12\x08\n\x04TDCI\x10\x10\x12\x12\n\x0e\x43I_VEC_OVERLAP\x10\x13"\xbc\x02\n\nMethodType\x12\x06\n\x02HF\x10\x00\x12\x08\n\x04\x43\x41SE\x10\x02\x12\t\n\x05SVWN1\x10\x03\x12\t\n\x05SVWN3\x10\x04\x12\t\n\x05SVWN5\x10\x05\x12\x08\n\x04SVWN\x10\x05\x12\n\n\x06\x42\x33LYP1\x10\x06\x12\t\n\x05\x42\x33LYP\x10\x06\x12\n\n\x06\x42\x33LYP3\x10\x07\x12\n\n\x06\x42\x33LYP5\x10\x08\x12\x08\n\x04\x42LYP\x10\t\x12\r\n\tBHANDHLYP\x10\n\x12\x07\n\x03PBE\x10\x0b\x12\n\n\x06REVPBE\x10\x0c\x12\x08\n\x04PBE0\x10\r\x12\x0b\n\x07REVPBE0\x10\x0e\x12\x08\n\x04WPBE\x10\x0f\x12\t\n\x05WPBEH\x10\x10\x12\x07\n\x03\x42OP\x10\x11\x12\t\n\x05MUBOP\x10\x12\x12\x0c\n\x08\x43\x41MB3LYP\x10\x13\x12\x07\n\x03\x42\x39\x37\x10\x14\x12\x08\n\x04WB97\x10\x15\x12\t\n\x05WB97X\x10\x16\x12\x0b\n\x07WB97XD3\x10\x17\x12\n\n\x06GFNXTB\x10\x18\x12\x0b\n\x07GFN2XTB\x10\x19\x1a\x02\x10\x01"P\n\x07ImdType\x12\x0b\n\x07NOT_IMD\x10\x00\x12\x15\n\x11IMD_NEW_CONDITION\x10\x01\x12\x10\n\x0cIMD_CONTINUE\x10\x02\x12\x0f\n\x0bIMD_HESSIAN\x10\x03"w\n\x0eImdOrbitalType\x12\x0e\n\nNO_ORBITAL\x10\x00\x12\x11\n\rALPHA_ORBITAL\x10\x01\x12\x10\n\x0c\x42\x45TA_ORBITAL\x10\x02\x12\x11\n\rALPHA_DENSITY\x10\x03\x12\x10\n\x0c\x42\x45TA_DENSITY\x10\x04\x12\x0b\n\x07WHOLE_C\x10\x05"C\n\x13ImdAdditionalOption\x12\x11\n\rIMD_NORMAL_MD\x10\x00\x12\x19\n\x15IMD_MECI_OPT_GRADIENT\x10\x01"\xfc\x07\n\tJobOutput\x12!\n\x03mol\x18\x01 \x01(\x0b\x32\x14.terachem_server.Mol\x12\x0e\n\x06\x65nergy\x18\x02 \x03(\x01\x12\x10\n\x08gradient\x18\x03 \x03(\x01\x12\x0f\n\x07\x63harges\x18\x04 \x03(\x01\x12\r\n\x05spins\x18\x05 \x03(\x01\x12\x0f\n\x07\x64ipoles\x18\x06 \x03(\x01\x12\x0f\n\x07job_dir\x18\t \x01(\t\x12\x13\n\x0bjob_scr_dir\x18\n \x01(\t\x12\x15\n\rserver_job_id\x18\x0b \x01(\x05\x12\x11\n\torb1afile\x18\x0c \x01(\t\x12\x11\n\torb1bfile\x18\r \x01(\t\x12\x10\n\x08orb_size\x18\x0e \x01(\x05\x12\x12\n\nbond_order\x18\x10 \x03(\x01\x12\x13\n\x0b\x63i_overlaps\x18\x11 \x03(\x01\x12\x17\n\x0f\x63i_overlap_size\x18\x12 \x01(\x05\x12\x19\n\x11\x63\x61s_energy_states\x18\x13 \x03(\x05\x12\x18\n\x10\x63\x61s_energy_mults\x18\x14 \x03(\x05\x12\x1d\n\x15\x63\x61s_transition_dipole\x18\x16 \x03(\x01\x12\r\n\x05nacme\x18\x15 \x03(\x01\x12\x15\n\rorba_energies\x18\x19 \x03(\x01\x12\x15\n\rorbb_energies\x18\x1a \x03(\x01\x12\x18\n\x10orba_occupations\x18\x1b \x03(\x01\x12\x18\n\x10orbb_occupations\x18\x1c \x03(\x01\x12\x12\n\ncis_states\x18\x1d \x01(\x05\x12\x1d\n\x15\x63is_unrelaxed_dipoles\x18\x1e \x03(\x01\x12\x1b\n\x13\x63is_relaxed_dipoles\x18\x1f \x03(\x01\x12\x1e\n\x16\x63is_transition_dipoles\x18  \x03(\x01\x12\x11\n\tci_vec_re\x18! \x03(\x01\x12\x11\n\tci_vec_im\x18" \x03(\x01\x12\x1d\n\x15\x63ompressed_bond_order\x18# \x03(\r\x12\x1a\n\x12\x63ompressed_hessian\x18$ \x03(\x02\x12\x1a\n\x12\x63ompressed_ao_data\x18% \x03(\x02\x12!\n\x19\x63ompressed_primitive_data\x18& \x03(\x02\x12\x1c\n\x14\x63ompressed_mo_vector\x18\' \x03(\x02\x12\x1b\n\x13imd_mmatom_gradient\x18( \x03(\x02\x12\x16\n\x0e\x62ond_order_f32\x18) \x03(\x02\x12\x15\n\rci_vec_re_f32\x18* \x03(\x02\x12\x15\n\rci_vec_im_f32\x18+ \x03(\x02\x12\x35\n\x05stage\x18, \x01(\x0e\x32&.terachem_server.JobOutput.OutputStage"5\n\x0bOutputStage\x12\t\n\x05\x46INAL\x10\x00\x12\x0c\n\x08\x45NERGIES\x10\x01\x12\r\n\tGRADIENTS\x10\x02*?\n\x0bMessageType\x12\n\n\x06STATUS\x10\x00\x12\x07\n\x03MOL\x10\x01\x12\x0c\n\x08JOBINPUT\x10\x02\x12\r\n\tJOBOUTPUT\x10\x03\x42\x1b\xaa\x02\x18Google.Protobuf.TeraChemb\x06proto3',
 )
 
 _MESSAGETYPE = _descriptor.EnumDescriptor(
@@ -64,8 +64,8 @@ _MESSAGETYPE = _descriptor.EnumDescriptor(
     ],
     containing_type=None,
     serialized_options=None,
-    serialized_start=2508,
-    serialized_end=2571,
+    serialized_start=3240,
+    serialized_end=3303,
 )
 _sym_db.RegisterEnumDescriptor(_MESSAGETYPE)
 
@@ -76,6 +76,53 @@ JOBINPUT = 2
 JOBOUTPUT = 3
 
 
+_STATUS_COMPRESSIONTYPE = _descriptor.EnumDescriptor(
+    name="CompressionType",
+    full_name="terachem_server.Status.CompressionType",
+    filename=None,
+    file=DESCRIPTOR,
+    create_key=_descriptor._internal_create_key,
+    values=[
+        _descriptor.EnumValueDescriptor(
+            name="NO_COMPRESSION",
+            index=0,
+            number=0,
+            serialized_options=None,
+            type=None,
+            create_key=_descriptor._internal_create_key,
+        ),
+        _descriptor.EnumValueDescriptor(
+            name="ZLIB",
+            index=1,
+            number=1,
+            serialized_options=None,
+            type=None,
+            create_key=_descriptor._internal_create_key,
+        ),
+        _descriptor.EnumValueDescriptor(
+            name="ZSTD",
+            index=2,
+            number=2,
+            serialized_options=None,
+            type=None,
+            create_key=_descriptor._internal_create_key,
+        ),
+        _descriptor.EnumValueDescriptor(
+            name="LZ4",
+            index=3,
+            number=3,
+            serialized_options=None,
+            type=None,
+            create_key=_descriptor._internal_create_key,
+        ),
+    ],
+    containing_type=None,
+    serialized_options=None,
+    serialized_start=444,
+    serialized_end=510,
+)
+_sym_db.RegisterEnumDescriptor(_STATUS_COMPRESSIONTYPE)
+
 _MOL_UNITTYPE = _descriptor.EnumDescriptor(
     name="UnitType",
     full_name="terachem_server.Mol.UnitType",
@@ -102,8 +149,8 @@ _MOL_UNITTYPE = _descriptor.EnumDescriptor(
     ],
     containing_type=None,
     serialized_options=None,
-    serialized_start=358,
-    serialized_end=392,
+    serialized_start=682,
+    serialized_end=716,
 )
 _sym_db.RegisterEnumDescriptor(_MOL_UNITTYPE)
 
@@ -157,8 +204,8 @@ _JOBINPUT_RUNTYPE = _descriptor.EnumDescriptor(
     ],
     containing_type=None,
     serialized_options=None,
-    serialized_start=993,
-    serialized_end=1072,
+    serialized_start=1545,
+    serialized_end=1624,
 )
 _sym_db.RegisterEnumDescriptor(_JOBINPUT_RUNTYPE)
 
@@ -388,8 +435,8 @@ _JOBINPUT_METHODTYPE = _descriptor.EnumDescriptor(
     ],
     containing_type=None,
     serialized_options=b"\020\001",
-    serialized_start=1075,
-    serialized_end=1391,
+    serialized_start=1627,
+    serialized_end=1943,
 )
 _sym_db.RegisterEnumDescriptor(_JOBINPUT_METHODTYPE)
 
@@ -435,8 +482,8 @@ _JOBINPUT_IMDTYPE = _descriptor.EnumDescriptor(
     ],
     containing_type=None,
     serialized_options=None,
-    serialized_start=1393,
-    serialized_end=1473,
+    serialized_start=1945,
+    serialized_end=2025,
 )
 _sym_db.RegisterEnumDescriptor(_JOBINPUT_IMDTYPE)
 
@@ -498,8 +545,8 @@ _JOBINPUT_IMDORBITALTYPE = _descriptor.EnumDescriptor(
     ],
     containing_type=None,
     serialized_options=None,
-    serialized_start=1475,
-    serialized_end=1594,
+    serialized_start=2027,
+    serialized_end=2146,
 )
 _sym_db.RegisterEnumDescriptor(_JOBINPUT_IMDORBITALTYPE)
 
@@ -529,11 +576,50 @@ _JOBINPUT_IMDADDITIONALOPTION = _descriptor.EnumDescriptor(
     ],
     containing_type=None,
     serialized_options=None,
-    serialized_start=1596,
-    serialized_end=1663,
+    serialized_start=2148,
+    serialized_end=2215,
 )
 _sym_db.RegisterEnumDescriptor(_JOBINPUT_IMDADDITIONALOPTION)
 
+_JOBOUTPUT_OUTPUTSTAGE = _descriptor.EnumDescriptor(
+    name="OutputStage",
+    full_name="terachem_server.JobOutput.OutputStage",
+    filename=None,
+    file=DESCRIPTOR,
+    create_key=_descriptor._internal_create_key,
+    values=[
+        _descriptor.EnumValueDescriptor(
+            name="FINAL",
+            index=0,
+            number=0,
+            serialized_options=None,
+            type=None,
+            create_key=_descriptor._internal_create_key,
+        ),
+        _descriptor.EnumValueDescriptor(
+            name="ENERGIES",
+            index=1,
+            number=1,
+            serialized_options=None,
+            type=None,
+            create_key=_descriptor._internal_create_key,
+        ),
+        _descriptor.EnumValueDescriptor(
+            name="GRADIENTS",
+            index=2,
+            number=2,
+            serialized_options=None,
+            type=None,
+            create_key=_descriptor._internal_create_key,
+        ),
+    ],
+    containing_type=None,
+    serialized_options=None,
+    serialized_start=3185,
+    serialized_end=3238,
+)
+_sym_db.RegisterEnumDescriptor(_JOBOUTPUT_OUTPUTSTAGE)
+
 
 _STATUS = _descriptor.Descriptor(
     name="Status",
@@ -619,10 +705,29 @@ _STATUS = _descriptor.Descriptor(
             file=DESCRIPTOR,
             create_key=_descriptor._internal_create_key,
         ),
+        _descriptor.FieldDescriptor(
+            name="queued",
+            full_name="terachem_server.Status.queued",
+            index=4,
+            number=10,
+            type=8,
+            cpp_type=7,
+            label=1,
+            has_default_value=False,
+            default_value=False,
+            message_type=None,
+            enum_type=None,
+            containing_type=None,
+            is_extension=False,
+            extension_scope=None,
+            serialized_options=None,
+            file=DESCRIPTOR,
+            create_key=_descriptor._internal_create_key,
+        ),
         _descriptor.FieldDescriptor(
             name="job_dir",
             full_name="terachem_server.Status.job_dir",
-            index=4,
+            index=5,
             number=5,
             type=9,
             cpp_type=9,
@@ -641,7 +746,7 @@ _STATUS = _descriptor.Descriptor(
         _descriptor.FieldDescriptor(
             name="job_scr_dir",
             full_name="terachem_server.Status.job_scr_dir",
-            index=5,
+            index=6,
             number=6,
             type=9,
             cpp_type=9,
@@ -660,7 +765,7 @@ _STATUS = _descriptor.Descriptor(
         _descriptor.FieldDescriptor(
             name="server_job_id",
             full_name="terachem_server.Status.server_job_id",
-            index=6,
+            index=7,
             number=7,
             type=5,
             cpp_type=1,
@@ -676,10 +781,126 @@ _STATUS = _descriptor.Descriptor(
             file=DESCRIPTOR,
             create_key=_descriptor._internal_create_key,
         ),
+        _descriptor.FieldDescriptor(
+            name="accept_compression",
+            full_name="terachem_server.Status.accept_compression",
+            index=8,
+            number=8,
+            type=14,
+            cpp_type=8,
+            label=3,
+            has_default_value=False,
+            default_value=[],
+            message_type=None,
+            enum_type=None,
+            containing_type=None,
+            is_extension=False,
+            extension_scope=None,
+            serialized_options=None,
+            file=DESCRIPTOR,
+            create_key=_descriptor._internal_create_key,
+        ),
+        _descriptor.FieldDescriptor(
+            name="compression",
+            full_name="terachem_server.Status.compression",
+            index=9,
+            number=9,
+            type=14,
+            cpp_type=8,
+            label=1,
+            has_default_value=False,
+            default_value=0,
+            message_type=None,
+            enum_type=None,
+            containing_type=None,
+            is_extension=False,
+            extension_scope=None,
+            serialized_options=None,
+            file=DESCRIPTOR,
+            create_key=_descriptor._internal_create_key,
+        ),
+        _descriptor.FieldDescriptor(
+            name="shared_memory",
+            full_name="terachem_server.Status.shared_memory",
+            index=10,
+            number=11,
+            type=9,
+            cpp_type=9,
+            label=1,
+            has_default_value=False,
+            default_value=b"".decode("utf-8"),
+            message_type=None,
+            enum_type=None,
+            containing_type=None,
+            is_extension=False,
+            extension_scope=None,
+            serialized_options=None,
+            file=DESCRIPTOR,
+            create_key=_descriptor._internal_create_key,
+        ),
+        _descriptor.FieldDescriptor(
+            name="shared_memory_size",
+            full_name="terachem_server.Status.shared_memory_size",
+            index=11,
+            number=12,
+            type=4,
+            cpp_type=4,
+            label=1,
+            has_default_value=False,
+            default_value=int(0),
+            message_type=None,
+            enum_type=None,
+            containing_type=None,
+            is_extension=False,
+            extension_scope=None,
+            serialized_options=None,
+            file=DESCRIPTOR,
+            create_key=_descriptor._internal_create_key,
+        ),
+        _descriptor.FieldDescriptor(
+            name="shared_memory_accepted",
+            full_name="terachem_server.Status.shared_memory_accepted",
+            index=12,
+            number=13,
+            type=8,
+            cpp_type=7,
+            label=1,
+            has_default_value=False,
+            default_value=False,
+            message_type=None,
+            enum_type=None,
+            containing_type=None,
+            is_extension=False,
+            extension_scope=None,
+            serialized_options=None,
+            file=DESCRIPTOR,
+            create_key=_descriptor._internal_create_key,
+        ),
+        _descriptor.FieldDescriptor(
+            name="partial_output",
+            full_name="terachem_server.Status.partial_output",
+            index=13,
+            number=14,
+            type=8,
+            cpp_type=7,
+            label=1,
+            has_default_value=False,
+            default_value=False,
+            message_type=None,
+            enum_type=None,
+            containing_type=None,
+            is_extension=False,
+            extension_scope=None,
+            serialized_options=None,
+            file=DESCRIPTOR,
+            create_key=_descriptor._internal_create_key,
+        ),
     ],
     extensions=[],
     nested_types=[],
-    enum_types=[],
+    enum_types=[
+        _STATUS_COMPRESSIONTYPE,
+    ],
     serialized_options=None,
     is_extendable=False,
     syntax="proto3",
@@ -695,7 +916,7 @@ _STATUS = _descriptor.Descriptor(
         ),
     ],
     serialized_start=43,
-    serialized_end=200,
+    serialized_end=524,
 )
 
 
@@ -851,8 +1072,8 @@ _MOL = _descriptor.Descriptor(
     syntax="proto3",
     extension_ranges=[],
     oneofs=[],
-    serialized_start=203,
-    serialized_end=392,
+    serialized_start=527,
+    serialized_end=716,
 )
 
 
@@ -1187,6 +1408,234 @@ _JOBINPUT = _descriptor.Descriptor(
             file=DESCRIPTOR,
             create_key=_descriptor._internal_create_key,
         ),
+        _descriptor.FieldDescriptor(
+            name="cvec1",
+            full_name="terachem_server.JobInput.cvec1",
+            index=17,
+            number=28,
+            type=1,
+            cpp_type=5,
+            label=3,
+            has_default_value=False,
+            default_value=[],
+            message_type=None,
+            enum_type=None,
+            containing_type=None,
+            is_extension=False,
+            extension_scope=None,
+            serialized_options=None,
+            file=DESCRIPTOR,
+            create_key=_descriptor._internal_create_key,
+        ),
+        _descriptor.FieldDescriptor(
+            name="cvec2",
+            full_name="terachem_server.JobInput.cvec2",
+            index=18,
+            number=29,
+            type=1,
+            cpp_type=5,
+            label=3,
+            has_default_value=False,
+            default_value=[],
+            message_type=None,
+            enum_type=None,
+            containing_type=None,
+            is_extension=False,
+            extension_scope=None,
+            serialized_options=None,
+            file=DESCRIPTOR,
+            create_key=_descriptor._internal_create_key,
+        ),
+        _descriptor.FieldDescriptor(
+            name="orb1a",
+            full_name="terachem_server.JobInput.orb1a",
+            index=19,
+            number=30,
+            type=1,
+            cpp_type=5,
+            label=3,
+            has_default_value=False,
+            default_value=[],
+            message_type=None,
+            enum_type=None,
+            containing_type=None,
+            is_extension=False,
+            extension_scope=None,
+            serialized_options=None,
+            file=DESCRIPTOR,
+            create_key=_descriptor._internal_create_key,
+        ),
+        _descriptor.FieldDescriptor(
+            name="orb1b",
+            full_name="terachem_server.JobInput.orb1b",
+            index=20,
+            number=31,
+            type=1,
+            cpp_type=5,
+            label=3,
+            has_default_value=False,
+            default_value=[],
+            message_type=None,
+            enum_type=None,
+            containing_type=None,
+            is_extension=False,
+            extension_scope=None,
+            serialized_options=None,
+            file=DESCRIPTOR,
+            create_key=_descriptor._internal_create_key,
+        ),
+        _descriptor.FieldDescriptor(
+            name="orb2a",
+            full_name="terachem_server.JobInput.orb2a",
+            index=21,
+            number=32,
+            type=1,
+            cpp_type=5,
+            label=3,
+            has_default_value=False,
+            default_value=[],
+            message_type=None,
+            enum_type=None,
+            containing_type=None,
+            is_extension=False,
+            extension_scope=None,
+            serialized_options=None,
+            file=DESCRIPTOR,
+            create_key=_descriptor._internal_create_key,
+        ),
+        _descriptor.FieldDescriptor(
+            name="orb2b",
+            full_name="terachem_server.JobInput.orb2b",
+            index=22,
+            number=33,
+            type=1,
+            cpp_type=5,
+            label=3,
+            has_default_value=False,
+            default_value=[],
+            message_type=None,
+            enum_type=None,
+            containing_type=None,
+            is_extension=False,
+            extension_scope=None,
+            serialized_options=None,
+            file=DESCRIPTOR,
+            create_key=_descriptor._internal_create_key,
+        ),
+        _descriptor.FieldDescriptor(
+            name="return_float32",
+            full_name="terachem_server.JobInput.return_float32",
+            index=23,
+            number=34,
+            type=8,
+            cpp_type=7,
+            label=1,
+            has_default_value=False,
+            default_value=False,
+            message_type=None,
+            enum_type=None,
+            containing_type=None,
+            is_extension=False,
+            extension_scope=None,
+            serialized_options=None,
+            file=DESCRIPTOR,
+            create_key=_descriptor._internal_create_key,
+        ),
+        _descriptor.FieldDescriptor(
+            name="partial_outputs",
+            full_name="terachem_server.JobInput.partial_outputs",
+            index=24,
+            number=35,
+            type=8,
+            cpp_type=7,
+            label=1,
+            has_default_value=False,
+            default_value=False,
+            message_type=None,
+            enum_type=None,
+            containing_type=None,
+            is_extension=False,
+            extension_scope=None,
+            serialized_options=None,
+            file=DESCRIPTOR,
+            create_key=_descriptor._internal_create_key,
+        ),
+        _descriptor.FieldDescriptor(
+            name="overlap_xyz",
+            full_name="terachem_server.JobInput.overlap_xyz",
+            index=25,
+            number=36,
+            type=1,
+            cpp_type=5,
+            label=3,
+            has_default_value=False,
+            default_value=[],
+            message_type=None,
+            enum_type=None,
+            containing_type=None,
+            is_extension=False,
+            extension_scope=None,
+            serialized_options=None,
+            file=DESCRIPTOR,
+            create_key=_descriptor._internal_create_key,
+        ),
+        _descriptor.FieldDescriptor(
+            name="overlap_cvecs",
+            full_name="terachem_server.JobInput.overlap_cvecs",
+            index=26,
+            number=37,
+            type=1,
+            cpp_type=5,
+            label=3,
+            has_default_value=False,
+            default_value=[],
+            message_type=None,
+            enum_type=None,
+            containing_type=None,
+            is_extension=False,
+            extension_scope=None,
+            serialized_options=None,
+            file=DESCRIPTOR,
+            create_key=_descriptor._internal_create_key,
+        ),
+        _descriptor.FieldDescriptor(
+            name="overlap_orbs",
+            full_name="terachem_server.JobInput.overlap_orbs",
+            index=27,
+            number=38,
+            type=1,
+            cpp_type=5,
+            label=3,
+            has_default_value=False,
+            default_value=[],
+            message_type=None,
+            enum_type=None,
+            containing_type=None,
+            is_extension=False,
+            extension_scope=None,
+            serialized_options=None,
+            file=DESCRIPTOR,
+            create_key=_descriptor._internal_create_key,
+        ),
+        _descriptor.FieldDescriptor(
+            name="overlap_pairs",
+            full_name="terachem_server.JobInput.overlap_pairs",
+            index=28,
+            number=39,
+            type=5,
+            cpp_type=1,
+            label=3,
+            has_default_value=False,
+            default_value=[],
+            message_type=None,
+            enum_type=None,
+            containing_type=None,
+            is_extension=False,
+            extension_scope=None,
+            serialized_options=None,
+            file=DESCRIPTOR,
+            create_key=_descriptor._internal_create_key,
+        ),
     ],
     extensions=[],
     nested_types=[],
@@ -1202,8 +1651,8 @@ _JOBINPUT = _descriptor.Descriptor(
     syntax="proto3",
     extension_ranges=[],
     oneofs=[],
-    serialized_start=395,
-    serialized_end=1663,
+    serialized_start=719,
+    serialized_end=2215,
 )
 
 
@@ -1880,19 +2329,100 @@ _JOBOUTPUT = _descriptor.Descriptor(
             file=DESCRIPTOR,
             create_key=_descriptor._internal_create_key,
         ),
+        _descriptor.FieldDescriptor(
+            name="bond_order_f32",
+            full_name="terachem_server.JobOutput.bond_order_f32",
+            index=35,
+            number=41,
+            type=2,
+            cpp_type=6,
+            label=3,
+            has_default_value=False,
+            default_value=[],
+            message_type=None,
+            enum_type=None,
+            containing_type=None,
+            is_extension=False,
+            extension_scope=None,
+            serialized_options=None,
+            file=DESCRIPTOR,
+            create_key=_descriptor._internal_create_key,
+        ),
+        _descriptor.FieldDescriptor(
+            name="ci_vec_re_f32",
+            full_name="terachem_server.JobOutput.ci_vec_re_f32",
+            index=36,
+            number=42,
+            type=2,
+            cpp_type=6,
+            label=3,
+            has_default_value=False,
+            default_value=[],
+            message_type=None,
+            enum_type=None,
+            containing_type=None,
+            is_extension=False,
+            extension_scope=None,
+            serialized_options=None,
+            file=DESCRIPTOR,
+            create_key=_descriptor._internal_create_key,
+        ),
+        _descriptor.FieldDescriptor(
+            name="ci_vec_im_f32",
+            full_name="terachem_server.JobOutput.ci_vec_im_f32",
+            index=37,
+            number=43,
+            type=2,
+            cpp_type=6,
+            label=3,
+            has_default_value=False,
+            default_value=[],
+            message_type=None,
+            enum_type=None,
+            containing_type=None,
+            is_extension=False,
+            extension_scope=None,
+            serialized_options=None,
+            file=DESCRIPTOR,
+            create_key=_descriptor._internal_create_key,
+        ),
+        _descriptor.FieldDescriptor(
+            name="stage",
+            full_name="terachem_server.JobOutput.stage",
+            index=38,
+            number=44,
+            type=14,
+            cpp_type=8,
+            label=1,
+            has_default_value=False,
+            default_value=0,
+            message_type=None,
+            enum_type=None,
+            containing_type=None,
+            is_extension=False,
+            extension_scope=None,
+            serialized_options=None,
+            file=DESCRIPTOR,
+            create_key=_descriptor._internal_create_key,
+        ),
     ],
     extensions=[],
     nested_types=[],
-    enum_types=[],
+    enum_types=[
+        _JOBOUTPUT_OUTPUTSTAGE,
+    ],
     serialized_options=None,
     is_extendable=False,
     syntax="proto3",
     extension_ranges=[],
     oneofs=[],
-    serialized_start=1666,
-    serialized_end=2506,
+    serialized_start=2218,
+    serialized_end=3238,
 )
 
+_STATUS.fields_by_name["accept_compression"].enum_type = _STATUS_COMPRESSIONTYPE
+_STATUS.fields_by_name["compression"].enum_type = _STATUS_COMPRESSIONTYPE
+_STATUS_COMPRESSIONTYPE.containing_type = _STATUS
 _STATUS.oneofs_by_name["job_status"].fields.append(_STATUS.fields_by_name["accepted"])
 _STATUS.fields_by_name["accepted"].containing_oneof = _STATUS.oneofs_by_name[
     "job_status"
@@ -1905,6 +2435,10 @@ _STATUS.oneofs_by_name["job_status"].fields.append(_STATUS.fields_by_name["compl
 _STATUS.fields_by_name["completed"].containing_oneof = _STATUS.oneofs_by_name[
     "job_status"
 ]
+_STATUS.oneofs_by_name["job_status"].fields.append(_STATUS.fields_by_name["queued"])
+_STATUS.fields_by_name["queued"].containing_oneof = _STATUS.oneofs_by_name[
+    "job_status"
+]
 _MOL.fields_by_name["units"].enum_type = _MOL_UNITTYPE
 _MOL_UNITTYPE.containing_type = _MOL
 _JOBINPUT.fields_by_name["mol"].message_type = _MOL
@@ -1921,6 +2455,8 @@ _JOBINPUT_IMDTYPE.containing_type = _JOBINPUT
 _JOBINPUT_IMDORBITALTYPE.containing_type = _JOBINPUT
 _JOBINPUT_IMDADDITIONALOPTION.containing_type = _JOBINPUT
 _JOBOUTPUT.fields_by_name["mol"].message_type = _MOL
+_JOBOUTPUT.fields_by_name["stage"].enum_type = _JOBOUTPUT_OUTPUTSTAGE
+_JOBOUTPUT_OUTPUTSTAGE.containing_type = _JOBOUTPUT
 DESCRIPTOR.message_types_by_name["Status"] = _STATUS
 DESCRIPTOR.message_types_by_name["Mol"] = _MOL
 DESCRIPTOR.message_types_by_name["JobInput"] = _JOBINPUT
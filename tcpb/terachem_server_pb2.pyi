@@ -34,20 +34,54 @@ JOBOUTPUT = MessageType.V(3)
 
 class Status(google.protobuf.message.Message):
     DESCRIPTOR: google.protobuf.descriptor.Descriptor = ...
+    class _CompressionType(
+        google.protobuf.internal.enum_type_wrapper._EnumTypeWrapper[
+            CompressionType.V
+        ],
+        builtins.type,
+    ):
+        DESCRIPTOR: google.protobuf.descriptor.EnumDescriptor = ...
+        NO_COMPRESSION = Status.CompressionType.V(0)
+        ZLIB = Status.CompressionType.V(1)
+        ZSTD = Status.CompressionType.V(2)
+        LZ4 = Status.CompressionType.V(3)
+    class CompressionType(metaclass=_CompressionType):
+        V = typing.NewType("V", builtins.int)
+    NO_COMPRESSION = Status.CompressionType.V(0)
+    ZLIB = Status.CompressionType.V(1)
+    ZSTD = Status.CompressionType.V(2)
+    LZ4 = Status.CompressionType.V(3)
+
     BUSY_FIELD_NUMBER: builtins.int
     ACCEPTED_FIELD_NUMBER: builtins.int
     WORKING_FIELD_NUMBER: builtins.int
     COMPLETED_FIELD_NUMBER: builtins.int
+    QUEUED_FIELD_NUMBER: builtins.int
     JOB_DIR_FIELD_NUMBER: builtins.int
     JOB_SCR_DIR_FIELD_NUMBER: builtins.int
     SERVER_JOB_ID_FIELD_NUMBER: builtins.int
+    ACCEPT_COMPRESSION_FIELD_NUMBER: builtins.int
+    COMPRESSION_FIELD_NUMBER: builtins.int
+    SHARED_MEMORY_FIELD_NUMBER: builtins.int
+    SHARED_MEMORY_SIZE_FIELD_NUMBER: builtins.int
+    SHARED_MEMORY_ACCEPTED_FIELD_NUMBER: builtins.int
+    PARTIAL_OUTPUT_FIELD_NUMBER: builtins.int
     busy: builtins.bool = ...
     accepted: builtins.bool = ...
     working: builtins.bool = ...
     completed: builtins.bool = ...
+    queued: builtins.bool = ...
     job_dir: typing.Text = ...
     job_scr_dir: typing.Text = ...
     server_job_id: builtins.int = ...
+    accept_compression: google.protobuf.internal.containers.RepeatedScalarFieldContainer[
+        global___Status.CompressionType.V
+    ] = ...
+    compression: global___Status.CompressionType.V = ...
+    shared_memory: typing.Text = ...
+    shared_memory_size: builtins.int = ...
+    shared_memory_accepted: builtins.bool = ...
+    partial_output: builtins.bool = ...
     def __init__(
         self,
         *,
@@ -55,9 +89,18 @@ class Status(google.protobuf.message.Message):
         accepted: builtins.bool = ...,
         working: builtins.bool = ...,
         completed: builtins.bool = ...,
+        queued: builtins.bool = ...,
         job_dir: typing.Text = ...,
         job_scr_dir: typing.Text = ...,
         server_job_id: builtins.int = ...,
+        accept_compression: typing.Optional[
+            typing.Iterable[global___Status.CompressionType.V]
+        ] = ...,
+        compression: global___Status.CompressionType.V = ...,
+        shared_memory: typing.Text = ...,
+        shared_memory_size: builtins.int = ...,
+        shared_memory_accepted: builtins.bool = ...,
+        partial_output: builtins.bool = ...,
     ) -> None: ...
     def HasField(
         self,
@@ -68,6 +111,8 @@ class Status(google.protobuf.message.Message):
             b"completed",
             "job_status",
             b"job_status",
+            "queued",
+            b"queued",
             "working",
             b"working",
         ],
@@ -75,27 +120,41 @@ class Status(google.protobuf.message.Message):
     def ClearField(
         self,
         field_name: typing_extensions.Literal[
+            "accept_compression",
+            b"accept_compression",
             "accepted",
             b"accepted",
             "busy",
             b"busy",
             "completed",
             b"completed",
+            "compression",
+            b"compression",
             "job_dir",
             b"job_dir",
             "job_scr_dir",
             b"job_scr_dir",
             "job_status",
             b"job_status",
+            "partial_output",
+            b"partial_output",
+            "queued",
+            b"queued",
             "server_job_id",
             b"server_job_id",
+            "shared_memory",
+            b"shared_memory",
+            "shared_memory_accepted",
+            b"shared_memory_accepted",
+            "shared_memory_size",
+            b"shared_memory_size",
             "working",
             b"working",
         ],
     ) -> None: ...
     def WhichOneof(
         self, oneof_group: typing_extensions.Literal["job_status", b"job_status"]
-    ) -> typing_extensions.Literal["accepted", "working", "completed"]: ...
+    ) -> typing_extensions.Literal["accepted", "working", "completed", "queued"]: ...
 
 global___Status = Status
 
@@ -309,6 +368,18 @@ class JobInput(google.protobuf.message.Message):
     IMD_MMATOM_POSITION_FIELD_NUMBER: builtins.int
     IMD_MMATOM_INFO_FIELD_NUMBER: builtins.int
     IMD_ADDITIONAL_OPTION_FIELD_NUMBER: builtins.int
+    CVEC1_FIELD_NUMBER: builtins.int
+    CVEC2_FIELD_NUMBER: builtins.int
+    ORB1A_FIELD_NUMBER: builtins.int
+    ORB1B_FIELD_NUMBER: builtins.int
+    ORB2A_FIELD_NUMBER: builtins.int
+    ORB2B_FIELD_NUMBER: builtins.int
+    RETURN_FLOAT32_FIELD_NUMBER: builtins.int
+    PARTIAL_OUTPUTS_FIELD_NUMBER: builtins.int
+    OVERLAP_XYZ_FIELD_NUMBER: builtins.int
+    OVERLAP_CVECS_FIELD_NUMBER: builtins.int
+    OVERLAP_ORBS_FIELD_NUMBER: builtins.int
+    OVERLAP_PAIRS_FIELD_NUMBER: builtins.int
     run: global___JobInput.RunType.V = ...
     method: global___JobInput.MethodType.V = ...
     basis: typing.Text = ...
@@ -337,6 +408,38 @@ class JobInput(google.protobuf.message.Message):
         builtins.float
     ] = ...
     imd_additional_option: global___JobInput.ImdAdditionalOption.V = ...
+    cvec1: google.protobuf.internal.containers.RepeatedScalarFieldContainer[
+        builtins.float
+    ] = ...
+    cvec2: google.protobuf.internal.containers.RepeatedScalarFieldContainer[
+        builtins.float
+    ] = ...
+    orb1a: google.protobuf.internal.containers.RepeatedScalarFieldContainer[
+        builtins.float
+    ] = ...
+    orb1b: google.protobuf.internal.containers.RepeatedScalarFieldContainer[
+        builtins.float
+    ] = ...
+    orb2a: google.protobuf.internal.containers.RepeatedScalarFieldContainer[
+        builtins.float
+    ] = ...
+    orb2b: google.protobuf.internal.containers.RepeatedScalarFieldContainer[
+        builtins.float
+    ] = ...
+    return_float32: builtins.bool = ...
+    partial_outputs: builtins.bool = ...
+    overlap_xyz: google.protobuf.internal.containers.RepeatedScalarFieldContainer[
+        builtins.float
+    ] = ...
+    overlap_cvecs: google.protobuf.internal.containers.RepeatedScalarFieldContainer[
+        builtins.float
+    ] = ...
+    overlap_orbs: google.protobuf.internal.containers.RepeatedScalarFieldContainer[
+        builtins.float
+    ] = ...
+    overlap_pairs: google.protobuf.internal.containers.RepeatedScalarFieldContainer[
+        builtins.int
+    ] = ...
     @property
     def mol(self) -> global___Mol: ...
     def __init__(
@@ -359,6 +462,18 @@ class JobInput(google.protobuf.message.Message):
         imd_mmatom_position: typing.Optional[typing.Iterable[builtins.float]] = ...,
         imd_mmatom_info: typing.Optional[typing.Iterable[builtins.float]] = ...,
         imd_additional_option: global___JobInput.ImdAdditionalOption.V = ...,
+        cvec1: typing.Optional[typing.Iterable[builtins.float]] = ...,
+        cvec2: typing.Optional[typing.Iterable[builtins.float]] = ...,
+        orb1a: typing.Optional[typing.Iterable[builtins.float]] = ...,
+        orb1b: typing.Optional[typing.Iterable[builtins.float]] = ...,
+        orb2a: typing.Optional[typing.Iterable[builtins.float]] = ...,
+        orb2b: typing.Optional[typing.Iterable[builtins.float]] = ...,
+        return_float32: builtins.bool = ...,
+        partial_outputs: builtins.bool = ...,
+        overlap_xyz: typing.Optional[typing.Iterable[builtins.float]] = ...,
+        overlap_cvecs: typing.Optional[typing.Iterable[builtins.float]] = ...,
+        overlap_orbs: typing.Optional[typing.Iterable[builtins.float]] = ...,
+        overlap_pairs: typing.Optional[typing.Iterable[builtins.int]] = ...,
     ) -> None: ...
     def HasField(
         self, field_name: typing_extensions.Literal["mol", b"mol"]
@@ -368,6 +483,10 @@ class JobInput(google.protobuf.message.Message):
         field_name: typing_extensions.Literal[
             "basis",
             b"basis",
+            "cvec1",
+            b"cvec1",
+            "cvec2",
+            b"cvec2",
             "imd_additional_option",
             b"imd_additional_option",
             "imd_initial_orbital",
@@ -388,12 +507,32 @@ class JobInput(google.protobuf.message.Message):
             b"method",
             "mol",
             b"mol",
+            "orb1a",
+            b"orb1a",
             "orb1afile",
             b"orb1afile",
+            "orb1b",
+            b"orb1b",
             "orb1bfile",
             b"orb1bfile",
+            "orb2a",
+            b"orb2a",
+            "orb2b",
+            b"orb2b",
+            "overlap_cvecs",
+            b"overlap_cvecs",
+            "overlap_orbs",
+            b"overlap_orbs",
+            "overlap_pairs",
+            b"overlap_pairs",
+            "overlap_xyz",
+            b"overlap_xyz",
+            "partial_outputs",
+            b"partial_outputs",
             "return_bond_order",
             b"return_bond_order",
+            "return_float32",
+            b"return_float32",
             "run",
             b"run",
             "user_options",
@@ -407,6 +546,20 @@ global___JobInput = JobInput
 
 class JobOutput(google.protobuf.message.Message):
     DESCRIPTOR: google.protobuf.descriptor.Descriptor = ...
+    class _OutputStage(
+        google.protobuf.internal.enum_type_wrapper._EnumTypeWrapper[OutputStage.V],
+        builtins.type,
+    ):
+        DESCRIPTOR: google.protobuf.descriptor.EnumDescriptor = ...
+        FINAL = JobOutput.OutputStage.V(0)
+        ENERGIES = JobOutput.OutputStage.V(1)
+        GRADIENTS = JobOutput.OutputStage.V(2)
+    class OutputStage(metaclass=_OutputStage):
+        V = typing.NewType("V", builtins.int)
+    FINAL = JobOutput.OutputStage.V(0)
+    ENERGIES = JobOutput.OutputStage.V(1)
+    GRADIENTS = JobOutput.OutputStage.V(2)
+
     MOL_FIELD_NUMBER: builtins.int
     ENERGY_FIELD_NUMBER: builtins.int
     GRADIENT_FIELD_NUMBER: builtins.int
@@ -442,6 +595,10 @@ class JobOutput(google.protobuf.message.Message):
     COMPRESSED_PRIMITIVE_DATA_FIELD_NUMBER: builtins.int
     COMPRESSED_MO_VECTOR_FIELD_NUMBER: builtins.int
     IMD_MMATOM_GRADIENT_FIELD_NUMBER: builtins.int
+    BOND_ORDER_F32_FIELD_NUMBER: builtins.int
+    CI_VEC_RE_F32_FIELD_NUMBER: builtins.int
+    CI_VEC_IM_F32_FIELD_NUMBER: builtins.int
+    STAGE_FIELD_NUMBER: builtins.int
     energy: google.protobuf.internal.containers.RepeatedScalarFieldContainer[
         builtins.float
     ] = ...
@@ -528,6 +685,16 @@ class JobOutput(google.protobuf.message.Message):
     imd_mmatom_gradient: google.protobuf.internal.containers.RepeatedScalarFieldContainer[
         builtins.float
     ] = ...
+    bond_order_f32: google.protobuf.internal.containers.RepeatedScalarFieldContainer[
+        builtins.float
+    ] = ...
+    ci_vec_re_f32: google.protobuf.internal.containers.RepeatedScalarFieldContainer[
+        builtins.float
+    ] = ...
+    ci_vec_im_f32: google.protobuf.internal.containers.RepeatedScalarFieldContainer[
+        builtins.float
+    ] = ...
+    stage: global___JobOutput.OutputStage.V = ...
     @property
     def mol(self) -> global___Mol: ...
     def __init__(
@@ -570,6 +737,10 @@ class JobOutput(google.protobuf.message.Message):
         ] = ...,
         compressed_mo_vector: typing.Optional[typing.Iterable[builtins.float]] = ...,
         imd_mmatom_gradient: typing.Optional[typing.Iterable[builtins.float]] = ...,
+        bond_order_f32: typing.Optional[typing.Iterable[builtins.float]] = ...,
+        ci_vec_re_f32: typing.Optional[typing.Iterable[builtins.float]] = ...,
+        ci_vec_im_f32: typing.Optional[typing.Iterable[builtins.float]] = ...,
+        stage: global___JobOutput.OutputStage.V = ...,
     ) -> None: ...
     def HasField(
         self, field_name: typing_extensions.Literal["mol", b"mol"]
@@ -579,6 +750,8 @@ class JobOutput(google.protobuf.message.Message):
         field_name: typing_extensions.Literal[
             "bond_order",
             b"bond_order",
+            "bond_order_f32",
+            b"bond_order_f32",
             "cas_energy_mults",
             b"cas_energy_mults",
             "cas_energy_states",
@@ -593,8 +766,12 @@ class JobOutput(google.protobuf.message.Message):
             b"ci_overlaps",
             "ci_vec_im",
             b"ci_vec_im",
+            "ci_vec_im_f32",
+            b"ci_vec_im_f32",
             "ci_vec_re",
             b"ci_vec_re",
+            "ci_vec_re_f32",
+            b"ci_vec_re_f32",
             "cis_relaxed_dipoles",
             b"cis_relaxed_dipoles",
             "cis_states",
@@ -647,6 +824,8 @@ class JobOutput(google.protobuf.message.Message):
             b"server_job_id",
             "spins",
             b"spins",
+            "stage",
+            b"stage",
         ],
     ) -> None: ...
 
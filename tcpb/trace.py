@@ -0,0 +1,457 @@
+"""Recording of client traffic and replay of recorded JobOutputs
+
+TCProtobufClient(trace=directory) writes every framed message it sends and receives
+to a TraceStore: segment files of raw frames rotated at a fixed size, of which only
+the newest few are kept, each with an index holding the offset, type, size and
+compression codec of every frame. TraceReader memory-maps the segments (or a
+client_recv.bin/client_sent.bin file written with trace=True) so recorded messages
+are read without copying a whole trace into memory.
+
+TCProtobufClient(replay=trace) answers the client from a recorded trace instead of
+a server: ReplayTransport stands in for the socket, accepts every JobInput and
+returns the recorded JobOutputs in order, so downstream pipelines, load tests and
+the conversions in tcpb.utils run at full speed without a TeraChem server.
+"""
+
+import glob
+import mmap
+import os
+import threading
+from collections import deque
+
+import numpy as np
+
+from . import terachem_server_pb2 as pb
+from .framing import (
+    COMPRESSED_FLAG,
+    HEADER_SIZE,
+    decompress_body,
+    pack_header,
+    parse_msg,
+    split_msg_type,
+    unpack_header,
+)
+from .instrument import RECEIVED
+from .wire import encode_varint_field
+
+# Segment size after which a TraceStore starts a new segment file
+DEFAULT_SEGMENT_BYTES = 256 * 1024 * 1024
+# Number of segment files per direction a TraceStore keeps
+DEFAULT_MAX_SEGMENTS = 8
+
+# Index record of one frame: offset of its header in the segment, message type as
+# in the header (with COMPRESSED_FLAG), body size and codec of a compressed body
+INDEX_DTYPE = np.dtype(
+    [("offset", "<u8"), ("msg_type", "<u4"), ("size", "<u4"), ("codec", "<u4")]
+)
+
+
+# Segments being written by the _SegmentWriters of this process; TraceStores of the
+# clients of a TCPBPool share a directory, and none may prune another's segment
+_OPEN_SEGMENTS = set()
+_OPEN_SEGMENTS_LOCK = threading.Lock()
+
+
+def _segment_paths(directory, direction):
+    """Segment files of one direction of a TraceStore, oldest first"""
+    return sorted(glob.glob(os.path.join(directory, direction + "-*.bin")))
+
+
+def _index_path(segment_path):
+    return os.path.splitext(segment_path)[0] + ".idx"
+
+
+def scan_frames(buf):
+    """Index the frames of a buffer of concatenated messages
+
+    Args:
+        buf: Bytes-like object holding header + body frames, e.g. a trace file
+
+    Returns:
+        np.ndarray: One INDEX_DTYPE record per frame, with an unknown codec
+
+    Raises:
+        ValueError: The last frame is truncated
+    """
+    records = []
+    pos = 0
+    while pos < len(buf):
+        if pos + HEADER_SIZE > len(buf):
+            raise ValueError("Truncated header at byte {}".format(pos))
+        msg_type, msg_size = unpack_header(buf[pos : pos + HEADER_SIZE])
+        if pos + HEADER_SIZE + msg_size > len(buf):
+            raise ValueError("Truncated message at byte {}".format(pos))
+        records.append((pos, msg_type, msg_size, pb.Status.NO_COMPRESSION))
+        pos += HEADER_SIZE + msg_size
+    return np.array(records, dtype=INDEX_DTYPE)
+
+
+class _SegmentWriter(object):
+    """Rotating segment and index files of one direction of a TraceStore"""
+
+    def __init__(self, directory, direction, max_segment_bytes, max_segments):
+        self.directory = directory
+        self.direction = direction
+        self.max_segment_bytes = max_segment_bytes
+        self.max_segments = max_segments
+        existing = _segment_paths(directory, direction)
+        # Every writer starts a new segment after those of earlier clients
+        self._number = (
+            int(os.path.basename(existing[-1])[len(direction) + 1 : -4]) + 1
+            if existing
+            else 0
+        )
+        self._open()
+
+    def _open(self):
+        # Writers sharing the directory may pick the same number; whoever creates
+        # the file first owns it and the others move on to the next
+        while True:
+            path = os.path.join(
+                self.directory, "{}-{:06d}.bin".format(self.direction, self._number)
+            )
+            try:
+                self._data = open(path, "xb")
+                break
+            except FileExistsError:
+                self._number += 1
+        with _OPEN_SEGMENTS_LOCK:
+            _OPEN_SEGMENTS.add(path)
+        self._path = path
+        self._index = open(_index_path(path), "wb")
+        self._size = 0
+        self._prune()
+
+    def _prune(self):
+        """Delete the oldest segments beyond max_segments, except those other writers
+        of this process are still writing"""
+        if not self.max_segments:
+            return
+        paths = _segment_paths(self.directory, self.direction)
+        with _OPEN_SEGMENTS_LOCK:
+            stale_paths = [
+                path
+                for path in paths[: -self.max_segments]
+                if path not in _OPEN_SEGMENTS
+            ]
+        for path in stale_paths:
+            for stale in (path, _index_path(path)):
+                try:
+                    os.remove(stale)
+                except FileNotFoundError:
+                    pass
+
+    def write(self, header, body, codec):
+        nbytes = len(header) + len(body)
+        if self._size and self._size + nbytes > self.max_segment_bytes:
+            self.close()
+            self._number += 1
+            self._open()
+        msg_type, msg_size = unpack_header(header)
+        record = np.array([(self._size, msg_type, msg_size, codec)], dtype=INDEX_DTYPE)
+        self._data.write(header)
+        self._data.write(body)
+        self._index.write(record.tobytes())
+        self._size += nbytes
+
+    def flush(self):
+        self._data.flush()
+        self._index.flush()
+
+    def close(self):
+        self._data.close()
+        self._index.close()
+        with _OPEN_SEGMENTS_LOCK:
+            _OPEN_SEGMENTS.discard(self._path)
+
+
+class TraceStore(object):
+    """Directory of rotating, indexed segment files of the messages of a client
+
+    Sent and received frames are kept apart, in sent-NNNNNN.bin and
+    received-NNNNNN.bin segments with a .idx index each. A segment is closed once it
+    would grow beyond max_segment_bytes; only the newest max_segments segments of
+    each direction are kept, so a trace never takes more than about
+    2 * max_segments * max_segment_bytes of disk (plus the segments other clients
+    of the same process are writing to the directory).
+
+    Several clients (e.g. those of a TCPBPool) may trace to the same directory:
+    each writes its own segments, without truncating or deleting those of the
+    others. A TraceStore may also be shared by clients in different threads.
+    """
+
+    def __init__(
+        self,
+        directory,
+        max_segment_bytes=DEFAULT_SEGMENT_BYTES,
+        max_segments=DEFAULT_MAX_SEGMENTS,
+    ):
+        """Initialize a TraceStore object.
+
+        Args:
+            directory: Directory holding the segments; created if missing
+            max_segment_bytes (int): Size in bytes after which a new segment starts
+            max_segments (int): Number of segments kept per direction (None keeps all)
+        """
+        self.directory = os.fspath(directory)
+        self.max_segment_bytes = max_segment_bytes
+        self.max_segments = max_segments
+        self._writers = {}
+        self._lock = threading.Lock()
+        os.makedirs(self.directory, exist_ok=True)
+
+    def write(self, direction, header, body, codec=pb.Status.NO_COMPRESSION):
+        """Append a frame
+
+        Args:
+            direction: tcpb.instrument.SENT or RECEIVED
+            header: 8 byte header of the frame
+            body: Body of the frame as it went over the wire
+            codec: pb.Status.CompressionType of the body if it is compressed
+        """
+        with self._lock:
+            writer = self._writers.get(direction)
+            if writer is None:
+                writer = self._writers[direction] = _SegmentWriter(
+                    self.directory,
+                    direction,
+                    self.max_segment_bytes,
+                    self.max_segments,
+                )
+            writer.write(header, body, codec)
+
+    def flush(self):
+        """Flush written frames to disk so TraceReaders see them"""
+        with self._lock:
+            for writer in self._writers.values():
+                writer.flush()
+
+    def close(self):
+        """Close the current segments; later writes start new ones"""
+        with self._lock:
+            for writer in self._writers.values():
+                writer.close()
+            self._writers.clear()
+
+
+class TraceReader(object):
+    """Memory-mapped frames of one direction of a trace
+
+    >>> reader = TraceReader("traces")
+    >>> for job_output in reader.messages(pb.JOBOUTPUT):
+    >>>     ...
+
+    Bodies are views into the mapped files and are only valid until close().
+    """
+
+    def __init__(self, path, direction=RECEIVED):
+        """Initialize a TraceReader object.
+
+        Args:
+            path: TraceStore directory, or a client_recv.bin/client_sent.bin file
+                written with TCProtobufClient(trace=True)
+            direction: tcpb.instrument.RECEIVED or SENT frames of a TraceStore
+        """
+        self.path = os.fspath(path)
+        if os.path.isdir(self.path):
+            paths = _segment_paths(self.path, direction)
+        else:
+            paths = [self.path]
+
+        self._buffers = []
+        indexes = []
+        for path in paths:
+            if not os.path.getsize(path):
+                continue
+            with open(path, "rb") as f:
+                buf = mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ)
+            index_path = _index_path(path)
+            if path != self.path and os.path.exists(index_path):
+                index = np.fromfile(index_path, dtype=INDEX_DTYPE)
+            else:
+                index = scan_frames(buf)
+            self._buffers.append(buf)
+            indexes.append(index)
+
+        # Frame records of all segments and the segment each frame is in
+        self.index = np.concatenate([np.zeros(0, dtype=INDEX_DTYPE)] + indexes)
+        self._segment = np.repeat(
+            np.arange(len(indexes)), [len(index) for index in indexes]
+        )
+        self.msg_types = self.index["msg_type"] & ~np.uint32(COMPRESSED_FLAG)
+
+    def __len__(self):
+        return len(self.index)
+
+    def __getitem__(self, i):
+        """Message type and serialized body of frame i
+
+        Returns:
+            tuple: (message type, bytes-like serialized protobuf)
+
+        Raises:
+            ValueError: The body is compressed with a codec that was not recorded or
+                is not available here
+        """
+        record = self.index[i]
+        msg_type, compressed = split_msg_type(int(record["msg_type"]))
+        start = int(record["offset"]) + HEADER_SIZE
+        buf = memoryview(self._buffers[self._segment[i]])
+        body = buf[start : start + int(record["size"])]
+        if compressed:
+            body = decompress_body(body, int(record["codec"]))
+        return msg_type, body
+
+    def indices(self, msg_type):
+        """Positions of the frames of one message type
+
+        Args:
+            msg_type: Message type (defined as enum in protocol buffer)
+
+        Returns:
+            np.ndarray: Frame indices, in recorded order
+        """
+        return np.flatnonzero(self.msg_types == msg_type)
+
+    def messages(self, msg_type=None):
+        """Parse recorded messages
+
+        Args:
+            msg_type: Only parse messages of this type (all by default)
+
+        Yields:
+            protobuf: Protocol Buffer of each frame
+        """
+        indices = range(len(self)) if msg_type is None else self.indices(msg_type)
+        for i in indices:
+            recv_type, body = self[i]
+            yield parse_msg(recv_type, body)
+
+    def close(self):
+        """Unmap the trace files"""
+        for buf in self._buffers:
+            try:
+                buf.close()
+            except BufferError:
+                # Bodies handed out are still in use; unmapped once collected
+                pass
+        self._buffers = []
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, type, value, traceback):
+        self.close()
+
+
+class ReplayTransport(object):
+    """Socket stand-in answering a TCProtobufClient from a recorded trace
+
+    Every JobInput is accepted and every job completes at its first status check,
+    answered with the next recorded JobOutput (cycling through them), whose
+    server_job_id is set to the id the job was accepted with. Compression is never
+    negotiated and status requests without a job in flight report an idle server.
+    """
+
+    def __init__(self, trace, cycle=True):
+        """Initialize a ReplayTransport object.
+
+        Args:
+            trace: TraceReader of received frames, or a path as accepted by it
+            cycle (bool): Start over at the first JobOutput once all were served;
+                otherwise the connection is closed after the last one
+        """
+        if not isinstance(trace, TraceReader):
+            trace = TraceReader(trace)
+        self.trace = trace
+        self.cycle = cycle
+        self._outputs = trace.indices(pb.JOBOUTPUT)
+        if not len(self._outputs):
+            raise ValueError("No JobOutput recorded in {}".format(trace.path))
+        self.jobs_served = 0
+        self._jobs = deque()
+        self._last_job_id = 0
+        self._request = bytearray()
+        self._replies = deque()
+        self._reply = memoryview(b"")
+
+    def settimeout(self, timeout):
+        pass
+
+    def shutdown(self, how):
+        pass
+
+    def close(self):
+        pass
+
+    def sendall(self, data):
+        """Take bytes of the client's messages and queue the answers to complete ones"""
+        self._request += data
+        while len(self._request) >= HEADER_SIZE:
+            msg_type, msg_size = unpack_header(self._request)
+            end = HEADER_SIZE + msg_size
+            if len(self._request) < end:
+                break
+            body = bytes(self._request[HEADER_SIZE:end])
+            del self._request[:end]
+            self._answer(split_msg_type(msg_type)[0], body)
+
+    def recv_into(self, view, nbytes=0):
+        """Copy queued answer bytes into view; 0 once nothing is left to answer"""
+        nbytes = nbytes or len(view)
+        if not len(self._reply):
+            if not self._replies:
+                return 0
+            self._reply = memoryview(self._replies.popleft())
+        n = min(nbytes, len(self._reply))
+        view[:n] = self._reply[:n]
+        self._reply = self._reply[n:]
+        return n
+
+    def _reply_msg(self, msg_type, msg_str):
+        self._replies.append(pack_header(msg_type, len(msg_str)) + msg_str)
+
+    def _answer(self, msg_type, body):
+        if msg_type == pb.JOBINPUT:
+            self._last_job_id += 1
+            self._jobs.append(self._last_job_id)
+            status = pb.Status(
+                accepted=True,
+                server_job_id=self._last_job_id,
+                job_dir="replay/{}".format(self._last_job_id),
+            )
+            self._reply_msg(pb.STATUS, status.SerializeToString())
+        elif msg_type == pb.STATUS:
+            request = pb.Status()
+            request.ParseFromString(body)
+            if len(request.accept_compression) or not self._jobs:
+                self._reply_msg(pb.STATUS, b"")
+                return
+            job_id = request.server_job_id
+            if job_id in self._jobs:
+                self._jobs.remove(job_id)
+            else:
+                job_id = self._jobs.popleft()
+            output = self._next_output()
+            if output is None:
+                return
+            status = pb.Status(completed=True, server_job_id=job_id)
+            self._reply_msg(pb.STATUS, status.SerializeToString())
+            # Appended fields override the recorded ones (see tcpb.wire)
+            self._reply_msg(
+                pb.JOBOUTPUT,
+                bytes(output)
+                + encode_varint_field(pb.JobOutput.SERVER_JOB_ID_FIELD_NUMBER, job_id),
+            )
+        else:
+            raise ValueError(
+                "Cannot replay an answer to message type {}".format(msg_type)
+            )
+
+    def _next_output(self):
+        """Serialized next recorded JobOutput, or None once all were served"""
+        if self.jobs_served >= len(self._outputs) and not self.cycle:
+            return None
+        i = self._outputs[self.jobs_served % len(self._outputs)]
+        self.jobs_served += 1
+        return self.trace[i][1]
@@ -1,13 +1,153 @@
-from typing import Union, List
+import os
+from collections.abc import Mapping
+from typing import List, Optional, Union
 
-from google.protobuf.json_format import MessageToDict
-from numpy import array
+from google.protobuf.descriptor import FieldDescriptor
+import numpy as np
 from qcelemental.models import AtomicInput, AtomicResult, Molecule
 from qcelemental import Datum
 from qcelemental.models.results import AtomicResultProperties, Provenance
 
 from . import terachem_server_pb2 as pb
-from .molden_constructor import tcpb_imd_fields2molden_string
+from .exceptions import TCPBError
+from .molden_constructor import (
+    tcpb_imd_fields2molden_file,
+    tcpb_imd_fields2molden_string,
+)
+from .wire import FIXED_WIDTH_DTYPES, packed_field_arrays
+
+
+# NumPy dtype matching each protobuf scalar type of repeated numeric fields
+_CPPTYPE_DTYPES = {
+    FieldDescriptor.CPPTYPE_DOUBLE: np.float64,
+    FieldDescriptor.CPPTYPE_FLOAT: np.float32,
+    FieldDescriptor.CPPTYPE_INT32: np.int32,
+    FieldDescriptor.CPPTYPE_UINT32: np.uint32,
+    FieldDescriptor.CPPTYPE_INT64: np.int64,
+    FieldDescriptor.CPPTYPE_UINT64: np.uint64,
+}
+
+# JobOutput fields reported in AtomicResult.extras["qcvars"], keyed by qcvar name
+_QCVAR_FIELDS = {
+    "charges": "charges",
+    "spins": "spins",
+    "job_dir": "job_dir",
+    "job_scr_dir": "job_scr_dir",
+    "server_job_id": "server_job_id",
+    "orb1afile": "orb1afile",
+    "orb1bfile": "orb1bfile",
+    "bond_order": "bond_order",
+    "orba_energies": "orba_energies",
+    "orba_occupations": "orba_occupations",
+    "orbb_energies": "orbb_energies",
+    "orbb_occupations": "orbb_occupations",
+    "excited_state_energies": "energy",
+    "cis_transition_dipoles": "cis_transition_dipoles",
+}
+
+# Float32 JobOutput fields the server fills instead of the double field they copy
+# when JobInput.return_float32 is set
+FLOAT32_FIELDS = {
+    "bond_order": "bond_order_f32",
+    "ci_vec_re": "ci_vec_re_f32",
+    "ci_vec_im": "ci_vec_im_f32",
+}
+
+# Fixed width fields with at least this many values are read straight from the
+# serialized message instead of element by element (see tcpb.wire)
+WIRE_ARRAY_MIN_SIZE = 1024
+
+
+def repeated_to_array(values, dtype=np.float64) -> np.ndarray:
+    """Build a NumPy array from a protobuf repeated scalar container without an
+    intermediate Python list"""
+    return np.fromiter(values, dtype=dtype, count=len(values))
+
+
+class JobOutputArrays(Mapping):
+    """Read-only mapping of the repeated numeric fields of a JobOutput to NumPy arrays
+
+    Each field is converted on first access and cached, so large fields that are
+    never looked at (MO vectors, CI vectors, ...) are never converted. Arrays keep the
+    precision of the protobuf field (e.g. float32 for the compressed_* fields). The
+    double fields of FLOAT32_FIELDS fall back to their float32 copy when the server
+    filled that instead. Iteration only covers non-empty fields.
+
+    Large double and float fields are not converted value by value: on first access
+    to one, the message is serialized again (the received bytes are gone by then, as
+    the client reuses its receive buffer) and the arrays are views into that copy, so
+    they cost one serialization rather than a Python object per element.
+    """
+
+    def __init__(
+        self, job_output: pb.JobOutput, wire_min_size: int = WIRE_ARRAY_MIN_SIZE
+    ):
+        """Initialize a JobOutputArrays object.
+
+        Args:
+            job_output: JobOutput protobuf message
+            wire_min_size: Fixed width fields with at least this many values are read
+                from the serialized message; 0 reads every such field from it, which
+                pays off when most fields are converted anyway
+        """
+        self._job_output = job_output
+        self.wire_min_size = wire_min_size
+        self._arrays: dict = {}
+        self._wire_arrays: Optional[dict] = None
+
+    def __getitem__(self, name: str) -> np.ndarray:
+        try:
+            return self._arrays[name]
+        except KeyError:
+            pass
+        field = self._job_output.DESCRIPTOR.fields_by_name.get(name)
+        if (
+            field is None
+            or field.label != FieldDescriptor.LABEL_REPEATED
+            or field.cpp_type not in _CPPTYPE_DTYPES
+        ):
+            raise KeyError(name)
+
+        values = getattr(self._job_output, name)
+        float32_name = FLOAT32_FIELDS.get(name)
+        if (
+            float32_name is not None
+            and not len(values)
+            and len(getattr(self._job_output, float32_name))
+        ):
+            self._arrays[name] = self[float32_name]
+            return self._arrays[name]
+        array = None
+        if (
+            field.type in FIXED_WIDTH_DTYPES
+            and len(values)
+            and len(values) >= self.wire_min_size
+        ):
+            if self._wire_arrays is None:
+                msg_str = bytearray(self._job_output.SerializeToString())
+                self._wire_arrays = packed_field_arrays(
+                    self._job_output.DESCRIPTOR, msg_str
+                )
+            array = self._wire_arrays.get(name)
+        if array is None:
+            array = repeated_to_array(values, _CPPTYPE_DTYPES[field.cpp_type])
+        else:
+            # Native byte order, as for the converted fields
+            array = array.astype(array.dtype.newbyteorder("="), copy=False)
+        self._arrays[name] = array
+        return array
+
+    def __iter__(self):
+        for field in self._job_output.DESCRIPTOR.fields:
+            if (
+                field.label == FieldDescriptor.LABEL_REPEATED
+                and field.cpp_type in _CPPTYPE_DTYPES
+                and len(getattr(self._job_output, field.name))
+            ):
+                yield field.name
+
+    def __len__(self):
+        return sum(1 for _ in self)
 
 
 def atomic_input_to_job_input(atomic_input: AtomicInput) -> pb.JobInput:
@@ -26,10 +166,15 @@ def atomic_input_to_job_input(atomic_input: AtomicInput) -> pb.JobInput:
     ji = pb.JobInput(mol=mol_msg)
 
     # Set driver
-    try:
-        ji.run = getattr(pb.JobInput.RunType, atomic_input.driver.upper())
-    except AttributeError:
-        raise ValueError(f"Driver '{atomic_input.driver}' not supported by TCPB.")
+    if atomic_input.driver == "hessian":
+        # Servers return their Hessian with the gradient when asked to
+        ji.run = pb.JobInput.RunType.GRADIENT
+        ji.imd_type = pb.JobInput.ImdType.IMD_HESSIAN
+    else:
+        try:
+            ji.run = getattr(pb.JobInput.RunType, atomic_input.driver.upper())
+        except AttributeError:
+            raise ValueError(f"Driver '{atomic_input.driver}' not supported by TCPB.")
 
     # Set Method
     try:
@@ -40,6 +185,7 @@ def atomic_input_to_job_input(atomic_input: AtomicInput) -> pb.JobInput:
     # Set protobuf specific keywords that should fall under the "user_options" catch all
     ji.basis = atomic_input.model.basis
     ji.return_bond_order = atomic_input.keywords.pop("bond_order", False)
+    ji.return_float32 = atomic_input.keywords.pop("float32", False)
     ji.imd_orbital_type = getattr(
         pb.JobInput.ImdOrbitalType,
         atomic_input.keywords.pop("imd_orbital_type", "NO_ORBITAL").upper(),
@@ -50,6 +196,10 @@ def atomic_input_to_job_input(atomic_input: AtomicInput) -> pb.JobInput:
     atomic_input.keywords.pop("spinmult", None)
 
     for key, value in atomic_input.keywords.items():
+        if key == "molden" and isinstance(value, os.PathLike):
+            # Client-side path (see job_output_to_atomic_result); the server only
+            # needs to know that orbitals are wanted
+            value = True
         ji.user_options.extend([key, str(value)])
 
     return ji
@@ -58,10 +208,10 @@ def atomic_input_to_job_input(atomic_input: AtomicInput) -> pb.JobInput:
 def mol_to_molecule(mol: pb.Mol) -> Molecule:
     """Convert mol protobuf message to Molecule"""
     if mol.units == pb.Mol.UnitType.ANGSTROM:
-        geom_angstrom = Datum("geometry", "angstrom", array(mol.xyz))
+        geom_angstrom = Datum("geometry", "angstrom", np.array(mol.xyz))
         geom_bohr = geom_angstrom.to_units("bohr")
     elif mol.units == pb.Mol.UnitType.BOHR:
-        geom_bohr = array(mol.xyz)
+        geom_bohr = np.array(mol.xyz)
     else:
         raise ValueError(f"Unknown Unit Type: {mol.units} for molecular geometry")
     return Molecule(
@@ -71,29 +221,188 @@ def mol_to_molecule(mol: pb.Mol) -> Molecule:
     )
 
 
+def job_output_to_results_dict(
+    output: pb.JobOutput, arrays: Optional[JobOutputArrays] = None
+) -> dict:
+    """Convert JobOutput to the results dictionary returned by
+    TCProtobufClient.recv_job_async(), using NumPy arrays when appropriate.
+
+    See TCProtobufClient.recv_job_async() for the members of the dictionary.
+
+    All large arrays are extracted in one pass: the message is serialized once and
+    every large packed field is read from that buffer (see JobOutputArrays), so they
+    are views into one buffer rather than separate copies; small fields are converted
+    directly. Per-state CIS dipoles are rows of one (states, 3) array.
+
+    Args:
+        output: JobOutput protobuf message
+        arrays: JobOutputArrays of output to take the arrays from (e.g. when output
+            is also converted otherwise); by default a new one
+
+    Returns:
+        dict: Results as described in TCProtobufClient.recv_job_async()
+    """
+    if arrays is None:
+        arrays = JobOutputArrays(output)
+    dipoles = arrays["dipoles"]
+
+    # Parse output into normal python dictionary
+    results = {
+        "atoms": np.array(output.mol.atoms, dtype="S2"),
+        "geom": repeated_to_array(output.mol.xyz).reshape(-1, 3),
+        "charges": arrays["charges"],
+        "spins": arrays["spins"],
+        "dipole_moment": output.dipoles[3],
+        "dipole_vector": dipoles[:3],
+        "job_dir": output.job_dir,
+        "job_scr_dir": output.job_scr_dir,
+        "server_job_id": output.server_job_id,
+    }
+
+    energy = arrays["energy"]
+    if len(energy):
+        results["energy"] = output.energy[0]
+
+    if output.mol.closed is True:
+        results["orbfile"] = output.orb1afile
+
+        results["orb_energies"] = arrays["orba_energies"]
+        results["orb_occupations"] = arrays["orba_occupations"]
+    else:
+        results["orbfile_a"] = output.orb1afile
+        results["orbfile_b"] = output.orb1bfile
+
+        results["orb_energies_a"] = arrays["orba_energies"]
+        results["orb_occupations_a"] = arrays["orba_occupations"]
+        results["orb_energies_b"] = arrays["orbb_energies"]
+        results["orb_occupations_b"] = arrays["orbb_occupations"]
+
+    for name in ("gradient", "nacme"):
+        if len(arrays[name]):
+            results[name] = arrays[name].reshape(-1, 3)
+
+    if len(arrays["cas_transition_dipole"]):
+        results["cas_transition_dipole"] = arrays["cas_transition_dipole"]
+
+    nstates = len(output.cas_energy_states)
+    if nstates:
+        results["energy"] = energy[:nstates]
+        results["cas_energy_labels"] = list(
+            zip(output.cas_energy_states, output.cas_energy_mults)
+        )
+
+    bond_order = arrays["bond_order"]
+    if len(bond_order):
+        nAtoms = len(output.mol.atoms)
+        results["bond_order"] = bond_order.reshape(nAtoms, nAtoms)
+
+    if len(arrays["ci_overlaps"]):
+        results["ci_overlap"] = arrays["ci_overlaps"].reshape(
+            output.ci_overlap_size, output.ci_overlap_size
+        )
+
+    cis_states = output.cis_states
+    if cis_states > 0:
+        results["energy"] = energy[: cis_states + 1]
+        results["cis_states"] = cis_states
+
+        # Dipoles are stored as (x, y, z, magnitude) per state or state pair
+        ntransitions = (cis_states + 1) * cis_states // 2
+        for name, count in (
+            ("cis_unrelaxed_dipoles", cis_states),
+            ("cis_relaxed_dipoles", cis_states),
+            ("cis_transition_dipoles", ntransitions),
+        ):
+            values = arrays[name]
+            if len(values) % 4:
+                raise TCPBError(
+                    "JobOutput {} holds {} values; expected (x, y, z, magnitude) "
+                    "per state".format(name, len(values))
+                )
+            if len(values):
+                results[name] = list(values.reshape(-1, 4)[:count, :3])
+
+    if len(output.compressed_mo_vector):
+        results["molden"] = tcpb_imd_fields2molden_string(output)
+
+    return results
+
+
+def _field_value(
+    job_output: pb.JobOutput, name: str, arrays: Optional[JobOutputArrays] = None
+):
+    """Value of a JobOutput field for AtomicResult.extras; None if the field is unset
+
+    Repeated fields become lists, or NumPy arrays if arrays is given. Fields of
+    FLOAT32_FIELDS are read from their float32 copy if the server filled that instead.
+    """
+    value = getattr(job_output, name)
+    field = job_output.DESCRIPTOR.fields_by_name[name]
+    if field.label == FieldDescriptor.LABEL_REPEATED:
+        if not len(value) and name in FLOAT32_FIELDS:
+            name = FLOAT32_FIELDS[name]
+            value = getattr(job_output, name)
+        if not len(value):
+            return None
+        return arrays[name] if arrays is not None else list(value)
+    return value or None
+
+
 def job_output_to_atomic_result(
-    *, atomic_input: AtomicInput, job_output: pb.JobOutput
+    *, atomic_input: AtomicInput, job_output: pb.JobOutput, raw_arrays: bool = False
 ) -> AtomicResult:
-    """Convert JobOutput to AtomicResult"""
-    # Convert job_output to python types
-    # NOTE: Required so that AtomicResult is JSON serializable. Protobuf types are not.
-    jo_dict = MessageToDict(job_output, preserving_proto_field_name=True)
+    """Convert JobOutput to AtomicResult
+
+    Only the fields reported in the result are converted. By default they become
+    plain Python types so the AtomicResult is JSON serializable (protobuf types are
+    not).
+
+    With raw_arrays=True, repeated fields are NumPy arrays instead and every repeated
+    numeric field of the JobOutput is available in extras["job_output_arrays"] as a
+    JobOutputArrays mapping, converted on first access. Such results are not JSON
+    serializable.
+
+    If the "molden" keyword is set, extras["molden"] holds the molden file contents.
+    If it is a path-like object (e.g. a pathlib.Path), the molden file is written
+    there and extras["molden"] holds the path as a string instead; plain strings such
+    as "yes" are never treated as paths.
+    """
+    arrays = JobOutputArrays(job_output) if raw_arrays else None
 
     if atomic_input.driver == "energy":
         # Select first element in list (ground state); may need to modify for excited
         # state
-        return_result: Union[float, List[float]] = jo_dict["energy"][0]
+        return_result: Union[float, List[float], np.ndarray] = job_output.energy[0]
 
     elif atomic_input.driver == "gradient":
-        return_result = jo_dict["gradient"]
+        return_result = _field_value(job_output, "gradient", arrays)
+
+    elif atomic_input.driver == "hessian":
+        ncoords = 3 * len(job_output.mol.atoms)
+        if len(job_output.compressed_hessian) != ncoords * ncoords:
+            raise ValueError(
+                "Server returned no Hessian; compute it from gradients with "
+                "TCPBPool.submit_hessian()"
+            )
+        return_result = (
+            (arrays or JobOutputArrays(job_output))["compressed_hessian"]
+            .astype(np.float64)
+            .reshape(ncoords, ncoords)
+        )
 
     else:
         raise ValueError(f"Unsupported driver: {atomic_input.driver}")
 
-    if atomic_input.keywords.get("molden"):
-        # If molden file was request
+    molden = atomic_input.keywords.get("molden")
+    if molden:
+        # If molden file was request; a path streams the file to disk and only the
+        # path is kept in the result
         try:
-            molden_string = tcpb_imd_fields2molden_string(job_output)
+            if isinstance(molden, os.PathLike):
+                written = tcpb_imd_fields2molden_file(job_output, molden)
+                molden_string = os.fspath(molden) if written else None
+            else:
+                molden_string = tcpb_imd_fields2molden_string(job_output)
         except Exception:
             # Don't know how this code will blow up, so except everything for now :/
             molden_string = "Unable to create molden output"
@@ -121,24 +430,14 @@ def job_output_to_atomic_result(
     atomic_result.extras.update(
         {
             "qcvars": {
-                "charges": jo_dict.get("charges"),
-                "spins": jo_dict.get("spins"),
-                "job_dir": jo_dict.get("job_dir"),
-                "job_scr_dir": jo_dict.get("job_scr_dir"),
-                "server_job_id": jo_dict.get("server_job_id"),
-                "orb1afile": jo_dict.get("orb1afile"),
-                "orb1bfile": jo_dict.get("orb1bfile"),
-                "bond_order": jo_dict.get("bond_order"),
-                "orba_energies": jo_dict.get("orba_energies"),
-                "orba_occupations": jo_dict.get("orba_occupations"),
-                "orbb_energies": jo_dict.get("orbb_energies"),
-                "orbb_occupations": jo_dict.get("orbb_occupations"),
-                "excited_state_energies": jo_dict.get("energy"),
-                "cis_transition_dipoles": jo_dict.get("cis_transition_dipoles"),
+                qcvar: _field_value(job_output, field, arrays)
+                for qcvar, field in _QCVAR_FIELDS.items()
             },
             "molden": molden_string,
         }
     )
+    if arrays is not None:
+        atomic_result.extras["job_output_arrays"] = arrays
     return atomic_result
 
 
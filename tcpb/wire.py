@@ -0,0 +1,173 @@
+"""NumPy views of packed numeric fields in serialized protobuf messages
+
+Converting a repeated field through the protobuf Python API touches every element
+as a Python object. In the protobuf wire format, repeated fixed width fields
+(double, float, fixed32, ...) of proto3 messages are stored packed: a tag, a byte
+length, then the values as little endian machine numbers. Scanning the top-level
+fields of a serialized message therefore locates each such array, which NumPy can
+then use in place with np.frombuffer instead of converting it element by element.
+
+Going the other way, protobuf parsers merge a message that appears several times:
+scalar fields take the last value, repeated fields are concatenated and nested
+messages are merged recursively. Appending a few encoded fields to a serialized
+message therefore updates it without parsing or serializing it again.
+"""
+
+import numpy as np
+from google.protobuf.descriptor import FieldDescriptor
+
+# Little endian NumPy dtype of each fixed width protobuf scalar type
+FIXED_WIDTH_DTYPES = {
+    FieldDescriptor.TYPE_DOUBLE: np.dtype("<f8"),
+    FieldDescriptor.TYPE_FLOAT: np.dtype("<f4"),
+    FieldDescriptor.TYPE_FIXED64: np.dtype("<u8"),
+    FieldDescriptor.TYPE_SFIXED64: np.dtype("<i8"),
+    FieldDescriptor.TYPE_FIXED32: np.dtype("<u4"),
+    FieldDescriptor.TYPE_SFIXED32: np.dtype("<i4"),
+}
+
+# Wire types (the low 3 bits of a field tag)
+_WIRETYPE_VARINT = 0
+_WIRETYPE_FIXED64 = 1
+_WIRETYPE_LENGTH_DELIMITED = 2
+_WIRETYPE_FIXED32 = 5
+
+
+def _read_varint(buf, pos):
+    """Decode the varint starting at buf[pos]
+
+    Returns:
+        tuple: (value, position after the varint)
+    """
+    value = 0
+    shift = 0
+    while True:
+        byte = buf[pos]
+        pos += 1
+        value |= (byte & 0x7F) << shift
+        if not byte & 0x80:
+            return value, pos
+        shift += 7
+
+
+def encode_varint(value):
+    """Encode a non-negative integer as a varint"""
+    if value < 0:
+        raise ValueError("Cannot encode negative value {} as a varint".format(value))
+    out = bytearray()
+    while value > 0x7F:
+        out.append((value & 0x7F) | 0x80)
+        value >>= 7
+    out.append(value)
+    return bytes(out)
+
+
+def encode_varint_field(number, value):
+    """Encode an integer, bool or enum field
+
+    Args:
+        number (int): Field number
+        value (int): Non-negative value
+
+    Returns:
+        bytes: Tag and value
+    """
+    return encode_varint(number << 3 | _WIRETYPE_VARINT) + encode_varint(value)
+
+
+def encode_length_delimited(number, payload):
+    """Encode a string, bytes, packed repeated or nested message field
+
+    Args:
+        number (int): Field number
+        payload: Bytes-like object holding the encoded string, values or message
+
+    Returns:
+        bytes: Tag, length and payload
+    """
+    return (
+        encode_varint(number << 3 | _WIRETYPE_LENGTH_DELIMITED)
+        + encode_varint(len(payload))
+        + bytes(payload)
+    )
+
+
+def encode_packed_array(number, values, dtype):
+    """Encode a packed fixed width repeated field from an array in one copy
+
+    Args:
+        number (int): Field number
+        values: Array-like of the field values
+        dtype: Little endian NumPy dtype of the field (see FIXED_WIDTH_DTYPES)
+
+    Returns:
+        bytes: Tag, length and values, or nothing for an empty array
+    """
+    payload = np.ascontiguousarray(values, dtype=dtype).tobytes()
+    if not payload:
+        return b""
+    return encode_length_delimited(number, payload)
+
+
+def packed_field_arrays(descriptor, buf):
+    """Find the packed fixed width repeated fields of a serialized message
+
+    Only top-level fields are scanned; nested messages and other fields are skipped
+    over without being decoded.
+
+    Args:
+        descriptor: Descriptor of the serialized message type (e.g. pb.JobOutput.DESCRIPTOR)
+        buf: Bytes-like object holding the serialized message; the returned arrays
+            are views into it, writable if buf is
+
+    Returns:
+        dict: Field name to NumPy array for every packed fixed width repeated field
+        present in buf. Fields that are missing, empty or not stored as a single
+        packed run (never the case for messages serialized by protobuf) are omitted.
+    """
+    packed = {}
+    for field in descriptor.fields:
+        if (
+            field.label == FieldDescriptor.LABEL_REPEATED
+            and field.type in FIXED_WIDTH_DTYPES
+        ):
+            packed[field.number] = field
+
+    view = memoryview(buf).cast("B")
+    arrays = {}
+    seen = set()
+    pos, end = 0, len(view)
+    while pos < end:
+        tag, pos = _read_varint(view, pos)
+        number, wire_type = tag >> 3, tag & 0x7
+        if number in packed and wire_type != _WIRETYPE_LENGTH_DELIMITED:
+            # Unpacked element of a packed field; let the caller decode it instead
+            arrays.pop(packed[number].name, None)
+            seen.add(number)
+        if wire_type == _WIRETYPE_VARINT:
+            _, pos = _read_varint(view, pos)
+        elif wire_type == _WIRETYPE_FIXED64:
+            pos += 8
+        elif wire_type == _WIRETYPE_FIXED32:
+            pos += 4
+        elif wire_type == _WIRETYPE_LENGTH_DELIMITED:
+            length, pos = _read_varint(view, pos)
+            field = packed.get(number)
+            if field is not None:
+                if number in seen:
+                    # Split into several runs
+                    arrays.pop(field.name, None)
+                else:
+                    dtype = FIXED_WIDTH_DTYPES[field.type]
+                    arrays[field.name] = np.frombuffer(
+                        view[pos : pos + length], dtype=dtype
+                    )
+                seen.add(number)
+            pos += length
+        else:
+            raise ValueError(
+                "Unsupported protobuf wire type {} for field {}".format(
+                    wire_type, number
+                )
+            )
+    return arrays
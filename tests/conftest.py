@@ -1,11 +1,26 @@
+import socket
+from collections import deque
+import threading
 from typing import Collection, Union
 from pathlib import Path
 
+import numpy as np
 import pytest
 from qcelemental.models import Molecule, AtomicInput
 from qcelemental.models.common_models import Model
 
 from tcpb import terachem_server_pb2 as pb
+from tcpb.framing import (
+    HEADER_SIZE,
+    SHM_FLAG,
+    decompress_body,
+    parse_msg,
+    serialize_msg,
+    split_msg_type,
+    unpack_header,
+)
+from tcpb.partial import split_job_output
+from tcpb.shm import SharedMemoryChannel
 
 
 @pytest.fixture
@@ -70,6 +85,204 @@ def job_output():
     return job_output_correct_answer
 
 
+class FakeTCPBServer(object):
+    """Threaded stand-in for a TeraChem server
+
+    Accepts one job per connection at a time, reports it as working for
+    working_polls Status requests and then replies with job_output. The first
+    busy_replies JobInputs are rejected as if another client were running a job.
+    If a client offers the compression codec, it is used for every message body.
+    With queue_jobs, JobInputs are accepted while a job runs and run one after the
+    other; Status requests report on the job with their server_job_id.
+    With shared_memory, a shared memory segment offered by a client is mapped and
+    carries every JobOutput and the large bodies the client places there.
+    Jobs asking for partial_outputs get the stages of job_output on the polls before
+    the one reporting them completed. ci_vec_overlap jobs with inline CI vectors get
+    their overlaps, those of every pair of a batch with batch_overlaps.
+    The first malformed_outputs JobOutputs are sent as bytes that do not parse.
+    """
+
+    def __init__(
+        self,
+        job_output,
+        working_polls=1,
+        busy_replies=0,
+        compression=pb.Status.NO_COMPRESSION,
+        queue_jobs=False,
+        shared_memory=False,
+        batch_overlaps=False,
+        malformed_outputs=0,
+    ):
+        self.job_output = job_output
+        self.malformed_outputs = malformed_outputs
+        self.shared_memory = shared_memory
+        self.batch_overlaps = batch_overlaps
+        self.working_polls = working_polls
+        self.busy_replies = busy_replies
+        self.compression = compression
+        self.queue_jobs = queue_jobs
+        self.job_inputs = []
+        self._conns = []
+        self._sock = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+        self._sock.bind(("127.0.0.1", 0))
+        self._sock.listen(8)
+        self.address = self._sock.getsockname()
+        threading.Thread(target=self._serve, daemon=True).start()
+
+    def close(self):
+        self._sock.close()
+
+    def drop_connections(self):
+        """Close the open client connections, as if the server had died"""
+        for conn in self._conns:
+            try:
+                conn.shutdown(socket.SHUT_RDWR)
+            except OSError:
+                pass
+            conn.close()
+        self._conns = []
+
+    def _serve(self):
+        while True:
+            try:
+                conn, _ = self._sock.accept()
+            except OSError:
+                return
+            self._conns.append(conn)
+            threading.Thread(target=self._handle, args=(conn,), daemon=True).start()
+
+    def _recv(self, conn, nbytes):
+        data = b""
+        while len(data) < nbytes:
+            chunk = conn.recv(nbytes - len(data))
+            if not chunk:
+                raise EOFError
+            data += chunk
+        return data
+
+    def _job_output(self, job_id):
+        """JobOutput of an accepted job"""
+        job_output = pb.JobOutput()
+        job_output.CopyFrom(self.job_output)
+        job_output.server_job_id = job_id
+        job_input = self.job_inputs[job_id - 1]
+        if job_input.run == pb.JobInput.RunType.CI_VEC_OVERLAP and job_input.cvec1:
+            options = list(job_input.user_options)
+            nstates = int(options[options.index("cassinglets") + 1])
+            shape = (-1, nstates, len(job_input.cvec1) // nstates)
+            if self.batch_overlaps and job_input.overlap_pairs:
+                cvecs = np.reshape(job_input.overlap_cvecs, shape)
+                pairs = np.reshape(job_input.overlap_pairs, (-1, 2))
+            else:
+                cvecs = np.reshape(list(job_input.cvec1) + list(job_input.cvec2), shape)
+                pairs = [(0, 1)]
+            job_output.ci_overlap_size = nstates
+            del job_output.ci_overlaps[:]
+            for i, j in pairs:
+                job_output.ci_overlaps.extend((cvecs[i] @ cvecs[j].T).ravel())
+        return job_output
+
+    def _handle(self, conn):
+        # Remaining working polls of the accepted jobs by server_job_id, in the order
+        # they run
+        jobs = {}
+        # JobOutputs still to send of jobs asking for partial outputs
+        stages = {}
+        compression = pb.Status.NO_COMPRESSION
+        channel = None
+        try:
+            while True:
+                msg_type, msg_size = unpack_header(self._recv(conn, HEADER_SIZE))
+                in_shm = bool(msg_type & SHM_FLAG)
+                msg_type, compressed = split_msg_type(msg_type & ~SHM_FLAG)
+                msg_str = self._recv(conn, msg_size)
+                if in_shm:
+                    msg_str = bytes(channel.receive(msg_str))
+                    channel.release()
+                if compressed:
+                    msg_str = decompress_body(msg_str, compression)
+                msg = parse_msg(msg_type, msg_str)
+                job_output = None
+                if msg_type == pb.STATUS and msg.shared_memory:
+                    if self.shared_memory:
+                        channel = SharedMemoryChannel(
+                            msg.shared_memory_size, 0, name=msg.shared_memory
+                        )
+                    reply = pb.Status(shared_memory_accepted=channel is not None)
+                    conn.sendall(b"".join(serialize_msg(pb.STATUS, reply)))
+                    continue
+                elif msg_type == pb.STATUS and len(msg.accept_compression):
+                    # Answered uncompressed; the codec applies to later messages
+                    chosen = pb.Status.NO_COMPRESSION
+                    if self.compression in msg.accept_compression:
+                        chosen = self.compression
+                    reply = pb.Status(busy=bool(jobs), compression=chosen)
+                    conn.sendall(b"".join(serialize_msg(pb.STATUS, reply)))
+                    compression = chosen
+                    continue
+                elif msg_type == pb.JOBINPUT:
+                    if self.busy_replies > 0 or (jobs and not self.queue_jobs):
+                        self.busy_replies = max(self.busy_replies - 1, 0)
+                        reply = pb.Status(busy=True)
+                    else:
+                        self.job_inputs.append(msg)
+                        job_id = len(self.job_inputs)
+                        jobs[job_id] = self.working_polls
+                        if msg.partial_outputs:
+                            stages[job_id] = deque(
+                                split_job_output(self._job_output(job_id))
+                            )
+                        reply = pb.Status(accepted=True, server_job_id=job_id)
+                elif not jobs:
+                    reply = pb.Status(busy=False)
+                else:
+                    running = next(iter(jobs))
+                    job_id = msg.server_job_id if msg.server_job_id in jobs else running
+                    if job_id != running:
+                        reply = pb.Status(busy=True, queued=True, server_job_id=job_id)
+                    elif len(stages.get(job_id, ())) > 1:
+                        job_output = stages[job_id].popleft()
+                        reply = pb.Status(
+                            busy=True,
+                            working=True,
+                            partial_output=True,
+                            server_job_id=job_id,
+                        )
+                    elif jobs[job_id] > 0:
+                        jobs[job_id] -= 1
+                        reply = pb.Status(busy=True, working=True, server_job_id=job_id)
+                    else:
+                        del jobs[job_id]
+                        if job_id in stages:
+                            job_output = stages.pop(job_id)[0]
+                        else:
+                            job_output = self._job_output(job_id)
+                        reply = pb.Status(completed=True, server_job_id=job_id)
+                conn.sendall(b"".join(serialize_msg(pb.STATUS, reply, compression, 0)))
+                if job_output is not None and self.malformed_outputs > 0:
+                    self.malformed_outputs -= 1
+                    # Field 1 claiming 127 bytes that never come
+                    conn.sendall(b"".join(serialize_msg(pb.JOBOUTPUT, b"\x0a\x7f")))
+                elif job_output is not None:
+                    header, body = serialize_msg(
+                        pb.JOBOUTPUT, job_output, compression, 0
+                    )
+                    if channel is not None:
+                        header, body = channel.place(header, body)
+                    conn.sendall(header + body)
+        except (EOFError, OSError):
+            conn.close()
+            if channel is not None:
+                channel.close()
+
+
+@pytest.fixture
+def fake_server(job_output):
+    server = FakeTCPBServer(job_output)
+    yield server
+    server.close()
+
+
 def _round(value: Union[Collection[float], float], places: int = 6):
     """Round a value or Collection of values to a set precision"""
     if isinstance(value, (float, int)):
@@ -0,0 +1,93 @@
+import asyncio
+
+import pytest
+from qcelemental.models.results import AtomicResult
+
+from tcpb import AsyncTCProtobufClient
+from tcpb import terachem_server_pb2 as pb
+from tcpb.exceptions import TCPBError
+from tcpb.framing import HEADER_SIZE, parse_msg, serialize_msg, unpack_header
+
+
+async def _fake_server(job_output, working_polls=2, queued_polls=0):
+    """Start a server that accepts one job, reports it queued and then working a few
+    times and then returns job_output"""
+    state = {"polls": 0, "submitted": False}
+
+    async def handle(reader, writer):
+        try:
+            while True:
+                msg_type, msg_size = unpack_header(
+                    await reader.readexactly(HEADER_SIZE)
+                )
+                parse_msg(msg_type, await reader.readexactly(msg_size))
+                if msg_type == pb.JOBINPUT:
+                    state["submitted"] = True
+                    reply = pb.Status(accepted=True, job_dir="/tmp", server_job_id=1)
+                elif not state["submitted"]:
+                    reply = pb.Status(busy=False)
+                elif state["polls"] < queued_polls:
+                    state["polls"] += 1
+                    reply = pb.Status(busy=True, queued=True)
+                elif state["polls"] < queued_polls + working_polls:
+                    state["polls"] += 1
+                    reply = pb.Status(busy=True, working=True)
+                else:
+                    reply = pb.Status(completed=True)
+                writer.write(b"".join(serialize_msg(pb.STATUS, reply)))
+                if reply.completed:
+                    writer.write(b"".join(serialize_msg(pb.JOBOUTPUT, job_output)))
+                    state["submitted"] = False
+                await writer.drain()
+        except asyncio.IncompleteReadError:
+            writer.close()
+
+    server = await asyncio.start_server(handle, "127.0.0.1", 0)
+    return server, server.sockets[0].getsockname()[1], state
+
+
+def test_async_is_available(job_output):
+    async def run():
+        server, port, _ = await _fake_server(job_output)
+        async with server:
+            async with AsyncTCProtobufClient("127.0.0.1", port) as TC:
+                return await TC.is_available()
+
+    assert asyncio.run(run()) is True
+
+
+def test_async_compute(atomic_input, job_output):
+    async def run():
+        server, port, state = await _fake_server(job_output)
+        async with server:
+            async with AsyncTCProtobufClient("127.0.0.1", port) as TC:
+                result = await TC.compute(atomic_input)
+                return result, state, TC.curr_job_id
+
+    result, state, curr_job_id = asyncio.run(run())
+    assert isinstance(result, AtomicResult)
+    assert result.return_result == job_output.energy[0]
+    assert state["polls"] == 2
+    assert curr_job_id is None
+
+
+def test_async_compute_waits_for_queued_job(atomic_input, job_output):
+    async def run():
+        server, port, state = await _fake_server(
+            job_output, working_polls=1, queued_polls=2
+        )
+        async with server:
+            async with AsyncTCProtobufClient("127.0.0.1", port) as TC:
+                return await TC.compute(atomic_input), state
+
+    result, state = asyncio.run(run())
+    assert result.return_result == job_output.energy[0]
+    assert state["polls"] == 3
+
+
+def test_async_calls_before_connect(atomic_input):
+    client = AsyncTCProtobufClient("127.0.0.1", 11111)
+    with pytest.raises(TCPBError):
+        asyncio.run(client.is_available())
+    with pytest.raises(TCPBError):
+        asyncio.run(client.compute(atomic_input))
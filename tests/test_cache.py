@@ -0,0 +1,55 @@
+from tcpb import TCProtobufClient
+from tcpb import terachem_server_pb2 as pb
+from tcpb.cache import ResultCache
+from tcpb.utils import atomic_input_to_job_input
+
+
+def _job_input(xyz, **options):
+    job_input = pb.JobInput(mol=pb.Mol(atoms=["H", "H"], xyz=xyz), basis="sto-3g")
+    for key, value in options.items():
+        job_input.user_options.extend([key, str(value)])
+    return job_input
+
+
+def test_result_cache_key_ignores_user_option_order(tmp_path):
+    cache = ResultCache(tmp_path)
+
+    first = _job_input([0, 0, 0, 0, 0, 1.4], convthre=1e-8, maxit=100)
+    second = _job_input([0, 0, 0, 0, 0, 1.4], maxit=100, convthre=1e-8)
+    assert cache.key(first) == cache.key(second)
+    assert cache.key(first) != cache.key(_job_input([0, 0, 0, 0, 0, 1.4]))
+
+
+def test_result_cache_geometry_decimals(tmp_path):
+    exact = ResultCache(tmp_path)
+    rounded = ResultCache(tmp_path, geometry_decimals=6)
+
+    first = _job_input([0, 0, 0, 0, 0, 1.4])
+    second = _job_input([0, 0, -1e-9, 0, 0, 1.4 + 1e-9])
+    assert exact.key(first) != exact.key(second)
+    assert rounded.key(first) == rounded.key(second)
+
+
+def test_result_cache_roundtrip(tmp_path, atomic_input, job_output):
+    cache = ResultCache(tmp_path / "cache")
+    job_input = atomic_input_to_job_input(atomic_input)
+
+    assert cache.get(job_input) is None
+    cache.put(job_input, job_output)
+    assert cache.get(job_input) == job_output
+    assert len(cache) == 1
+    assert (cache.hits, cache.misses) == (1, 1)
+
+    cache.clear()
+    assert len(cache) == 0
+    assert cache.get(job_input) is None
+
+
+def test_client_compute_uses_result_cache(tmp_path, atomic_input, fake_server):
+    with TCProtobufClient(*fake_server.address, result_cache=tmp_path) as client:
+        first = client.compute(atomic_input.copy(deep=True))
+        second = client.compute(atomic_input.copy(deep=True))
+
+    assert len(fake_server.job_inputs) == 1
+    assert second.return_result == first.return_result
+    assert (client.result_cache.hits, client.result_cache.misses) == (1, 1)
@@ -1,6 +1,9 @@
 import os
 
+import numpy as np
+
 from tcpb import TCProtobufClient as TCPBClient
+from tcpb import terachem_server_pb2 as pb
 
 from .answers import ci_overlap
 from .conftest import _round
@@ -96,3 +99,33 @@ def test_ci_overlap(settings, ethylene):
         ]
         for field in fields_to_check:
             assert _round(results[field]) == _round(ci_overlap.correct_answer[field])
+
+
+def test_ci_overlap_inline_arrays_match_file_layout():
+    orbs = np.arange(6, dtype=np.float64).reshape(2, 3)
+    cvec = np.arange(4, dtype=np.float64).reshape(2, 2)
+    options = {
+        "atoms": ["H", "H"],
+        "charge": 0,
+        "spinmult": 1,
+        "closed_shell": True,
+        "restricted": True,
+        "method": "hf",
+        "basis": "sto-3g",
+    }
+
+    job_input = pb.JobInput()
+    TCPBClient._process_kwargs(
+        job_input, cvec1=cvec, cvec2=cvec, orb1a=orbs, orb2a=orbs, **options
+    )
+
+    # CI vectors are row-major, orbitals column-major like TeraChem c0 files
+    assert list(job_input.cvec1) == [0.0, 1.0, 2.0, 3.0]
+    assert list(job_input.cvec2) == list(job_input.cvec1)
+    assert list(job_input.orb1a) == [0.0, 3.0, 1.0, 4.0, 2.0, 5.0]
+    assert list(job_input.orb2a) == list(job_input.orb1a)
+    assert not job_input.orb1b
+    assert "cvec1" not in job_input.user_options
+
+    TCPBClient._process_kwargs(job_input, cvec1=None, **options)
+    assert not job_input.cvec1
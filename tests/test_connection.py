@@ -0,0 +1,84 @@
+import socket
+import time
+from types import SimpleNamespace
+
+import pytest
+
+from tcpb import TCProtobufClient
+from tcpb import tcpb as tcpb_module
+from tcpb.exceptions import ServerError
+
+from .conftest import FakeTCPBServer
+
+
+def test_server_error_reads_logfile_lazily(tmp_path):
+    client = SimpleNamespace(
+        tcaddr=("localhost", 11111), curr_job_dir=str(tmp_path), curr_job_id=3
+    )
+    error = ServerError("Could not recv header", client)
+    # Written after the error was raised; only read when it is printed
+    lines = ["line {:02d}\n".format(i) for i in range(12)]
+    (tmp_path / "3.log").write_text("".join(lines))
+
+    message = str(error)
+    assert error.logfile == "{}/3.log".format(tmp_path)
+    assert "line 11" in message and "line 02" in message
+    assert "line 01" not in message
+
+
+def test_server_error_without_job(fake_server):
+    client = TCProtobufClient(*fake_server.address)
+    error = ServerError("Problem connecting to server", client)
+    assert error.logfile_tail() is None
+    assert str(error).endswith("Could not open logfile")
+
+
+def test_connect_retries_with_backoff(monkeypatch):
+    attempts = []
+    delays = []
+
+    def refuse(address, timeout):
+        attempts.append(timeout)
+        raise ConnectionRefusedError("Connection refused")
+
+    monkeypatch.setattr(tcpb_module.socket, "create_connection", refuse)
+    monkeypatch.setattr(tcpb_module, "sleep", delays.append)
+    client = TCProtobufClient(
+        "localhost",
+        11111,
+        connect_timeout=0.5,
+        reconnect_attempts=2,
+        reconnect_interval=0.2,
+    )
+    with pytest.raises(ServerError):
+        client.connect()
+
+    assert attempts == [0.5] * 3
+    assert len(delays) == 2
+    assert 0.0 <= delays[0] <= 0.2 and 0.0 <= delays[1] <= 0.4
+
+
+def test_reconnect_before_job_after_connection_loss(atomic_input, job_output):
+    server = FakeTCPBServer(job_output)
+    try:
+        with TCProtobufClient(
+            *server.address, read_timeout=5.0, keepalive=10, reconnect_attempts=1
+        ) as client:
+            assert client.is_alive()
+            client.compute(atomic_input)
+
+            server.drop_connections()
+            deadline = time.monotonic() + 5.0
+            while client.is_alive() and time.monotonic() < deadline:
+                time.sleep(0.01)
+            assert not client.is_alive()
+
+            result = client.compute(atomic_input)
+            assert client.is_alive()
+            assert client.tcsock.gettimeout() == 5.0
+            assert client.tcsock.getsockopt(socket.SOL_SOCKET, socket.SO_KEEPALIVE)
+    finally:
+        server.close()
+
+    assert result.success
+    assert len(server.job_inputs) == 2
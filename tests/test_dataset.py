@@ -0,0 +1,69 @@
+import numpy as np
+import pytest
+
+from tcpb import terachem_server_pb2 as pb
+from tcpb.dataset import ResultDataset, ResultSink
+from tcpb.pool import TCPBPool
+
+from .conftest import FakeTCPBServer
+
+
+def _job_output(natoms):
+    job_output = pb.JobOutput()
+    job_output.energy.append(-float(natoms))
+    job_output.gradient.extend(np.arange(3 * natoms, dtype=float))
+    return job_output
+
+
+def test_sink_writes_ragged_rows_in_chunks(tmp_path):
+    natoms = [1, 3, 2, 0, 4]
+    with ResultSink(tmp_path, fields=("energy", "gradient"), chunk_rows=2) as sink:
+        for key, n in enumerate(natoms):
+            sink.append(_job_output(n), key=10 + key)
+        assert len(sink) == 5
+
+    dataset = ResultDataset(tmp_path)
+    assert len(dataset) == 5
+    assert dataset.chunk_rows == [2, 2, 1]
+    assert list(dataset.keys()) == [10, 11, 12, 13, 14]
+    for index, n in enumerate(natoms):
+        assert np.array_equal(dataset.row("gradient", index), np.arange(3 * n))
+    assert isinstance(next(dataset.chunks("gradient"))[0], np.memmap)
+    assert np.array_equal(dataset.stack("energy")[:, 0], -np.array(natoms, float))
+    with pytest.raises(ValueError):
+        dataset.stack("gradient")
+    with pytest.raises(IndexError):
+        dataset.row("energy", 5)
+
+
+def test_sink_appends_to_existing_dataset(tmp_path):
+    with ResultSink(tmp_path, fields=("energy",)) as sink:
+        sink.append(_job_output(1))
+    with ResultSink(tmp_path) as sink:
+        assert sink.fields == ["energy"]
+        sink.append(_job_output(2))
+
+    dataset = ResultDataset(tmp_path)
+    assert list(dataset.keys()) == [0, 1]
+    assert np.array_equal(dataset.stack("energy"), [[-1.0], [-2.0]])
+
+
+def test_sink_rejects_non_array_fields(tmp_path):
+    with pytest.raises(ValueError):
+        ResultSink(tmp_path, fields=("energy", "orb1afile"))
+
+
+def test_sink_collects_pool_jobs(tmp_path, atomic_input, job_output):
+    server = FakeTCPBServer(job_output)
+    with TCPBPool([server.address]) as pool, ResultSink(tmp_path) as sink:
+        futures = [sink.submit(pool, atomic_input, key=key) for key in range(3)]
+        for future in futures:
+            future.result(timeout=30)
+    assert not sink.errors
+    assert len(sink) == 3
+
+    dataset = ResultDataset(tmp_path)
+    assert sorted(dataset.keys()) == [0, 1, 2]
+    for name in ("energy", "gradient"):
+        expected = np.asarray(getattr(job_output, name))
+        assert np.allclose(dataset.stack(name), np.tile(expected, (3, 1)))
@@ -0,0 +1,73 @@
+import pytest
+
+from tcpb import TCProtobufClient
+from tcpb import terachem_server_pb2 as pb
+from tcpb.framing import (
+    COMPRESSED_FLAG,
+    decompress_body,
+    parse_msg,
+    serialize_msg,
+    split_msg_type,
+    supported_compression,
+    unpack_header,
+)
+
+from .conftest import FakeTCPBServer
+
+
+def test_small_messages_are_not_compressed():
+    header, msg_str = serialize_msg(
+        pb.STATUS, pb.Status(busy=True), compression=pb.Status.ZLIB
+    )
+    msg_type, msg_size = unpack_header(header)
+
+    assert msg_type == pb.STATUS
+    assert msg_size == len(msg_str)
+    assert parse_msg(pb.STATUS, msg_str).busy
+
+
+def test_large_messages_are_compressed(job_output):
+    header, msg_str = serialize_msg(
+        pb.JOBOUTPUT, job_output, compression=pb.Status.ZLIB, threshold=0
+    )
+    msg_type, msg_size = unpack_header(header)
+
+    assert msg_type & COMPRESSED_FLAG
+    assert split_msg_type(msg_type) == (pb.JOBOUTPUT, True)
+    assert msg_size == len(msg_str) < job_output.ByteSize()
+    body = decompress_body(msg_str, pb.Status.ZLIB)
+    assert parse_msg(pb.JOBOUTPUT, body) == job_output
+
+
+def test_compressed_body_needs_negotiated_codec():
+    with pytest.raises(ValueError):
+        decompress_body(b"", pb.Status.NO_COMPRESSION)
+
+
+def test_supported_compression():
+    assert pb.Status.ZLIB in supported_compression()
+    assert supported_compression(["zlib"]) == [pb.Status.ZLIB]
+
+
+def test_client_negotiates_compression(atomic_input, job_output):
+    server = FakeTCPBServer(job_output, compression=pb.Status.ZLIB)
+    try:
+        with TCProtobufClient(*server.address, compression=["zlib"]) as client:
+            assert client.wire_compression == pb.Status.ZLIB
+            result = client.compute(atomic_input)
+    finally:
+        server.close()
+
+    assert result.return_result == job_output.energy[0]
+
+
+def test_client_falls_back_to_uncompressed(atomic_input, job_output):
+    server = FakeTCPBServer(job_output)
+    try:
+        with TCProtobufClient(*server.address, compression=True) as client:
+            assert client.wire_compression == pb.Status.NO_COMPRESSION
+            result = client.compute(atomic_input)
+    finally:
+        server.close()
+
+    assert result.return_result == job_output.energy[0]
@@ -0,0 +1,89 @@
+from tcpb import TCProtobufClient
+from tcpb import terachem_server_pb2 as pb
+from tcpb.guess import GuessCache
+from tcpb.molden_constructor import BOHR2ANGSTROM
+
+
+def _job_input(xyz, units=pb.Mol.UnitType.BOHR, closed=True, **options):
+    job_input = pb.JobInput(
+        mol=pb.Mol(
+            atoms=["H", "H"],
+            xyz=xyz,
+            units=units,
+            multiplicity=1,
+            closed=closed,
+            restricted=closed,
+        ),
+        method=pb.JobInput.MethodType.PBE0,
+        basis="6-31g",
+    )
+    for key, value in options.items():
+        job_input.user_options.extend([key, value])
+    return job_input
+
+
+def _job_output(scr_dir, closed=True):
+    job_output = pb.JobOutput()
+    if closed:
+        job_output.orb1afile = scr_dir + "/c0"
+    else:
+        job_output.orb1afile = scr_dir + "/ca0"
+        job_output.orb1bfile = scr_dir + "/cb0"
+    return job_output
+
+
+def test_guess_cache_uses_nearest_geometry():
+    cache = GuessCache()
+    cache.record(_job_input([0, 0, 0, 0, 0, 1.4]), _job_output("scr.1"))
+    cache.record(_job_input([0, 0, 0, 0, 0, 2.0]), _job_output("scr.2"))
+
+    guessed = cache.apply(_job_input([0, 0, 0, 0, 0, 1.9]))
+    assert list(guessed.user_options) == ["guess", "scr.2/c0"]
+    assert cache.hits == 1
+
+
+def test_guess_cache_compares_geometries_in_bohr():
+    cache = GuessCache(max_distance=1e-6)
+    cache.record(_job_input([0, 0, 0, 0, 0, 1.4]), _job_output("scr.1"))
+
+    angstrom = _job_input(
+        [0, 0, 0, 0, 0, 1.4 * BOHR2ANGSTROM], units=pb.Mol.UnitType.ANGSTROM
+    )
+    assert cache.lookup(angstrom) == "scr.1/c0"
+
+
+def test_guess_cache_respects_system_and_existing_guess():
+    cache = GuessCache(max_distance=0.5)
+    cache.record(_job_input([0, 0, 0, 0, 0, 1.4]), _job_output("scr.1"))
+
+    # Different spin state, too far away, or guess already given by the user
+    assert cache.lookup(_job_input([0, 0, 0, 0, 0, 1.4], closed=False)) is None
+    assert cache.lookup(_job_input([0, 0, 0, 0, 0, 3.0])) is None
+    job_input = _job_input([0, 0, 0, 0, 0, 1.4], guess="mine/c0")
+    assert cache.apply(job_input) is job_input
+    assert cache.misses == 2
+
+
+def test_guess_cache_unrestricted_guess_has_both_files():
+    cache = GuessCache()
+    cache.record(
+        _job_input([0, 0, 0, 0, 0, 1.4], closed=False),
+        _job_output("scr.1", closed=False),
+    )
+
+    job_input = _job_input([0, 0, 0, 0, 0, 1.4], closed=False)
+    assert cache.lookup(job_input) == "scr.1/ca0 scr.1/cb0"
+    # The original message is left untouched
+    cache.apply(job_input)
+    assert not job_input.user_options
+
+
+def test_client_compute_injects_cached_guess(atomic_input, job_output, fake_server):
+    with TCProtobufClient(*fake_server.address, guess_cache=True) as client:
+        client.compute(atomic_input.copy(deep=True))
+        client.compute(atomic_input.copy(deep=True))
+
+    first, second = fake_server.job_inputs
+    assert "guess" not in first.user_options
+    guess_index = list(second.user_options).index("guess")
+    assert second.user_options[guess_index + 1] == job_output.orb1afile
@@ -0,0 +1,75 @@
+import numpy as np
+
+from tcpb import terachem_server_pb2 as pb
+from tcpb.hessian import (
+    displaced_geometries,
+    finite_difference_hessian,
+    harmonic_frequencies,
+)
+from tcpb.pool import TCPBPool
+
+from .conftest import FakeTCPBServer
+
+
+def test_finite_difference_hessian_of_quadratic_energy():
+    rng = np.random.default_rng(7)
+    a = rng.normal(size=(6, 6))
+    force_constants = a @ a.T
+    geometry = rng.normal(size=(2, 3))
+
+    geometries = displaced_geometries(geometry, step=0.01)
+    assert geometries.shape == (6, 2, 2, 3)
+    gradients = (geometries.reshape(12, 6) @ force_constants).reshape(6, 2, 2, 3)
+
+    hessian = finite_difference_hessian(gradients, step=0.01)
+    assert np.allclose(hessian, force_constants)
+
+
+def test_harmonic_frequencies_in_wavenumbers():
+    frequencies = harmonic_frequencies(np.diag([-1.0, 1.0, 4.0]), [1.0])
+    assert np.allclose(frequencies, [-5140.48, 5140.48, 2 * 5140.48], rtol=1e-4)
+
+
+def _water_hessian_input(atomic_input, job_output):
+    del job_output.gradient[:]
+    job_output.gradient.extend(np.linspace(-0.1, 0.1, 9))
+    return atomic_input.copy(update={"driver": "hessian"}, deep=True)
+
+
+def test_pool_hessian_from_displaced_gradients(atomic_input, job_output):
+    atomic_input = _water_hessian_input(atomic_input, job_output)
+    servers = [FakeTCPBServer(job_output) for _ in range(2)]
+    with TCPBPool([server.address for server in servers]) as pool:
+        result = pool.submit(atomic_input).result(timeout=60)
+
+    job_inputs = [job_input for server in servers for job_input in server.job_inputs]
+    assert len(job_inputs) == 1 + 18
+    assert {job_input.run for job_input in job_inputs} == {pb.JobInput.RunType.GRADIENT}
+    assert [job_input.imd_type for job_input in job_inputs].count(
+        pb.JobInput.ImdType.IMD_HESSIAN
+    ) == 1
+    # Displaced gradients start from the orbitals of the reference
+    guesses = [
+        job_input.user_options[list(job_input.user_options).index("guess") + 1]
+        for job_input in job_inputs
+        if "guess" in job_input.user_options
+    ]
+    assert guesses == [job_output.orb1afile] * 18
+
+    assert result.driver == "hessian"
+    assert result.extras["hessian"]["source"] == "finite_difference"
+    assert len(result.extras["hessian"]["frequencies"]) == 9
+    # Every server returns the same gradient
+    assert np.allclose(result.return_result, np.zeros((9, 9)))
+
+
+def test_pool_hessian_uses_server_hessian(atomic_input, job_output):
+    atomic_input = _water_hessian_input(atomic_input, job_output)
+    job_output.compressed_hessian.extend(np.eye(9).ravel())
+    server = FakeTCPBServer(job_output)
+    with TCPBPool([server.address]) as pool:
+        result = pool.submit_hessian(atomic_input).result(timeout=30)
+
+    assert len(server.job_inputs) == 1
+    assert result.extras["hessian"]["source"] == "server"
+    assert np.array_equal(result.return_result, np.eye(9))
@@ -0,0 +1,44 @@
+import numpy as np
+
+from tcpb import TCProtobufClient
+from tcpb import terachem_server_pb2 as pb
+
+from .conftest import FakeTCPBServer
+
+
+def test_imd_stream_continues_from_previous_frame(atomic_input, job_output):
+    job_output.gradient.extend(np.linspace(-0.1, 0.1, 9))
+    job_output.imd_mmatom_gradient.extend([0.5, 0.25, 0.125] * 2)
+    job_output.compressed_mo_vector.extend([0.5, -0.5, 0.25, 0.75])
+    server = FakeTCPBServer(job_output)
+    mm_positions = np.array([[5.0, 0.0, 0.0], [0.0, 5.0, 0.0]])
+    try:
+        with TCProtobufClient(*server.address) as client:
+            stream = client.imd_stream(atomic_input)
+            frames = list(
+                stream.stream(
+                    [
+                        (np.full(9, 1.0), mm_positions, [-0.8, 0.4]),
+                        (np.full(9, 1.1), mm_positions, [-0.8, 0.4]),
+                    ]
+                )
+            )
+    finally:
+        server.close()
+
+    assert frames[1].gradient.shape == (3, 3)
+    assert frames[1].mm_gradient.tolist() == [[0.5, 0.25, 0.125]] * 2
+    assert list(stream.history) == frames
+
+    first, second = server.job_inputs
+    assert first.imd_type == pb.JobInput.ImdType.IMD_NEW_CONDITION
+    assert first.run == pb.JobInput.RunType.GRADIENT
+    assert first.imd_orbital_type == pb.JobInput.ImdOrbitalType.WHOLE_C
+    assert list(first.imd_mmatom_position) == mm_positions.ravel().tolist()
+    assert np.allclose(first.imd_mmatom_info, [-0.8, 0.4])
+    assert not len(first.imd_mo_previous)
+
+    assert second.imd_type == pb.JobInput.ImdType.IMD_CONTINUE
+    assert list(second.mol.xyz) == [1.1] * 9
+    assert list(second.imd_xyz_previous) == [1.0] * 9
+    assert list(second.imd_mo_previous) == [0.5, -0.5, 0.25, 0.75]
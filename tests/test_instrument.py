@@ -0,0 +1,78 @@
+from tcpb import TCProtobufClient
+from tcpb.framing import HEADER_SIZE
+from tcpb.instrument import RECEIVED, SENT, JobHooks
+from tcpb.utils import atomic_input_to_job_input
+
+from .conftest import FakeTCPBServer
+
+
+class _RecordingHooks(JobHooks):
+    def __init__(self):
+        self.messages = []
+        self.phases = []
+        self.jobs = []
+
+    def on_message(self, direction, msg_type, nbytes):
+        self.messages.append((direction, msg_type, nbytes))
+
+    def on_phase(self, phase, seconds):
+        self.phases.append(phase)
+
+    def on_job(self, timings):
+        self.jobs.append(timings)
+
+
+def test_compute_records_timings(atomic_input, job_output):
+    hooks = _RecordingHooks()
+    server = FakeTCPBServer(job_output, working_polls=2, busy_replies=1)
+    try:
+        with TCProtobufClient(*server.address, hooks=[hooks]) as client:
+            result = client.compute(atomic_input)
+    finally:
+        server.close()
+
+    timings = result.extras["timings"]
+    assert list(timings["phases"]) == ["input", "queue", "compute", "receive", "output"]
+    assert timings["total"] >= sum(timings["phases"].values())
+    assert timings["polls"] == 3
+    assert not timings["cached"]
+    assert (
+        timings["bytes_received"]["JOBOUTPUT"] == HEADER_SIZE + job_output.ByteSize()
+    )
+    assert set(timings["bytes_sent"]) == {"JOBINPUT", "STATUS"}
+
+    assert hooks.phases == list(timings["phases"])
+    assert hooks.jobs == [client.last_job_timings]
+    # Two JobInputs (one rejected) and three polls, each answered by a Status
+    assert [m[:2] for m in hooks.messages].count((SENT, "JOBINPUT")) == 2
+    assert [m[:2] for m in hooks.messages].count((RECEIVED, "STATUS")) == 5
+    assert hooks.messages[-1] == (
+        RECEIVED,
+        "JOBOUTPUT",
+        HEADER_SIZE + job_output.ByteSize(),
+    )
+
+
+def test_failing_hook_does_not_interrupt_job(atomic_input, fake_server):
+    class FailingHooks(JobHooks):
+        def on_phase(self, phase, seconds):
+            raise RuntimeError("exporter down")
+
+    with TCProtobufClient(*fake_server.address, hooks=[FailingHooks()]) as client:
+        result = client.compute(atomic_input)
+
+    assert result.success
+    assert "compute" in result.extras["timings"]["phases"]
+
+
+def test_recv_job_async_reports_timings(atomic_input, fake_server):
+    with TCProtobufClient(*fake_server.address) as client:
+        assert client.send_job_input_async(atomic_input_to_job_input(atomic_input))
+        while not client.check_job_complete():
+            pass
+        results = client.recv_job_async()
+
+    phases = list(results["timings"]["phases"])
+    assert phases == ["queue", "compute", "receive", "output"]
+    assert results["timings"] == client.last_job_timings.to_dict()
+    assert client.job_timings is None
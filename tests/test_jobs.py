@@ -0,0 +1,56 @@
+import pytest
+
+from tcpb import TCProtobufClient
+from tcpb.exceptions import TCPBError
+from tcpb.jobs import COMPLETED, PENDING, QUEUED, WORKING
+
+from .conftest import FakeTCPBServer
+
+
+def test_queueing_server_accepts_all_jobs(atomic_input, job_output):
+    server = FakeTCPBServer(job_output, queue_jobs=True)
+    try:
+        with TCProtobufClient(*server.address) as client:
+            handles = [client.submit_job(atomic_input) for _ in range(3)]
+            assert len(server.job_inputs) == 3
+            assert [h.state for h in handles] == [QUEUED] * 3
+
+            # Only the first job runs; the others wait behind it
+            assert client.poll_job(handles[1]) == QUEUED
+            assert client.poll_job(handles[0]) == WORKING
+
+            completed = list(client.as_completed())
+    finally:
+        server.close()
+
+    assert completed == handles
+    for handle in handles:
+        assert handle.job_output.server_job_id == handle.server_job_id
+        result = handle.result()
+        assert result.return_result == job_output.energy[0]
+        assert result.extras["timings"]["polls"] >= 1
+
+
+def test_single_job_server_gets_jobs_one_at_a_time(atomic_input, job_output):
+    server = FakeTCPBServer(job_output)
+    try:
+        with TCProtobufClient(*server.address) as client:
+            handles = [client.submit_job(atomic_input) for _ in range(3)]
+            assert len(server.job_inputs) == 1
+            assert [h.state for h in handles] == [QUEUED, PENDING, PENDING]
+
+            outputs = [client.collect(handle) for handle in reversed(handles)]
+    finally:
+        server.close()
+
+    assert len(server.job_inputs) == 3
+    assert [output.server_job_id for output in outputs] == [3, 2, 1]
+    assert all(handle.state == COMPLETED for handle in handles)
+
+
+def test_result_of_unfinished_job(atomic_input, fake_server):
+    with TCProtobufClient(*fake_server.address) as client:
+        handle = client.submit_job(atomic_input)
+        with pytest.raises(TCPBError):
+            handle.result()
+        client.collect(handle)
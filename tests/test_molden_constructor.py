@@ -0,0 +1,64 @@
+import io
+
+from tcpb import terachem_server_pb2 as pb
+from tcpb.molden_constructor import (
+    tcpb_imd_fields2molden_stream,
+    tcpb_imd_fields2molden_string,
+)
+
+
+def _h2_job_output():
+    """H2 in a minimal basis: one s shell with 2 primitives per atom"""
+    job_output = pb.JobOutput()
+    job_output.mol.atoms.extend(["H", "H"])
+    job_output.mol.xyz.extend([0.0, 0.0, 0.0, 0.0, 0.0, 1.4])
+    job_output.mol.restricted = True
+    # (shell type, number of primitives, atom index) per AO
+    job_output.compressed_ao_data.extend([1, 2, 0, 1, 2, 1])
+    job_output.compressed_primitive_data.extend(
+        [3.42525, 0.15433, 0.62391, 0.53533] * 2
+    )
+    job_output.compressed_mo_vector.extend([0.5, 0.5, 0.75, -0.75])
+    job_output.orba_energies.extend([-0.5, 0.25])
+    job_output.orba_occupations.extend([2.0, 0.0])
+    return job_output
+
+
+def test_molden_string_sections():
+    molden = tcpb_imd_fields2molden_string(_h2_job_output())
+    lines = molden.splitlines()
+
+    assert lines[:4] == [
+        "[Molden Format]",
+        "[Title]",
+        "Written by TeraChem",
+        "[Atoms] Angs",
+    ]
+    assert lines[4] == "H   1   1    0.00000    0.00000    0.00000"
+    assert lines[5] == "H   2   1    0.00000    0.00000    0.74085"
+    assert lines[7:10] == [
+        "    1 0",
+        " s    2 1.00",
+        "          3.425250          0.154330",
+    ]
+    mo_start = lines.index("[MO]")
+    assert lines[mo_start + 1 :] == [
+        " Ene=    -0.5000",
+        " Spin= Alpha",
+        " Occup= 2.0",
+        "    1    0.50000",
+        "    2    0.50000",
+        " Ene=     0.2500",
+        " Spin= Alpha",
+        " Occup= 0.0",
+        "    1    0.75000",
+        "    2   -0.75000",
+    ]
+
+
+def test_molden_stream_matches_string():
+    job_output = _h2_job_output()
+    stream = io.StringIO()
+
+    assert tcpb_imd_fields2molden_stream(job_output, stream) is True
+    assert stream.getvalue() == tcpb_imd_fields2molden_string(job_output)
@@ -0,0 +1,109 @@
+import numpy as np
+
+from tcpb import TCProtobufClient as TCPBClient
+from tcpb.overlap import CIOverlapBatch, overlap_pairs
+from tcpb.pool import TCPBPool
+
+from .conftest import FakeTCPBServer
+
+OPTIONS = {
+    "atoms": ["H", "H"],
+    "charge": 0,
+    "spinmult": 1,
+    "closed_shell": True,
+    "restricted": True,
+    "method": "hf",
+    "basis": "sto-3g",
+    "casci": "yes",
+    "cassinglets": 3,
+}
+
+
+def _frames(nframes):
+    rng = np.random.default_rng(11)
+    geom = np.array([0.0, 0.0, 0.0, 0.0, 0.0, 1.4])
+    geoms = [geom + 0.01 * k for k in range(nframes)]
+    cvecs = [rng.normal(size=(3, 4)) for _ in range(nframes)]
+    orbs = [rng.normal(size=(2, 2)) for _ in range(nframes)]
+    return geoms, cvecs, orbs
+
+
+def _expected(cvecs, pairs):
+    return np.stack([cvecs[i] @ cvecs[j].T for i, j in pairs])
+
+
+def test_overlap_pairs():
+    assert overlap_pairs(4, window=2) == [(0, 1), (0, 2), (1, 2), (1, 3), (2, 3)]
+    assert len(overlap_pairs(5)) == 10
+
+
+def test_batch_job_input_sends_each_frame_once():
+    geoms, cvecs, orbs = _frames(5)
+    template = TCPBClient.job_template("ci_vec_overlap", **OPTIONS)
+    batch = CIOverlapBatch(template, geoms, cvecs, orbs)
+
+    job_input = batch.job_input([(1, 3), (3, 4)])
+    assert list(job_input.overlap_pairs) == [0, 1, 1, 2]
+    assert np.array_equal(
+        np.reshape(job_input.overlap_cvecs, (3, 3, 4)),
+        np.stack([cvecs[1], cvecs[3], cvecs[4]]),
+    )
+    assert np.array_equal(job_input.mol.xyz, geoms[1])
+    assert np.array_equal(job_input.xyz2, geoms[3])
+
+    # A single pair is a plain ci_vec_overlap job
+    assert batch.job_input([(0, 1)]) == TCPBClient._create_job_input_msg(
+        "ci_vec_overlap",
+        geoms[0],
+        geom2=geoms[1],
+        cvec1=cvecs[0],
+        cvec2=cvecs[1],
+        orb1a=orbs[0],
+        orb2a=orbs[1],
+        **OPTIONS,
+    )
+
+
+def test_compute_ci_overlaps_in_one_job(job_output):
+    geoms, cvecs, orbs = _frames(5)
+    server = FakeTCPBServer(job_output, batch_overlaps=True)
+    try:
+        with TCPBClient(*server.address) as client:
+            overlaps = client.compute_ci_overlaps(
+                geoms, cvecs, orbs, window=2, **OPTIONS
+            )
+    finally:
+        server.close()
+
+    pairs = overlap_pairs(5, window=2)
+    assert len(server.job_inputs) == 1
+    assert np.allclose(overlaps, _expected(cvecs, pairs))
+
+
+def test_compute_ci_overlaps_without_batch_support(job_output):
+    geoms, cvecs, orbs = _frames(4)
+    pairs = [(0, 3), (1, 3), (2, 3)]
+    server = FakeTCPBServer(job_output)
+    try:
+        with TCPBClient(*server.address) as client:
+            overlaps = client.compute_ci_overlaps(
+                geoms, cvecs, orbs, pairs=pairs, **OPTIONS
+            )
+    finally:
+        server.close()
+
+    assert len(server.job_inputs) == len(pairs)
+    assert np.allclose(overlaps, _expected(cvecs, pairs))
+
+
+def test_pool_ci_overlaps(job_output):
+    geoms, cvecs, orbs = _frames(6)
+    # One server computes whole batches, the other one pair per job
+    servers = [
+        FakeTCPBServer(job_output, batch_overlaps=True),
+        FakeTCPBServer(job_output),
+    ]
+    with TCPBPool([server.address for server in servers]) as pool:
+        overlaps = pool.submit_ci_overlaps(geoms, cvecs, orbs, **OPTIONS).result(60)
+
+    assert np.allclose(overlaps, _expected(cvecs, overlap_pairs(6)))
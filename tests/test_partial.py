@@ -0,0 +1,111 @@
+import threading
+
+import numpy as np
+
+from tcpb import TCProtobufClient
+from tcpb import terachem_server_pb2 as pb
+from tcpb.partial import (
+    ENERGIES,
+    FINAL,
+    GRADIENTS,
+    STAGE_FIELDS,
+    merge_job_output,
+    set_fields,
+    split_job_output,
+)
+from tcpb.utils import atomic_input_to_job_input
+
+from .conftest import FakeTCPBServer
+
+
+def _with_gradient(job_output):
+    del job_output.gradient[:]
+    job_output.gradient.extend(np.linspace(-0.1, 0.1, 9))
+    return job_output
+
+
+def test_split_job_output_merges_back(job_output):
+    job_output = _with_gradient(job_output)
+    frames = split_job_output(job_output)
+    assert [frame.stage for frame in frames] == [ENERGIES, GRADIENTS, FINAL]
+    assert set_fields(frames[0]) - {"stage"} <= set(STAGE_FIELDS[ENERGIES])
+    assert "energy" not in set_fields(frames[-1])
+
+    merged = None
+    for frame in frames:
+        merged = merge_job_output(merged, frame)
+    assert merged == job_output
+
+
+def test_compute_partial_streams_stages(atomic_input, job_output):
+    job_output = _with_gradient(job_output)
+    server = FakeTCPBServer(job_output)
+    try:
+        with TCProtobufClient(*server.address) as client:
+            results = client.compute_partial(atomic_input)
+            energy = results.field("energy")
+            ci_vectors = results.field("ci_vec_re")
+            stages = []
+            for frame in results:
+                stages.append(frame.stage)
+                if frame.stage == ENERGIES:
+                    # Available before the job completes
+                    assert energy.done() and not ci_vectors.done()
+            result = results.result()
+    finally:
+        server.close()
+
+    assert server.job_inputs[0].partial_outputs
+    assert stages == [ENERGIES, GRADIENTS, FINAL]
+    # Frames keep only the fields of their stage
+    first = results.frames[0]
+    assert first.job_output.stage == ENERGIES
+    assert not first.holds("gradient") and not first.holds("ci_vec_re")
+    assert np.array_equal(energy.result(), job_output.energy)
+    assert ci_vectors.done()
+    assert list(results.job_output.gradient) == list(job_output.gradient)
+    assert result.return_result == job_output.energy[0]
+
+
+def test_submit_job_merges_partial_outputs(atomic_input, job_output):
+    job_output = _with_gradient(job_output)
+    job_input = atomic_input_to_job_input(atomic_input)
+    job_input.partial_outputs = True
+    server = FakeTCPBServer(job_output)
+    try:
+        with TCProtobufClient(*server.address) as client:
+            output = client.collect(client.submit_job(job_input))
+    finally:
+        server.close()
+
+    assert list(output.energy) == list(job_output.energy)
+    assert list(output.gradient) == list(job_output.gradient)
+    assert output.stage == FINAL
+
+
+def test_partial_field_futures_from_other_threads(atomic_input, job_output):
+    job_output = _with_gradient(job_output)
+    server = FakeTCPBServer(job_output, working_polls=20)
+    names = [field.name for field in pb.JobOutput.DESCRIPTOR.fields]
+    futures = []
+    try:
+        with TCProtobufClient(*server.address) as client:
+            results = client.compute_partial(atomic_input)
+
+            def ask():
+                # Ask for every field, in turn, while the job streams in
+                for name in names * 3:
+                    futures.append(results.field(name))
+
+            threads = [threading.Thread(target=ask) for _ in range(4)]
+            for thread in threads:
+                thread.start()
+            results.result()
+            for thread in threads:
+                thread.join()
+    finally:
+        server.close()
+
+    assert len(futures) == 4 * 3 * len(names)
+    assert all(future.done() and future.exception() is None for future in futures)
+    assert np.array_equal(results.field("gradient").result(), job_output.gradient)
@@ -0,0 +1,111 @@
+import pytest
+from google.protobuf.message import DecodeError
+from qcelemental.models.results import AtomicResult
+
+from tcpb.exceptions import ServerError, TCPBError
+from tcpb.pool import DOWN, IDLE, TCPBPool
+
+from .conftest import FakeTCPBServer
+
+
+def test_pool_dispatches_across_servers(atomic_input, job_output):
+    servers = [FakeTCPBServer(job_output) for _ in range(2)]
+    with TCPBPool([server.address for server in servers]) as pool:
+        futures = [pool.submit(atomic_input.copy(deep=True)) for _ in range(6)]
+        results = [future.result(timeout=30) for future in futures]
+        states = pool.server_states()
+
+    assert all(isinstance(result, AtomicResult) for result in results)
+    assert sum(len(server.job_inputs) for server in servers) == 6
+    assert set(states.values()) == {IDLE}
+
+
+def test_pool_retries_busy_server(atomic_input, job_output):
+    server = FakeTCPBServer(job_output, busy_replies=3)
+    with TCPBPool([server.address]) as pool:
+        result = pool.compute(atomic_input)
+
+    assert result.return_result == job_output.energy[0]
+    assert len(server.job_inputs) == 1
+
+
+def test_pool_removes_failed_server(atomic_input, job_output):
+    server = FakeTCPBServer(job_output)
+    # Nothing listens on the closed server's port
+    dead = FakeTCPBServer(job_output)
+    dead.close()
+    with TCPBPool([dead.address, server.address]) as pool:
+        result = pool.compute(atomic_input)
+        states = pool.server_states()
+
+    assert isinstance(result, AtomicResult)
+    assert states[dead.address] == DOWN
+    assert states[server.address] == IDLE
+
+
+def test_pool_reschedules_job_on_malformed_output(atomic_input, job_output):
+    broken = FakeTCPBServer(job_output, malformed_outputs=1)
+    server = FakeTCPBServer(job_output)
+    with TCPBPool([broken.address, server.address]) as pool:
+        result = pool.submit(atomic_input).result(timeout=30)
+        states = pool.server_states()
+
+    assert isinstance(result, AtomicResult)
+    assert len(broken.job_inputs) + len(server.job_inputs) >= 1
+    if broken.job_inputs:
+        assert states[broken.address] == DOWN
+
+
+def test_pool_fails_job_on_malformed_output(atomic_input, job_output):
+    broken = FakeTCPBServer(job_output, malformed_outputs=1)
+    with TCPBPool([broken.address]) as pool:
+        future = pool.submit(atomic_input)
+        with pytest.raises(DecodeError):
+            future.result(timeout=30)
+        states = pool.server_states()
+
+    assert len(broken.job_inputs) == 1
+    assert states[broken.address] == DOWN
+
+
+def test_pool_all_servers_down(atomic_input, job_output):
+    dead = FakeTCPBServer(job_output)
+    dead.close()
+    with TCPBPool([dead.address]) as pool:
+        with pytest.raises((ServerError, TCPBError)):
+            pool.compute(atomic_input)
+
+
+def test_pool_as_completed_returns_indices(atomic_input, job_output):
+    servers = [FakeTCPBServer(job_output) for _ in range(2)]
+    inputs = [atomic_input.copy(deep=True) for _ in range(5)]
+    with TCPBPool([server.address for server in servers]) as pool:
+        completed = list(pool.as_completed(inputs))
+
+    assert sorted(index for index, _ in completed) == list(range(5))
+    assert all(isinstance(result, AtomicResult) for _, result in completed)
+
+
+def test_pool_compute_many_preserves_order(atomic_input, job_output):
+    server = FakeTCPBServer(job_output)
+    inputs = [atomic_input.copy(deep=True) for _ in range(3)]
+    with TCPBPool([server.address]) as pool:
+        results = pool.compute_many(inputs)
+
+    assert len(results) == 3
+    assert len(server.job_inputs) == 3
+
+
+def test_pool_failure_log_does_not_read_logfile(job_output, monkeypatch, caplog):
+    def read_logfile(self):
+        raise AssertionError("Logfile read while removing a server")
+
+    monkeypatch.setattr(ServerError, "logfile_tail", read_logfile)
+    server = FakeTCPBServer(job_output)
+    with TCPBPool([server.address]) as pool:
+        worker = pool._workers[0]
+        pool._server_failed(worker, None, ServerError("Connection lost", worker.client))
+        states = pool.server_states()
+
+    assert states[server.address] == DOWN
+    assert "Connection lost" in caplog.text
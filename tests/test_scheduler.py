@@ -0,0 +1,122 @@
+import queue
+from types import SimpleNamespace
+
+import pytest
+
+from tcpb import terachem_server_pb2 as pb
+from tcpb.pool import TCPBPool
+from tcpb.scheduler import (
+    LONGEST_FIRST,
+    SHORTEST_FIRST,
+    JobScheduler,
+    estimate_cost,
+)
+from tcpb.utils import atomic_input_to_job_input
+
+from .conftest import FakeTCPBServer
+
+
+def _job(cost, priority=0, affinity=None):
+    return SimpleNamespace(
+        job_input_msg=None,
+        cost=cost,
+        priority=priority,
+        affinity=affinity,
+        sort_key=None,
+        queued_at=None,
+    )
+
+
+def test_estimate_cost_orders_jobs(atomic_input):
+    small = atomic_input_to_job_input(atomic_input.copy(deep=True))
+    larger_basis = pb.JobInput()
+    larger_basis.CopyFrom(small)
+    larger_basis.basis = "cc-pvtz"
+    gradient = pb.JobInput()
+    gradient.CopyFrom(small)
+    gradient.run = pb.JobInput.RunType.GRADIENT
+    tddft = pb.JobInput()
+    tddft.CopyFrom(gradient)
+    tddft.user_options.extend(["cis", "yes", "cisnumstates", "3"])
+
+    costs = [estimate_cost(j) for j in (small, larger_basis, gradient, tddft)]
+    assert costs[0] < costs[1]
+    assert costs[0] < costs[2] < costs[3]
+
+
+@pytest.mark.parametrize(
+    "policy,order", [("fifo", [9, 5, 1, 3]), (SHORTEST_FIRST, [9, 1, 3, 5])]
+)
+def test_scheduler_orders_by_priority_and_policy(policy, order):
+    scheduler = JobScheduler(policy)
+    for job in (_job(5), _job(1), _job(3), _job(9, priority=1)):
+        scheduler.put(job)
+
+    worker = object()
+    assert [scheduler.get_nowait(worker).cost for _ in range(4)] == order
+    with pytest.raises(queue.Empty):
+        scheduler.get_nowait(worker)
+
+
+def test_scheduler_large_queue_in_order():
+    scheduler = JobScheduler(SHORTEST_FIRST)
+    costs = [(7 * k) % 1009 for k in range(5000)]
+    for k, cost in enumerate(costs):
+        scheduler.put(_job(cost, affinity=None if k % 3 else k % 5))
+    assert len(scheduler) == len(costs)
+
+    worker = object()
+    assert [scheduler.get_nowait(worker).cost for _ in costs] == sorted(costs)
+    assert len(scheduler) == 0
+
+
+def test_scheduler_keeps_affinity_until_stolen():
+    scheduler = JobScheduler(steal_after=0.05)
+    first, second = object(), object()
+    scheduler.put(_job(1, affinity="trajectory"))
+    scheduler.get(first)
+
+    scheduler.put(_job(2, affinity="trajectory"))
+    with pytest.raises(queue.Empty):
+        scheduler.get_nowait(second)
+    assert scheduler.get(second).cost == 2
+
+    scheduler.put(_job(3, affinity="trajectory"))
+    scheduler.forget(second)
+    assert scheduler.get_nowait(first).cost == 3
+
+
+def test_scheduler_forgets_least_recently_used_affinity_keys():
+    scheduler = JobScheduler(max_affinity_keys=2)
+    first, second = object(), object()
+    for key in ("a", "b", "c"):
+        scheduler.put(_job(1, affinity=key))
+        scheduler.get(first)
+    assert list(scheduler._affinity) == ["b", "c"]
+
+    # "a" is forgotten, so any server may run its next job
+    scheduler.put(_job(2, affinity="a"))
+    assert scheduler.get_nowait(second).cost == 2
+    scheduler.put(_job(3, affinity="c"))
+    with pytest.raises(queue.Empty):
+        scheduler.get_nowait(second)
+
+
+def test_scheduler_rejects_unknown_policy():
+    with pytest.raises(ValueError):
+        JobScheduler("random")
+
+
+def test_pool_runs_trajectory_on_one_server(atomic_input, job_output):
+    servers = [FakeTCPBServer(job_output) for _ in range(2)]
+    with TCPBPool(
+        [server.address for server in servers], scheduler=LONGEST_FIRST
+    ) as pool:
+        futures = [
+            pool.submit(atomic_input.copy(deep=True), affinity="trajectory")
+            for _ in range(4)
+        ]
+        results = [future.result(timeout=30) for future in futures]
+
+    assert all(result.success for result in results)
+    assert sorted(len(server.job_inputs) for server in servers) == [0, 4]
@@ -0,0 +1,61 @@
+import numpy as np
+import pytest
+
+from tcpb import serial_utils
+from tcpb.serial_utils import (
+    read_ci_vector,
+    read_orbfile,
+    write_ci_vector,
+    write_orbfile,
+)
+
+
+@pytest.mark.parametrize("mmap_mode", [None, "r"])
+def test_orbfile_roundtrip_column_major(tmp_path, mmap_mode):
+    orbs = np.arange(12, dtype=np.float64).reshape(3, 4)
+    orbfile = str(tmp_path / "c0")
+    write_orbfile(orbs, orbfile)
+
+    # Stored column-major on disk
+    assert np.array_equal(np.fromfile(orbfile), orbs.T.flatten())
+
+    read = read_orbfile(orbfile, 4, 3, mmap_mode=mmap_mode)
+    assert np.array_equal(read, orbs)
+    if mmap_mode is not None:
+        assert isinstance(read.base, np.memmap)
+
+
+@pytest.mark.parametrize("mmap_mode", [None, "r"])
+def test_ci_vector_roundtrip(tmp_path, mmap_mode):
+    ci_vector = np.linspace(-1.0, 1.0, 20).reshape(4, 5)
+    cvecfile = str(tmp_path / "CIvecs.Singlet.dat")
+    write_ci_vector(ci_vector, cvecfile)
+
+    read = read_ci_vector(cvecfile, 4, 5, mmap_mode=mmap_mode)
+    assert np.array_equal(read, ci_vector)
+
+
+def test_write_ci_vector_chunks_non_contiguous(tmp_path, monkeypatch):
+    # Force several chunks for a transposed float32 view
+    monkeypatch.setattr(serial_utils, "_WRITE_CHUNK_BYTES", 16)
+    ci_vector = np.arange(30, dtype=np.float32).reshape(5, 6).T
+    cvecfile = str(tmp_path / "cvec")
+    write_ci_vector(ci_vector, cvecfile)
+
+    assert np.array_equal(read_ci_vector(cvecfile, 6, 5), ci_vector)
+
+
+def test_write_ci_vector_accepts_buffers(tmp_path):
+    buffer = memoryview(np.arange(6, dtype=np.float64).tobytes()).cast("d")
+    cvecfile = str(tmp_path / "cvec")
+    write_ci_vector(buffer, cvecfile)
+
+    assert np.array_equal(read_ci_vector(cvecfile, 2, 3).flatten(), np.arange(6))
+
+
+@pytest.mark.parametrize("empty", [[], np.empty((0, 3), dtype=np.float32)])
+def test_write_ci_vector_empty(tmp_path, empty):
+    cvecfile = tmp_path / "cvec"
+    write_ci_vector(empty, str(cvecfile))
+
+    assert cvecfile.read_bytes() == b""
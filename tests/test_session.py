@@ -0,0 +1,43 @@
+import numpy as np
+
+from tcpb import TCProtobufClient
+from tcpb import terachem_server_pb2 as pb
+from tcpb.utils import atomic_input_to_job_input
+
+from .conftest import FakeTCPBServer
+
+
+def test_session_job_input_matches_full_conversion(atomic_input):
+    session = TCProtobufClient("localhost", 11111).session(atomic_input)
+    xyz = np.arange(9.0).reshape(3, 3)
+
+    job_input = pb.JobInput()
+    job_input.ParseFromString(
+        session.job_input_bytes(xyz, pb.JobInput.RunType.GRADIENT)
+    )
+
+    expected = atomic_input_to_job_input(atomic_input.copy(deep=True))
+    del expected.mol.xyz[:]
+    expected.mol.xyz.extend(xyz.ravel())
+    expected.run = pb.JobInput.RunType.GRADIENT
+    assert job_input == expected
+
+
+def test_session_gradients_reuse_previous_orbitals(atomic_input, job_output):
+    job_output.gradient.extend(np.linspace(-0.1, 0.1, 9))
+    server = FakeTCPBServer(job_output)
+    try:
+        with TCProtobufClient(*server.address) as client:
+            session = client.session(atomic_input)
+            gradients = [session.gradient(np.full(9, r)) for r in (1.0, 1.1)]
+    finally:
+        server.close()
+
+    assert gradients[0].shape == (3, 3)
+    assert np.array_equal(gradients[1].ravel(), np.linspace(-0.1, 0.1, 9))
+    first, second = server.job_inputs
+    assert list(second.mol.xyz) == [1.1] * 9
+    assert second.run == pb.JobInput.RunType.GRADIENT
+    assert "guess" not in first.user_options
+    options = list(second.user_options)
+    assert options[options.index("guess") + 1] == job_output.orb1afile
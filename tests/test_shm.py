@@ -0,0 +1,63 @@
+import pytest
+
+from tcpb import TCProtobufClient
+from tcpb import terachem_server_pb2 as pb
+from tcpb.shm import SharedMemoryChannel, shared_memory
+
+from .conftest import FakeTCPBServer
+
+pytestmark = pytest.mark.skipif(
+    shared_memory is None, reason="Shared memory requires Python 3.8"
+)
+
+
+def test_channel_round_trip_and_fallback():
+    client = SharedMemoryChannel(size=64 + 2 * 1024, threshold=100)
+    server = SharedMemoryChannel(size=client.size, threshold=100, name=client.name)
+    try:
+        header = b"\x00\x00\x00\x03\x00\x00\x02\x00"
+        body = bytes(range(256)) * 2
+        # Small bodies stay on the socket
+        assert client.place(header, body[:50]) == (header, body[:50])
+
+        flagged, descriptor = client.place(header, body)
+        assert len(descriptor) == 16 and flagged != header
+        # The ring is full until the server is done with the first body
+        assert client.place(header, body)[0] != header
+        assert client.place(header, body) == (header, body)
+        assert bytes(server.receive(descriptor)) == body
+        server.release()
+        assert client.place(header, body)[0] != header
+
+        _, descriptor = server.place(header, body[::-1])
+        assert bytes(client.receive(descriptor)) == body[::-1]
+        client.release()
+    finally:
+        server.close()
+        client.close()
+
+
+def test_compute_over_shared_memory(atomic_input, job_output):
+    server = FakeTCPBServer(job_output, shared_memory=True)
+    try:
+        with TCProtobufClient(*server.address, shared_memory=1024 * 1024) as client:
+            assert client.shm is not None
+            client.shm.threshold = 0
+            result = client.compute(atomic_input)
+            assert client.shm.bodies_sent > 0
+            assert client.shm.bodies_received > 0
+    finally:
+        server.close()
+
+    assert result.success
+    assert server.job_inputs[0].run == pb.JobInput.RunType.ENERGY
+
+
+def test_server_without_shared_memory(atomic_input, job_output):
+    server = FakeTCPBServer(job_output)
+    try:
+        with TCProtobufClient(*server.address, shared_memory=True) as client:
+            assert client.shm is None
+            assert client.compute(atomic_input).success
+    finally:
+        server.close()
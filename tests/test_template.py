@@ -0,0 +1,73 @@
+import numpy as np
+import pytest
+
+from tcpb import TCProtobufClient as TCPBClient
+from tcpb import terachem_server_pb2 as pb
+from tcpb.template import JobInputTemplate, TemplateCache, template_key
+from tcpb.utils import atomic_input_to_job_input
+
+OPTIONS = {
+    "atoms": ["H", "H"],
+    "charge": 0,
+    "spinmult": 1,
+    "closed_shell": True,
+    "restricted": True,
+    "method": "pbe0",
+    "basis": "sto-3g",
+    "convthre": 1e-6,
+}
+GEOM = [0.0, 0.0, 0.0, 0.0, 0.0, 1.4]
+
+
+def _process_kwargs_job_input(jobType, geom, **kwargs):
+    job_input = pb.JobInput()
+    job_input.run = pb.JobInput.RunType.Value(jobType.upper())
+    job_input.mol.xyz.extend(geom)
+    job_input.mol.units = pb.Mol.UnitType.BOHR
+    TCPBClient._process_kwargs(job_input, **kwargs)
+    return job_input
+
+
+def test_keyword_jobs_match_process_kwargs():
+    assert TCPBClient._create_job_input_msg(
+        "energy", GEOM, **OPTIONS
+    ) == _process_kwargs_job_input("energy", GEOM, **OPTIONS)
+
+    geom2 = np.array(GEOM).reshape(2, 3) + 0.1
+    assert TCPBClient._create_job_input_msg(
+        "ci_vec_overlap", GEOM, geom2=geom2, **OPTIONS
+    ) == _process_kwargs_job_input("ci_vec_overlap", GEOM, geom2=geom2, **OPTIONS)
+
+    with pytest.raises(ValueError):
+        TCPBClient._create_job_input_msg("energy", GEOM, geom2=GEOM[:3], **OPTIONS)
+
+
+def test_job_templates_are_cached_by_arguments():
+    template = TCPBClient.job_template("energy", **OPTIONS)
+    assert TCPBClient.job_template("energy", geom=GEOM, **OPTIONS) is template
+    assert TCPBClient.job_template("gradient", **OPTIONS) is not template
+    assert TCPBClient.job_template("energy", **{**OPTIONS, "charge": 1}) is not template
+
+    # Arrays are not compared, so their templates are built every time
+    assert template_key(cvec1=np.zeros(4)) is None
+    cache = TemplateCache(maxsize=2)
+    for key in ("a", "b", "c", "a"):
+        cache.get(key, lambda key=key: key)
+    assert list(cache._templates) == ["c", "a"]
+
+
+def test_template_from_atomic_input(atomic_input):
+    template = JobInputTemplate.from_atomic_input(atomic_input)
+    geom = atomic_input.molecule.geometry
+    assert template.job_input(geom) == atomic_input_to_job_input(
+        atomic_input.copy(deep=True)
+    )
+
+    # Jobs do not leak their fields into the template
+    gradient = template.job_input(geom + 0.1, guess="scr/c0", run="gradient")
+    assert gradient.run == pb.JobInput.RunType.GRADIENT
+    assert list(gradient.user_options[-2:]) == ["guess", "scr/c0"]
+    assert template.job_input(geom, guess="c0").user_options[-1] == "c0"
+    assert not template.base.mol.xyz
+    assert "guess" not in template.base.user_options
+    assert template.base.run == pb.JobInput.RunType.ENERGY
@@ -0,0 +1,122 @@
+import threading
+from functools import partial
+
+from tcpb import TCProtobufClient
+from tcpb import terachem_server_pb2 as pb
+from tcpb import tcpb as tcpb_module
+from tcpb.framing import serialize_msg, split_msg_type
+from tcpb.instrument import RECEIVED, SENT
+from tcpb.pool import TCPBPool
+from tcpb.trace import ReplayTransport, TraceReader, TraceStore
+
+from .conftest import FakeTCPBServer
+
+
+def test_trace_store_records_and_replays_jobs(atomic_input, fake_server, tmp_path):
+    with TCProtobufClient(*fake_server.address, trace=tmp_path) as client:
+        recorded = client.compute(atomic_input)
+
+    with TraceReader(tmp_path) as received, TraceReader(tmp_path, SENT) as sent:
+        (recorded_output,) = received.messages(pb.JOBOUTPUT)
+        assert recorded_output.energy[0] == recorded.return_result
+        assert len(sent.indices(pb.JOBINPUT)) == 1
+        assert len(received.indices(pb.STATUS)) == len(sent.indices(pb.STATUS)) + 1
+
+    replay = ReplayTransport(tmp_path)
+    with TCProtobufClient("localhost", 11111, replay=replay) as client:
+        assert client.is_available()
+        results = [client.compute(atomic_input) for _ in range(3)]
+
+    assert replay.jobs_served == 3
+    assert all(r.return_result == recorded.return_result for r in results)
+    assert [r.extras["qcvars"]["server_job_id"] for r in results] == [1, 2, 3]
+
+
+def test_trace_store_decodes_compressed_sent_frames(
+    atomic_input, job_output, tmp_path, monkeypatch
+):
+    # Compress every body the client sends, however small
+    monkeypatch.setattr(
+        tcpb_module, "serialize_msg", partial(serialize_msg, threshold=0)
+    )
+    server = FakeTCPBServer(job_output, compression=pb.Status.ZLIB)
+    try:
+        with TCProtobufClient(
+            *server.address, compression=["zlib"], trace=tmp_path
+        ) as client:
+            client.compute(atomic_input)
+    finally:
+        server.close()
+
+    with TraceReader(tmp_path, SENT) as sent:
+        (index,) = sent.indices(pb.JOBINPUT)
+        assert split_msg_type(int(sent.index[index]["msg_type"]))[1]
+        (job_input,) = sent.messages(pb.JOBINPUT)
+    assert job_input == server.job_inputs[0]
+
+
+def test_pool_clients_share_a_trace_directory(atomic_input, job_output, tmp_path):
+    servers = [FakeTCPBServer(job_output) for _ in range(3)]
+    try:
+        with TCPBPool([server.address for server in servers], trace=tmp_path) as pool:
+            results = pool.compute_many(
+                [atomic_input.copy(deep=True) for _ in range(9)]
+            )
+    finally:
+        for server in servers:
+            server.close()
+
+    assert len(results) == 9
+    # Each client wrote its own segments; none truncated those of another
+    busy = sum(1 for server in servers if server.job_inputs)
+    assert len(list(tmp_path.glob("received-*.bin"))) >= busy
+    with TraceReader(tmp_path) as received, TraceReader(tmp_path, SENT) as sent:
+        outputs = list(received.messages(pb.JOBOUTPUT))
+        assert len(outputs) == 9
+        assert all(output.energy == job_output.energy for output in outputs)
+        assert len(list(sent.messages(pb.JOBINPUT))) == 9
+
+
+def test_trace_store_shared_by_threads(job_output, tmp_path):
+    header, body = serialize_msg(pb.JOBOUTPUT, job_output)
+    store = TraceStore(tmp_path)
+
+    def write():
+        for _ in range(50):
+            store.write(RECEIVED, header, body)
+
+    threads = [threading.Thread(target=write) for _ in range(4)]
+    for thread in threads:
+        thread.start()
+    for thread in threads:
+        thread.join()
+    store.close()
+
+    with TraceReader(tmp_path) as reader:
+        assert len(reader) == 200
+        assert all(message == job_output for message in reader.messages())
+
+
+def test_trace_store_rotates_segments(job_output, tmp_path):
+    header, body = serialize_msg(pb.JOBOUTPUT, job_output)
+    store = TraceStore(tmp_path, max_segment_bytes=len(header + body), max_segments=2)
+    for _ in range(5):
+        store.write(RECEIVED, header, body)
+    store.close()
+
+    assert len(list(tmp_path.glob("received-*.bin"))) == 2
+    assert len(list(tmp_path.glob("received-*.idx"))) == 2
+    with TraceReader(tmp_path) as reader:
+        assert len(reader) == 2
+        assert list(reader.messages()) == [job_output, job_output]
+
+
+def test_reader_scans_legacy_trace_files(job_output, tmp_path):
+    trace_file = tmp_path / "client_recv.bin"
+    with open(trace_file, "wb") as f:
+        f.write(b"".join(serialize_msg(pb.STATUS, pb.Status(completed=True))))
+        f.write(b"".join(serialize_msg(pb.JOBOUTPUT, job_output)))
+
+    with TraceReader(trace_file) as reader:
+        assert list(reader.msg_types) == [pb.STATUS, pb.JOBOUTPUT]
+        assert next(reader.messages(pb.JOBOUTPUT)) == job_output
@@ -2,15 +2,20 @@ from pathlib import Path
 from typing import List
 
 import numpy as np
+import pytest
 import qcelemental as qcel
+from google.protobuf.json_format import MessageToDict
 from qcelemental.models import AtomicInput, Molecule
 from qcelemental.models.results import AtomicResult
 
+from tcpb.exceptions import TCPBError
 from tcpb.tcpb import TCProtobufClient
 from tcpb import terachem_server_pb2 as pb
 from tcpb.utils import (
+    JobOutputArrays,
     atomic_input_to_job_input,
     job_output_to_atomic_result,
+    job_output_to_results_dict,
     mol_to_molecule,
 )
 
@@ -110,6 +115,137 @@ def test_job_output_to_atomic_result_maintains_extras(atomic_input, job_output):
     assert "mytag" in atomic_result.extras
 
 
+def test_job_output_to_atomic_result_qcvars_match_message_to_dict(
+    atomic_input, job_output
+):
+    """qcvars are converted field by field but must match a full MessageToDict"""
+    atomic_result = job_output_to_atomic_result(
+        atomic_input=atomic_input, job_output=job_output
+    )
+    jo_dict = MessageToDict(job_output, preserving_proto_field_name=True)
+    qcvars = atomic_result.extras["qcvars"]
+
+    assert qcvars["excited_state_energies"] == jo_dict.get("energy")
+    for key in ["charges", "job_dir", "job_scr_dir", "server_job_id", "orb1bfile"]:
+        assert qcvars[key] == jo_dict.get(key)
+
+
+def test_job_output_to_atomic_result_raw_arrays(atomic_input, job_output):
+    atomic_result = job_output_to_atomic_result(
+        atomic_input=atomic_input, job_output=job_output, raw_arrays=True
+    )
+    qcvars = atomic_result.extras["qcvars"]
+    arrays = atomic_result.extras["job_output_arrays"]
+
+    assert isinstance(qcvars["charges"], np.ndarray)
+    assert qcvars["charges"].dtype == np.float64
+    assert list(qcvars["charges"]) == list(job_output.charges)
+    assert isinstance(arrays, JobOutputArrays)
+    assert "energy" in list(arrays)
+    assert arrays["energy"] is arrays["energy"]
+
+
+def test_job_output_arrays_keep_field_precision(job_output):
+    job_output.compressed_mo_vector.extend([0.5, 0.25])
+    arrays = JobOutputArrays(job_output)
+
+    assert arrays["compressed_mo_vector"].dtype == np.float32
+    assert arrays["cas_energy_states"].dtype == np.int32
+    assert "job_dir" not in arrays
+
+
+def test_float32_fields_keep_their_precision(atomic_input, job_output):
+    atomic_input.keywords["float32"] = True
+    assert atomic_input_to_job_input(atomic_input.copy(deep=True)).return_float32
+
+    natoms = len(job_output.mol.atoms)
+    del job_output.bond_order[:]
+    job_output.bond_order_f32.extend(np.eye(natoms).flatten())
+    job_output.ci_vec_re_f32.extend(np.linspace(0.0, 1.0, 2000))
+
+    arrays = JobOutputArrays(job_output)
+    assert arrays["ci_vec_re"].dtype == np.float32
+    assert arrays["ci_vec_re"] is arrays["ci_vec_re_f32"]
+
+    atomic_result = job_output_to_atomic_result(
+        atomic_input=atomic_input, job_output=job_output, raw_arrays=True
+    )
+    bond_order = atomic_result.extras["qcvars"]["bond_order"]
+    assert bond_order.dtype == np.float32
+    assert np.array_equal(bond_order, np.eye(natoms).flatten())
+
+    results = job_output_to_results_dict(job_output)
+    assert results["bond_order"].dtype == np.float32
+    assert results["bond_order"].shape == (natoms, natoms)
+
+
+def test_results_dict_splits_cis_dipoles(job_output):
+    del job_output.energy[:]
+    job_output.energy.extend([-1.0, -0.9, -0.8, -0.7])
+    job_output.cis_states = 2
+    job_output.cis_unrelaxed_dipoles.extend(np.arange(8.0))
+    job_output.cis_transition_dipoles.extend(np.arange(12.0) + 100)
+
+    results = job_output_to_results_dict(job_output)
+
+    assert list(results["energy"]) == [-1.0, -0.9, -0.8]
+    assert [list(d) for d in results["cis_unrelaxed_dipoles"]] == [
+        [0.0, 1.0, 2.0],
+        [4.0, 5.0, 6.0],
+    ]
+    assert len(results["cis_transition_dipoles"]) == 3
+    assert list(results["cis_transition_dipoles"][2]) == [108.0, 109.0, 110.0]
+    assert "cis_relaxed_dipoles" not in results
+    assert list(results["charges"]) == list(job_output.charges)
+
+
+def test_results_dict_rejects_truncated_cis_dipoles(job_output):
+    job_output.cis_states = 2
+    job_output.cis_unrelaxed_dipoles.extend(np.arange(7.0))
+
+    with pytest.raises(TCPBError):
+        job_output_to_results_dict(job_output)
+
+
+def test_atomic_input_to_job_input_molden_path_not_sent(atomic_input):
+    atomic_input.keywords["molden"] = Path("/some/client/path.molden")
+    job_input = atomic_input_to_job_input(atomic_input)
+
+    index = list(job_input.user_options).index("molden")
+    assert job_input.user_options[index + 1] == "True"
+
+
+def test_atomic_input_to_job_input_molden_string_forwarded(atomic_input):
+    atomic_input.keywords["molden"] = "no"
+    job_input = atomic_input_to_job_input(atomic_input)
+
+    index = list(job_input.user_options).index("molden")
+    assert job_input.user_options[index + 1] == "no"
+
+
+def test_job_output_to_atomic_result_molden_path(atomic_input, job_output, tmp_path):
+    molden_path = tmp_path / "frame.molden"
+    atomic_input.keywords["molden"] = molden_path
+    atomic_result = job_output_to_atomic_result(
+        atomic_input=atomic_input, job_output=job_output
+    )
+
+    assert atomic_result.extras["molden"] == str(molden_path)
+    assert molden_path.read_text().startswith("[Molden Format]")
+
+
+def test_job_output_to_atomic_result_molden_yes(
+    atomic_input, job_output, tmp_path, monkeypatch
+):
+    monkeypatch.chdir(tmp_path)
+    atomic_input.keywords["molden"] = "yes"
+    atomic_result = job_output_to_atomic_result(
+        atomic_input=atomic_input, job_output=job_output
+    )
+
+    assert atomic_result.extras["molden"].startswith("[Molden Format]")
+    assert not (tmp_path / "yes").exists()
+
 
 def test_mol_to_molecule_bohr():
     with open(Path(__file__).parent / "test_data" / "water_bohr.pb", "rb") as f:
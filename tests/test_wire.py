@@ -0,0 +1,64 @@
+import numpy as np
+
+from tcpb import terachem_server_pb2 as pb
+from tcpb.utils import JobOutputArrays
+from tcpb.wire import (
+    encode_length_delimited,
+    encode_packed_array,
+    encode_varint,
+    encode_varint_field,
+    packed_field_arrays,
+)
+
+
+def test_packed_field_arrays_views_serialized_message(job_output):
+    job_output.compressed_mo_vector.extend([0.5, 0.25, 0.125])
+    msg_str = bytearray(job_output.SerializeToString())
+
+    arrays = packed_field_arrays(pb.JobOutput.DESCRIPTOR, msg_str)
+
+    assert list(arrays["energy"]) == list(job_output.energy)
+    assert list(arrays["charges"]) == list(job_output.charges)
+    assert arrays["compressed_mo_vector"].dtype == np.float32
+    assert list(arrays["compressed_mo_vector"]) == [0.5, 0.25, 0.125]
+    # Varint fields (int32) and empty fields are not views
+    assert "cas_energy_states" not in arrays
+    assert "nacme" not in arrays
+
+    arrays["energy"][0] = 42.0
+    parsed = pb.JobOutput()
+    parsed.ParseFromString(bytes(msg_str))
+    assert parsed.energy[0] == 42.0
+
+
+def test_packed_field_arrays_skips_unpacked_fields():
+    # Field 2 (energy) written unpacked as two fixed64 values
+    msg_str = b"\x11" + np.float64(1.5).tobytes() + b"\x11" + np.float64(2.5).tobytes()
+
+    assert packed_field_arrays(pb.JobOutput.DESCRIPTOR, msg_str) == {}
+
+
+def test_job_output_arrays_large_fields_match_fields(job_output):
+    job_output.ci_vec_re.extend(np.linspace(0.0, 1.0, 5000))
+    arrays = JobOutputArrays(job_output)
+
+    assert arrays["ci_vec_re"].dtype == np.float64
+    assert np.array_equal(arrays["ci_vec_re"], np.linspace(0.0, 1.0, 5000))
+    assert list(arrays["energy"]) == list(job_output.energy)
+
+
+def test_appended_fields_merge_into_message():
+    mol = pb.Mol(atoms=["H", "H"], multiplicity=1)
+    msg_str = (
+        mol.SerializeToString()
+        + encode_packed_array(pb.Mol.XYZ_FIELD_NUMBER, [0, 0, 0, 0, 0, 1.4], "<f8")
+        + encode_length_delimited(pb.Mol.ATOMS_FIELD_NUMBER, b"He")
+        + encode_varint_field(pb.Mol.MULTIPLICITY_FIELD_NUMBER, 300)
+    )
+
+    merged = pb.Mol()
+    merged.ParseFromString(msg_str)
+    assert list(merged.atoms) == ["H", "H", "He"]
+    assert list(merged.xyz) == [0, 0, 0, 0, 0, 1.4]
+    assert merged.multiplicity == 300
+    assert encode_varint(300) == b"\xac\x02"